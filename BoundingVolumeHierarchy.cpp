@@ -0,0 +1,573 @@
+///////////////////////////////////////////////////////////////////////////////
+// boundingvolumehierarchy.cpp
+// ============
+// bounding volume hierarchy over the world-space boxes of the scene objects
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#include "BoundingVolumeHierarchy.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <utility>
+
+static_assert(sizeof(BoundingVolumeHierarchy::BVH_NODE) == 32, "BVH nodes must stay 32 bytes");
+
+namespace
+{
+	const uint32_t NO_NODE = 0xffffffffu;
+	// centroid bins evaluated per axis when searching for a split
+	const int SAH_BINS = 12;
+	// leaves up to this size are kept when splitting does not pay off
+	const uint32_t MAX_LEAF_OBJECTS = 4;
+	// entries in the fixed traversal stacks of the queries
+	const int TRAVERSAL_STACK_SIZE = 64;
+	// nodes this deep stay leaves, a depth first traversal holds at
+	// most one pending sibling per level so the stacks cannot overflow
+	const uint32_t MAX_DEPTH = 48;
+	static_assert(MAX_DEPTH + 2 <= TRAVERSAL_STACK_SIZE, "BVH depth must fit the traversal stacks");
+
+	float SurfaceArea(const glm::vec3& boxMin, const glm::vec3& boxMax)
+	{
+		glm::vec3 size = boxMax - boxMin;
+		return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+	}
+
+	// 0 when outside a plane, 1 when crossing a plane, 2 when fully inside
+	int ClassifyBox(const glm::vec4 planes[6], const glm::vec3& boxMin, const glm::vec3& boxMax)
+	{
+		glm::vec3 center = (boxMin + boxMax) * 0.5f;
+		glm::vec3 extents = (boxMax - boxMin) * 0.5f;
+		int result = 2;
+		for (int i = 0; i < 6; ++i)
+		{
+			glm::vec3 normal(planes[i]);
+			float distance = glm::dot(normal, center) + planes[i].w;
+			float radius = glm::dot(glm::abs(normal), extents);
+			if (distance + radius < 0.0f)
+			{
+				return 0;
+			}
+			if (distance - radius < 0.0f)
+			{
+				result = 1;
+			}
+		}
+		return result;
+	}
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for building the tree from scratch.
+ ***********************************************************/
+void BoundingVolumeHierarchy::Build(const std::vector<glm::vec3>& boxMins, const std::vector<glm::vec3>& boxMaxs)
+{
+	Clear();
+
+	uint32_t objectCount = static_cast<uint32_t>(std::min(boxMins.size(), boxMaxs.size()));
+	if (objectCount == 0)
+	{
+		return;
+	}
+
+	m_boxMins.assign(boxMins.begin(), boxMins.begin() + objectCount);
+	m_boxMaxs.assign(boxMaxs.begin(), boxMaxs.begin() + objectCount);
+	m_objectIndices.resize(objectCount);
+	for (uint32_t i = 0; i < objectCount; ++i)
+	{
+		m_objectIndices[i] = i;
+	}
+
+	// a binary tree with one object per leaf at most has 2n - 1 nodes
+	m_nodes.reserve(2 * objectCount - 1);
+	m_parents.reserve(2 * objectCount - 1);
+
+	BVH_NODE root;
+	root.leftFirst = 0;
+	root.count = objectCount;
+	m_nodes.push_back(root);
+	m_parents.push_back(NO_NODE);
+	UpdateLeafBounds(0);
+
+	// node index and depth of the nodes left to subdivide
+	std::vector<std::pair<uint32_t, uint32_t>> stack(1, std::make_pair(0u, 0u));
+	while (!stack.empty())
+	{
+		uint32_t nodeIndex = stack.back().first;
+		uint32_t depth = stack.back().second;
+		stack.pop_back();
+
+		Subdivide(nodeIndex, depth);
+		if (m_nodes[nodeIndex].count == 0)
+		{
+			stack.push_back(std::make_pair(m_nodes[nodeIndex].leftFirst, depth + 1));
+			stack.push_back(std::make_pair(m_nodes[nodeIndex].leftFirst + 1, depth + 1));
+		}
+	}
+
+	m_objectLeaves.assign(objectCount, NO_NODE);
+	for (uint32_t nodeIndex = 0; nodeIndex < m_nodes.size(); ++nodeIndex)
+	{
+		const BVH_NODE& node = m_nodes[nodeIndex];
+		for (uint32_t i = 0; i < node.count; ++i)
+		{
+			m_objectLeaves[m_objectIndices[node.leftFirst + i]] = nodeIndex;
+		}
+	}
+	m_leafDirty.assign(m_nodes.size(), 0);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all the objects.
+ ***********************************************************/
+void BoundingVolumeHierarchy::Clear()
+{
+	m_nodes.clear();
+	m_parents.clear();
+	m_objectIndices.clear();
+	m_boxMins.clear();
+	m_boxMaxs.clear();
+	m_objectLeaves.clear();
+	m_dirtyLeaves.clear();
+	m_leafDirty.clear();
+}
+
+/***********************************************************
+ *  UpdateLeafBounds()
+ *
+ *  This method is used for setting the box of a leaf to the
+ *  union of the boxes of its objects.
+ ***********************************************************/
+void BoundingVolumeHierarchy::UpdateLeafBounds(uint32_t nodeIndex)
+{
+	BVH_NODE& node = m_nodes[nodeIndex];
+	node.boundsMin = glm::vec3(FLT_MAX);
+	node.boundsMax = glm::vec3(-FLT_MAX);
+	for (uint32_t i = 0; i < node.count; ++i)
+	{
+		uint32_t objectIndex = m_objectIndices[node.leftFirst + i];
+		node.boundsMin = glm::min(node.boundsMin, m_boxMins[objectIndex]);
+		node.boundsMax = glm::max(node.boundsMax, m_boxMaxs[objectIndex]);
+	}
+}
+
+/***********************************************************
+ *  Subdivide()
+ *
+ *  This method is used for splitting a node in two where the
+ *  surface area heuristic is lowest.  The object centroids
+ *  are sorted into bins along each axis and every bin border
+ *  is evaluated as a split plane.  The node stays a leaf
+ *  when it is small and no split is cheaper than not
+ *  splitting, when its centroids cannot be separated, or
+ *  when it is at the maximum depth.
+ ***********************************************************/
+void BoundingVolumeHierarchy::Subdivide(uint32_t nodeIndex, uint32_t depth)
+{
+	BVH_NODE& node = m_nodes[nodeIndex];
+	if (node.count <= 1 || depth >= MAX_DEPTH)
+	{
+		return;
+	}
+
+	glm::vec3 centroidMin(FLT_MAX);
+	glm::vec3 centroidMax(-FLT_MAX);
+	for (uint32_t i = 0; i < node.count; ++i)
+	{
+		uint32_t objectIndex = m_objectIndices[node.leftFirst + i];
+		glm::vec3 centroid = (m_boxMins[objectIndex] + m_boxMaxs[objectIndex]) * 0.5f;
+		centroidMin = glm::min(centroidMin, centroid);
+		centroidMax = glm::max(centroidMax, centroid);
+	}
+
+	float bestCost = FLT_MAX;
+	int bestAxis = -1;
+	int bestSplit = 0;
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		float extent = centroidMax[axis] - centroidMin[axis];
+		if (extent <= 0.0f)
+		{
+			continue;
+		}
+		float binScale = SAH_BINS / extent;
+
+		uint32_t binCounts[SAH_BINS] = {};
+		glm::vec3 binMins[SAH_BINS];
+		glm::vec3 binMaxs[SAH_BINS];
+		for (int bin = 0; bin < SAH_BINS; ++bin)
+		{
+			binMins[bin] = glm::vec3(FLT_MAX);
+			binMaxs[bin] = glm::vec3(-FLT_MAX);
+		}
+		for (uint32_t i = 0; i < node.count; ++i)
+		{
+			uint32_t objectIndex = m_objectIndices[node.leftFirst + i];
+			float centroid = (m_boxMins[objectIndex][axis] + m_boxMaxs[objectIndex][axis]) * 0.5f;
+			int bin = std::min(SAH_BINS - 1, static_cast<int>((centroid - centroidMin[axis]) * binScale));
+			binCounts[bin]++;
+			binMins[bin] = glm::min(binMins[bin], m_boxMins[objectIndex]);
+			binMaxs[bin] = glm::max(binMaxs[bin], m_boxMaxs[objectIndex]);
+		}
+
+		// areas and counts left of each bin border, then sweep from the right
+		float leftAreas[SAH_BINS - 1];
+		uint32_t leftCounts[SAH_BINS - 1];
+		glm::vec3 sweepMin(FLT_MAX);
+		glm::vec3 sweepMax(-FLT_MAX);
+		uint32_t sweepCount = 0;
+		for (int border = 0; border < SAH_BINS - 1; ++border)
+		{
+			sweepCount += binCounts[border];
+			if (binCounts[border] > 0)
+			{
+				sweepMin = glm::min(sweepMin, binMins[border]);
+				sweepMax = glm::max(sweepMax, binMaxs[border]);
+			}
+			leftCounts[border] = sweepCount;
+			leftAreas[border] = (sweepCount > 0) ? SurfaceArea(sweepMin, sweepMax) : 0.0f;
+		}
+
+		sweepMin = glm::vec3(FLT_MAX);
+		sweepMax = glm::vec3(-FLT_MAX);
+		sweepCount = 0;
+		for (int border = SAH_BINS - 2; border >= 0; --border)
+		{
+			sweepCount += binCounts[border + 1];
+			if (binCounts[border + 1] > 0)
+			{
+				sweepMin = glm::min(sweepMin, binMins[border + 1]);
+				sweepMax = glm::max(sweepMax, binMaxs[border + 1]);
+			}
+			if (leftCounts[border] == 0 || sweepCount == 0)
+			{
+				continue;
+			}
+			float cost = leftCounts[border] * leftAreas[border] + sweepCount * SurfaceArea(sweepMin, sweepMax);
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = border + 1;
+			}
+		}
+	}
+
+	if (bestAxis < 0)
+	{
+		// all centroids are in the same place
+		return;
+	}
+	float leafCost = node.count * SurfaceArea(node.boundsMin, node.boundsMax);
+	if (bestCost >= leafCost && node.count <= MAX_LEAF_OBJECTS)
+	{
+		return;
+	}
+
+	// partition the object indices of the node at the split bin
+	float binScale = SAH_BINS / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+	uint32_t* first = &m_objectIndices[node.leftFirst];
+	uint32_t* middle = std::partition(first, first + node.count, [&](uint32_t objectIndex)
+		{
+			float centroid = (m_boxMins[objectIndex][bestAxis] + m_boxMaxs[objectIndex][bestAxis]) * 0.5f;
+			int bin = std::min(SAH_BINS - 1, static_cast<int>((centroid - centroidMin[bestAxis]) * binScale));
+			return bin < bestSplit;
+		});
+	uint32_t leftCount = static_cast<uint32_t>(middle - first);
+	if (leftCount == 0 || leftCount == node.count)
+	{
+		return;
+	}
+
+	uint32_t leftChild = static_cast<uint32_t>(m_nodes.size());
+	BVH_NODE left;
+	left.leftFirst = node.leftFirst;
+	left.count = leftCount;
+	BVH_NODE right;
+	right.leftFirst = node.leftFirst + leftCount;
+	right.count = node.count - leftCount;
+
+	// the push_backs may move the nodes, so the reference is not used after
+	node.leftFirst = leftChild;
+	node.count = 0;
+	m_nodes.push_back(left);
+	m_nodes.push_back(right);
+	m_parents.push_back(nodeIndex);
+	m_parents.push_back(nodeIndex);
+	UpdateLeafBounds(leftChild);
+	UpdateLeafBounds(leftChild + 1);
+}
+
+/***********************************************************
+ *  SetObjectBounds()
+ *
+ *  This method is used for moving the box of an object.  The
+ *  tree is updated by the next Refit(), unchanged boxes are
+ *  ignored.
+ ***********************************************************/
+void BoundingVolumeHierarchy::SetObjectBounds(uint32_t objectIndex, const glm::vec3& boxMin, const glm::vec3& boxMax)
+{
+	if (boxMin == m_boxMins[objectIndex] && boxMax == m_boxMaxs[objectIndex])
+	{
+		return;
+	}
+	m_boxMins[objectIndex] = boxMin;
+	m_boxMaxs[objectIndex] = boxMax;
+
+	uint32_t leaf = m_objectLeaves[objectIndex];
+	if (m_leafDirty[leaf] == 0)
+	{
+		m_leafDirty[leaf] = 1;
+		m_dirtyLeaves.push_back(leaf);
+	}
+}
+
+/***********************************************************
+ *  Refit()
+ *
+ *  This method is used for recomputing the boxes of the
+ *  leaves with moved objects and of their ancestors.  The
+ *  walk up stops at the first box that did not change, so
+ *  a small move only touches a few nodes.  The tree shape
+ *  is kept; a rebuild is needed when objects moved far.
+ ***********************************************************/
+size_t BoundingVolumeHierarchy::Refit()
+{
+	size_t refitNodes = 0;
+	for (uint32_t leaf : m_dirtyLeaves)
+	{
+		m_leafDirty[leaf] = 0;
+		UpdateLeafBounds(leaf);
+		refitNodes++;
+
+		for (uint32_t nodeIndex = m_parents[leaf]; nodeIndex != NO_NODE; nodeIndex = m_parents[nodeIndex])
+		{
+			BVH_NODE& node = m_nodes[nodeIndex];
+			const BVH_NODE& left = m_nodes[node.leftFirst];
+			const BVH_NODE& right = m_nodes[node.leftFirst + 1];
+			glm::vec3 boundsMin = glm::min(left.boundsMin, right.boundsMin);
+			glm::vec3 boundsMax = glm::max(left.boundsMax, right.boundsMax);
+			if (boundsMin == node.boundsMin && boundsMax == node.boundsMax)
+			{
+				break;
+			}
+			node.boundsMin = boundsMin;
+			node.boundsMax = boundsMax;
+			refitNodes++;
+		}
+	}
+	m_dirtyLeaves.clear();
+	return refitNodes;
+}
+
+/***********************************************************
+ *  AddSubtreeObjects()
+ *
+ *  This method is used for appending every object below a
+ *  node without any further tests.
+ ***********************************************************/
+void BoundingVolumeHierarchy::AddSubtreeObjects(uint32_t nodeIndex, std::vector<uint32_t>& objects) const
+{
+	uint32_t stack[TRAVERSAL_STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = nodeIndex;
+	while (stackSize > 0)
+	{
+		const BVH_NODE& node = m_nodes[stack[--stackSize]];
+		if (node.count > 0)
+		{
+			objects.insert(objects.end(),
+				m_objectIndices.begin() + node.leftFirst,
+				m_objectIndices.begin() + node.leftFirst + node.count);
+		}
+		else
+		{
+			assert(stackSize + 2 <= TRAVERSAL_STACK_SIZE);
+			stack[stackSize++] = node.leftFirst;
+			stack[stackSize++] = node.leftFirst + 1;
+		}
+	}
+}
+
+/***********************************************************
+ *  QueryFrustum()
+ *
+ *  This method is used for collecting the objects inside a
+ *  frustum.  Subtrees fully inside are taken as a whole and
+ *  the objects of crossing leaves are tested one by one.
+ ***********************************************************/
+void BoundingVolumeHierarchy::QueryFrustum(const glm::vec4 planes[6], std::vector<uint32_t>& objects) const
+{
+	objects.clear();
+	if (m_nodes.empty())
+	{
+		return;
+	}
+
+	uint32_t stack[TRAVERSAL_STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		uint32_t nodeIndex = stack[--stackSize];
+		const BVH_NODE& node = m_nodes[nodeIndex];
+		int classification = ClassifyBox(planes, node.boundsMin, node.boundsMax);
+		if (classification == 0)
+		{
+			continue;
+		}
+		if (classification == 2)
+		{
+			AddSubtreeObjects(nodeIndex, objects);
+			continue;
+		}
+
+		if (node.count > 0)
+		{
+			for (uint32_t i = 0; i < node.count; ++i)
+			{
+				uint32_t objectIndex = m_objectIndices[node.leftFirst + i];
+				if (ClassifyBox(planes, m_boxMins[objectIndex], m_boxMaxs[objectIndex]) != 0)
+				{
+					objects.push_back(objectIndex);
+				}
+			}
+		}
+		else
+		{
+			assert(stackSize + 2 <= TRAVERSAL_STACK_SIZE);
+			stack[stackSize++] = node.leftFirst;
+			stack[stackSize++] = node.leftFirst + 1;
+		}
+	}
+}
+
+/***********************************************************
+ *  QueryRay()
+ *
+ *  This method is used for collecting the objects whose boxes
+ *  a ray passes through (slab test), sorted by the distance
+ *  where the ray enters each box.
+ ***********************************************************/
+void BoundingVolumeHierarchy::QueryRay(
+	const glm::vec3& origin,
+	const glm::vec3& direction,
+	float maxDistance,
+	std::vector<RAY_HIT>& hits) const
+{
+	hits.clear();
+	if (m_nodes.empty())
+	{
+		return;
+	}
+
+	// division by a zero component gives an infinity, which the slab
+	// test handles as a ray parallel to that slab
+	glm::vec3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+	auto intersect = [&](const glm::vec3& boxMin, const glm::vec3& boxMax, float& distance)
+	{
+		glm::vec3 t0 = (boxMin - origin) * inverseDirection;
+		glm::vec3 t1 = (boxMax - origin) * inverseDirection;
+		glm::vec3 tNear = glm::min(t0, t1);
+		glm::vec3 tFar = glm::max(t0, t1);
+		float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+		float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+		distance = enter;
+		return enter <= exit;
+	};
+
+	uint32_t stack[TRAVERSAL_STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const BVH_NODE& node = m_nodes[stack[--stackSize]];
+		float distance = 0.0f;
+		if (!intersect(node.boundsMin, node.boundsMax, distance))
+		{
+			continue;
+		}
+
+		if (node.count > 0)
+		{
+			for (uint32_t i = 0; i < node.count; ++i)
+			{
+				uint32_t objectIndex = m_objectIndices[node.leftFirst + i];
+				if (intersect(m_boxMins[objectIndex], m_boxMaxs[objectIndex], distance))
+				{
+					RAY_HIT hit;
+					hit.objectIndex = objectIndex;
+					hit.distance = distance;
+					hits.push_back(hit);
+				}
+			}
+		}
+		else
+		{
+			assert(stackSize + 2 <= TRAVERSAL_STACK_SIZE);
+			stack[stackSize++] = node.leftFirst;
+			stack[stackSize++] = node.leftFirst + 1;
+		}
+	}
+
+	std::sort(hits.begin(), hits.end(), [](const RAY_HIT& a, const RAY_HIT& b) { return a.distance < b.distance; });
+}
+
+/***********************************************************
+ *  QueryOverlap()
+ *
+ *  This method is used for collecting the objects whose boxes
+ *  overlap a box.
+ ***********************************************************/
+void BoundingVolumeHierarchy::QueryOverlap(const glm::vec3& boxMin, const glm::vec3& boxMax, std::vector<uint32_t>& objects) const
+{
+	objects.clear();
+	if (m_nodes.empty())
+	{
+		return;
+	}
+
+	auto overlaps = [&](const glm::vec3& otherMin, const glm::vec3& otherMax)
+	{
+		return otherMin.x <= boxMax.x && otherMax.x >= boxMin.x &&
+			otherMin.y <= boxMax.y && otherMax.y >= boxMin.y &&
+			otherMin.z <= boxMax.z && otherMax.z >= boxMin.z;
+	};
+
+	uint32_t stack[TRAVERSAL_STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const BVH_NODE& node = m_nodes[stack[--stackSize]];
+		if (!overlaps(node.boundsMin, node.boundsMax))
+		{
+			continue;
+		}
+
+		if (node.count > 0)
+		{
+			for (uint32_t i = 0; i < node.count; ++i)
+			{
+				uint32_t objectIndex = m_objectIndices[node.leftFirst + i];
+				if (overlaps(m_boxMins[objectIndex], m_boxMaxs[objectIndex]))
+				{
+					objects.push_back(objectIndex);
+				}
+			}
+		}
+		else
+		{
+			assert(stackSize + 2 <= TRAVERSAL_STACK_SIZE);
+			stack[stackSize++] = node.leftFirst;
+			stack[stackSize++] = node.leftFirst + 1;
+		}
+	}
+}
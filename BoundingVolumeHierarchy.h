@@ -0,0 +1,90 @@
+///////////////////////////////////////////////////////////////////////////////
+// boundingvolumehierarchy.h
+// ============
+// bounding volume hierarchy over the world-space boxes of the scene objects
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  BoundingVolumeHierarchy
+ *
+ *  This class builds a binary tree of axis aligned boxes
+ *  over a set of object boxes, split with the surface area
+ *  heuristic (SAH) over binned centroids.  Moved objects are
+ *  handled by refitting the boxes above them instead of a
+ *  rebuild.  The tree answers frustum, ray and box overlap
+ *  queries with the indices of the objects they touch.
+ ***********************************************************/
+class BoundingVolumeHierarchy
+{
+public:
+	// 32 byte node - an inner node (count 0) has its two children
+	// next to each other starting at leftFirst, a leaf holds count
+	// objects starting at leftFirst in the object index list
+	struct BVH_NODE
+	{
+		glm::vec3 boundsMin;
+		uint32_t leftFirst;
+		glm::vec3 boundsMax;
+		uint32_t count;
+	};
+
+	// object hit by a ray and the distance where the ray enters its box
+	struct RAY_HIT
+	{
+		uint32_t objectIndex;
+		float distance;
+	};
+
+	// build the tree over the object boxes
+	void Build(const std::vector<glm::vec3>& boxMins, const std::vector<glm::vec3>& boxMaxs);
+	// remove all the objects
+	void Clear();
+	size_t GetObjectCount() const { return m_boxMins.size(); }
+	size_t GetNodeCount() const { return m_nodes.size(); }
+
+	// change the box of an object, applied to the tree by Refit()
+	void SetObjectBounds(uint32_t objectIndex, const glm::vec3& boxMin, const glm::vec3& boxMax);
+	// refit the boxes above the changed objects, returns the nodes refit
+	size_t Refit();
+
+	// objects whose boxes are at least partly inside the planes, given
+	// as xyz normal pointing inside and w distance
+	void QueryFrustum(const glm::vec4 planes[6], std::vector<uint32_t>& objects) const;
+	// objects whose boxes the ray enters within maxDistance, nearest first
+	void QueryRay(
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		float maxDistance,
+		std::vector<RAY_HIT>& hits) const;
+	// objects whose boxes overlap the box
+	void QueryOverlap(const glm::vec3& boxMin, const glm::vec3& boxMax, std::vector<uint32_t>& objects) const;
+
+private:
+	std::vector<BVH_NODE> m_nodes;
+	// parent of each node, the root has none
+	std::vector<uint32_t> m_parents;
+	// object indices, grouped by leaf
+	std::vector<uint32_t> m_objectIndices;
+	// box and leaf node of each object
+	std::vector<glm::vec3> m_boxMins;
+	std::vector<glm::vec3> m_boxMaxs;
+	std::vector<uint32_t> m_objectLeaves;
+	// leaves with moved objects, refit on the next Refit()
+	std::vector<uint32_t> m_dirtyLeaves;
+	std::vector<unsigned char> m_leafDirty;
+
+	void UpdateLeafBounds(uint32_t nodeIndex);
+	void Subdivide(uint32_t nodeIndex, uint32_t depth);
+	void AddSubtreeObjects(uint32_t nodeIndex, std::vector<uint32_t>& objects) const;
+};
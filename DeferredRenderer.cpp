@@ -0,0 +1,219 @@
+///////////////////////////////////////////////////////////////////////////////
+// deferredrenderer.cpp
+// ============
+// render the opaque objects into a G-buffer and shade every pixel once
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DeferredRenderer.h"
+
+#include <iostream>
+
+namespace
+{
+	// G-buffer samplers of the light pass, in the order of their units
+	const char* g_TextureUniformNames[] = { "gbufferAlbedo", "gbufferNormal", "gbufferDepth" };
+	const char* g_InverseViewProjectionName = "inverseViewProjection";
+}
+
+/***********************************************************
+ *  DeferredRenderer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+DeferredRenderer::DeferredRenderer(ShaderManager* pShaderManager)
+{
+	m_pShaderManager = pShaderManager;
+	m_pStateCache = m_pShaderManager->GetStateCache();
+	m_framebuffer = 0;
+	m_width = 0;
+	m_height = 0;
+	for (int i = 0; i < GBUFFER_TEXTURE_COUNT; ++i)
+	{
+		m_textures[i] = 0;
+		m_textureUniforms[i] = m_pShaderManager->GetUniformHandle(g_TextureUniformNames[i]);
+		m_pShaderManager->setSampler2DValue(m_textureUniforms[i], FIRST_TEXTURE_UNIT + i);
+	}
+	m_inverseViewProjectionUniform = m_pShaderManager->GetUniformHandle(g_InverseViewProjectionName);
+
+	glGenVertexArrays(1, &m_emptyVertexArray);
+}
+
+/***********************************************************
+ *  ~DeferredRenderer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+DeferredRenderer::~DeferredRenderer()
+{
+	Destroy();
+	m_pStateCache->BindVertexArray(0);
+	glDeleteVertexArrays(1, &m_emptyVertexArray);
+	m_emptyVertexArray = 0;
+	m_pShaderManager = NULL;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the G-buffer textures
+ *  and their frame buffer.
+ ***********************************************************/
+void DeferredRenderer::Destroy()
+{
+	for (int i = 0; i < GBUFFER_TEXTURE_COUNT; ++i)
+	{
+		m_pStateCache->BindTexture(FIRST_TEXTURE_UNIT + i, GL_TEXTURE_2D, 0);
+	}
+	glDeleteTextures(GBUFFER_TEXTURE_COUNT, m_textures);
+	glDeleteFramebuffers(1, &m_framebuffer);
+	for (int i = 0; i < GBUFFER_TEXTURE_COUNT; ++i)
+	{
+		m_textures[i] = 0;
+	}
+	m_framebuffer = 0;
+	m_width = 0;
+	m_height = 0;
+}
+
+/***********************************************************
+ *  CreateTexture()
+ *
+ *  This method is used for creating a G-buffer texture of
+ *  the current size.  The light pass reads it texel by
+ *  texel, so it has no mip levels and no filtering.
+ ***********************************************************/
+GLuint DeferredRenderer::CreateTexture(GLenum internalFormat, GLenum format, GLenum type)
+{
+	GLuint texture = 0;
+	glGenTextures(1, &texture);
+	m_pStateCache->BindTexture(FIRST_TEXTURE_UNIT, GL_TEXTURE_2D, texture);
+	m_pStateCache->ActiveTexture(FIRST_TEXTURE_UNIT);
+	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, m_width, m_height, 0, format, type, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	return texture;
+}
+
+/***********************************************************
+ *  Resize()
+ *
+ *  This method is used for creating the G-buffer textures
+ *  for the size of the viewport - 8 bit albedo, half float
+ *  normals with the material index, and 24 bit depth - and
+ *  the frame buffer drawing into all of them.
+ ***********************************************************/
+bool DeferredRenderer::Resize(int width, int height)
+{
+	if (width == m_width && height == m_height && m_framebuffer != 0)
+	{
+		return true;
+	}
+	Destroy();
+	if (width <= 0 || height <= 0)
+	{
+		return false;
+	}
+	m_width = width;
+	m_height = height;
+
+	m_textures[GBUFFER_ALBEDO] = CreateTexture(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+	m_textures[GBUFFER_NORMAL] = CreateTexture(GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT);
+	m_textures[GBUFFER_DEPTH] = CreateTexture(GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT);
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_textures[GBUFFER_ALBEDO], 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, m_textures[GBUFFER_NORMAL], 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_textures[GBUFFER_DEPTH], 0);
+	const GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glDrawBuffers(2, drawBuffers);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cerr << "ERROR: G-buffer frame buffer is incomplete (0x" << std::hex << status << std::dec << ")" << std::endl;
+		Destroy();
+		return false;
+	}
+
+	std::cout << "INFO: G-buffer of " << m_width << "x" << m_height << " pixels, "
+		<< GetMemoryBytes() / (1024.0 * 1024.0) << " MB" << std::endl;
+	return true;
+}
+
+/***********************************************************
+ *  GetMemoryBytes()
+ *
+ *  This method is used for getting the size of the G-buffer
+ *  textures - 4 bytes of albedo, 8 of normal and material
+ *  and 4 of depth per pixel.
+ ***********************************************************/
+size_t DeferredRenderer::GetMemoryBytes() const
+{
+	return static_cast<size_t>(m_width) * m_height * (4 + 8 + 4);
+}
+
+/***********************************************************
+ *  BeginGeometryPass()
+ *
+ *  This method is used for binding the G-buffer and the
+ *  G-buffer pass of the scene shaders.  Only the depth is
+ *  cleared - the light pass skips the pixels left at the
+ *  far plane.  Blending is off, the alpha of the albedo
+ *  target flags the lit surfaces.
+ ***********************************************************/
+void DeferredRenderer::BeginGeometryPass()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glClear(GL_DEPTH_BUFFER_BIT);
+	m_pStateCache->Disable(GL_BLEND);
+	m_pShaderManager->SetPass(ShaderManager::PASS_GBUFFER);
+}
+
+/***********************************************************
+ *  EndGeometryPass()
+ *
+ *  This method is used for going back to the default frame
+ *  buffer once the opaque objects are drawn.
+ ***********************************************************/
+void DeferredRenderer::EndGeometryPass()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+/***********************************************************
+ *  RenderLightPass()
+ *
+ *  This method is used for shading the G-buffer with one
+ *  triangle covering the screen.  The scene shaders are
+ *  switched to the light pass, which runs the lighting of
+ *  the forward pass once per pixel and writes the G-buffer
+ *  depth along with the color.  The scene shaders are left
+ *  in the forward pass, for the transparent objects.
+ ***********************************************************/
+void DeferredRenderer::RenderLightPass(const glm::mat4& inverseViewProjection)
+{
+	m_lightPassTimer.Begin();
+
+	for (int i = 0; i < GBUFFER_TEXTURE_COUNT; ++i)
+	{
+		m_pStateCache->BindTexture(FIRST_TEXTURE_UNIT + i, GL_TEXTURE_2D, m_textures[i]);
+	}
+	m_pShaderManager->setMat4Value(m_inverseViewProjectionUniform, inverseViewProjection);
+	m_pShaderManager->SetPass(ShaderManager::PASS_DEFERRED_LIGHTING);
+	m_pShaderManager->use();
+
+	m_pStateCache->SetEnabled(GL_CULL_FACE, false);
+	m_pStateCache->BindVertexArray(m_emptyVertexArray);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+
+	m_pStateCache->Enable(GL_BLEND);
+	m_pShaderManager->SetPass(ShaderManager::PASS_FORWARD);
+	m_lightPassTimer.End();
+}
@@ -0,0 +1,95 @@
+///////////////////////////////////////////////////////////////////////////////
+// deferredrenderer.h
+// ============
+// render the opaque objects into a G-buffer and shade every pixel once
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "GLStateCache.h"
+#include "GpuTimer.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  DeferredRenderer
+ *
+ *  This class owns the G-buffer of the deferred pipeline -
+ *  the albedo, the normal and material index, and the depth
+ *  of the nearest opaque surface of every pixel.  The caller
+ *  draws the opaque objects between BeginGeometryPass() and
+ *  EndGeometryPass() with the scene shaders switched to
+ *  their G-buffer pass; the light pass then shades each
+ *  pixel once with the same lighting code, however many
+ *  objects were drawn over it, and writes the depth of the
+ *  surface so the transparent objects can be drawn forward
+ *  on top.
+ ***********************************************************/
+class DeferredRenderer
+{
+public:
+	// texture units the light pass samples the G-buffer from - the light
+	// pass samples no texture arrays, so it takes the first units
+	static const GLuint FIRST_TEXTURE_UNIT = 0;
+
+	// constructor - draws with the scene shader manager
+	DeferredRenderer(ShaderManager* pShaderManager);
+	// destructor
+	~DeferredRenderer();
+
+	// create the G-buffer for a viewport size, nothing is done while the
+	// size is unchanged - false when the frame buffer is incomplete
+	bool Resize(int width, int height);
+	// free the G-buffer
+	void Destroy();
+
+	// start drawing the opaque objects into the G-buffer
+	void BeginGeometryPass();
+	// go back to the default frame buffer
+	void EndGeometryPass();
+	// shade the G-buffer into the default frame buffer - the inverse
+	// view projection matrix rebuilds the world position of each pixel
+	void RenderLightPass(const glm::mat4& inverseViewProjection);
+
+	// bytes of video memory held by the G-buffer
+	size_t GetMemoryBytes() const;
+
+	// average GPU time of the light pass in milliseconds
+	double GetLightPassMs() const { return m_lightPassTimer.GetAverageMs(); }
+	int GetLightPassSampleCount() const { return m_lightPassTimer.GetSampleCount(); }
+	void ResetStats() { m_lightPassTimer.Reset(); }
+
+private:
+	// the G-buffer attachments, in the order of their texture units
+	enum GBUFFER_TEXTURE
+	{
+		GBUFFER_ALBEDO = 0,
+		GBUFFER_NORMAL,
+		GBUFFER_DEPTH,
+		GBUFFER_TEXTURE_COUNT
+	};
+
+	// scene shader manager, switched between its passes
+	ShaderManager* m_pShaderManager;
+	// OpenGL state cache of the scene shader manager
+	GLStateCache* m_pStateCache;
+	UniformHandle m_textureUniforms[GBUFFER_TEXTURE_COUNT];
+	UniformHandle m_inverseViewProjectionUniform;
+
+	GLuint m_textures[GBUFFER_TEXTURE_COUNT];
+	GLuint m_framebuffer;
+	int m_width;
+	int m_height;
+	// the full screen triangle has no vertex attributes, but the core
+	// profile still needs a vertex array bound to draw it
+	GLuint m_emptyVertexArray;
+	GpuTimer m_lightPassTimer;
+
+	// create one G-buffer texture, sampled texel by texel
+	GLuint CreateTexture(GLenum internalFormat, GLenum format, GLenum type);
+};
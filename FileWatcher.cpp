@@ -0,0 +1,341 @@
+///////////////////////////////////////////////////////////////////////////////
+// filewatcher.cpp
+// ============
+// watch asset directories for changed files to support hot reloading
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FileWatcher.h"
+
+#include <algorithm>
+#include <iostream>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <errno.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <chrono>
+#include <windows.h>
+#else
+#include <chrono>
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+/***********************************************************
+ *  FileWatcher()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FileWatcher::FileWatcher()
+{
+#ifdef __linux__
+	m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (m_inotifyFd < 0)
+	{
+		std::cerr << "ERROR: inotify is not available, hot reload is disabled" << std::endl;
+	}
+#else
+	m_lastScanTime = 0;
+#endif
+}
+
+/***********************************************************
+ *  ~FileWatcher()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FileWatcher::~FileWatcher()
+{
+#ifdef __linux__
+	if (m_inotifyFd >= 0)
+	{
+		close(m_inotifyFd);
+		m_inotifyFd = -1;
+	}
+#endif
+}
+
+#ifdef __linux__
+
+/***********************************************************
+ *  WatchDirectory()
+ *
+ *  This method is used for adding a directory tree to the
+ *  set of watched directories.
+ ***********************************************************/
+bool FileWatcher::WatchDirectory(const std::string& directoryPath)
+{
+	if (m_inotifyFd < 0)
+	{
+		return false;
+	}
+
+	size_t watchCount = m_watchedDirectories.size();
+	AddWatchRecursive(directoryPath);
+	return m_watchedDirectories.size() > watchCount;
+}
+
+/***********************************************************
+ *  AddWatchRecursive()
+ *
+ *  This method is used for adding an inotify watch for the
+ *  directory and each of its sub directories, since inotify
+ *  watches are not recursive.
+ ***********************************************************/
+void FileWatcher::AddWatchRecursive(const std::string& directoryPath)
+{
+	int watchDescriptor = inotify_add_watch(
+		m_inotifyFd,
+		directoryPath.c_str(),
+		IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+	if (watchDescriptor < 0)
+	{
+		std::cerr << "ERROR: Could not watch directory: " << directoryPath << std::endl;
+		return;
+	}
+	m_watchedDirectories[watchDescriptor] = directoryPath;
+
+	DIR* directory = opendir(directoryPath.c_str());
+	if (directory == NULL)
+	{
+		return;
+	}
+
+	struct dirent* entry = NULL;
+	while ((entry = readdir(directory)) != NULL)
+	{
+		std::string name = entry->d_name;
+		if (name == "." || name == "..")
+		{
+			continue;
+		}
+
+		std::string childPath = directoryPath + "/" + name;
+		struct stat childStat;
+		if (stat(childPath.c_str(), &childStat) == 0 && S_ISDIR(childStat.st_mode))
+		{
+			AddWatchRecursive(childPath);
+		}
+	}
+	closedir(directory);
+}
+
+/***********************************************************
+ *  PollChanges()
+ *
+ *  This method is used for draining the pending inotify
+ *  events and returning each changed file once.
+ ***********************************************************/
+void FileWatcher::PollChanges(std::vector<std::string>& changedFiles)
+{
+	changedFiles.clear();
+	if (m_inotifyFd < 0)
+	{
+		return;
+	}
+
+	alignas(struct inotify_event) char buffer[4096];
+	for (;;)
+	{
+		ssize_t length = read(m_inotifyFd, buffer, sizeof(buffer));
+		if (length <= 0)
+		{
+			// EAGAIN - no more events are waiting
+			break;
+		}
+
+		for (char* pEvent = buffer; pEvent < buffer + length; )
+		{
+			const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(pEvent);
+			pEvent += sizeof(struct inotify_event) + event->len;
+
+			auto directory = m_watchedDirectories.find(event->wd);
+			if (directory == m_watchedDirectories.end() || event->len == 0)
+			{
+				continue;
+			}
+
+			std::string path = directory->second + "/" + event->name;
+			if (event->mask & IN_ISDIR)
+			{
+				// start watching directories created after startup
+				if (event->mask & (IN_CREATE | IN_MOVED_TO))
+				{
+					AddWatchRecursive(path);
+				}
+				continue;
+			}
+			if ((event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) == 0)
+			{
+				// a created file is reported again once it is fully written
+				continue;
+			}
+
+			if (std::find(changedFiles.begin(), changedFiles.end(), path) == changedFiles.end())
+			{
+				changedFiles.push_back(path);
+			}
+		}
+	}
+}
+
+#else
+
+namespace
+{
+	// minimum number of milliseconds between two directory scans
+	const long long SCAN_INTERVAL_MS = 500;
+}
+
+/***********************************************************
+ *  WatchDirectory()
+ *
+ *  This method is used for adding a directory tree to the
+ *  set of watched directories.
+ ***********************************************************/
+bool FileWatcher::WatchDirectory(const std::string& directoryPath)
+{
+	m_watchedDirectories.push_back(directoryPath);
+	ScanDirectory(directoryPath, NULL);
+	return true;
+}
+
+/***********************************************************
+ *  RecordFileTime()
+ *
+ *  This method is used for comparing a file with its last
+ *  seen modification time.  A file that is missing from the
+ *  snapshot was added after the previous scan and is
+ *  reported as changed, except during the initial scan.
+ ***********************************************************/
+void FileWatcher::RecordFileTime(const std::string& filePath, long long modifiedTime, std::vector<std::string>* pChangedFiles)
+{
+	auto file = m_fileTimes.find(filePath);
+	if (file != m_fileTimes.end() && file->second == modifiedTime)
+	{
+		return;
+	}
+
+	m_fileTimes[filePath] = modifiedTime;
+	if (pChangedFiles != NULL)
+	{
+		pChangedFiles->push_back(filePath);
+	}
+}
+
+#ifdef _WIN32
+
+/***********************************************************
+ *  ScanDirectory()
+ *
+ *  This method is used for comparing the modification time
+ *  of every file below the directory with the last scan.
+ ***********************************************************/
+void FileWatcher::ScanDirectory(const std::string& directoryPath, std::vector<std::string>* pChangedFiles)
+{
+	WIN32_FIND_DATAA findData;
+	HANDLE findHandle = FindFirstFileA((directoryPath + "/*").c_str(), &findData);
+	if (findHandle == INVALID_HANDLE_VALUE)
+	{
+		return;
+	}
+
+	do
+	{
+		std::string name = findData.cFileName;
+		if (name == "." || name == "..")
+		{
+			continue;
+		}
+
+		std::string childPath = directoryPath + "/" + name;
+		if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+		{
+			ScanDirectory(childPath, pChangedFiles);
+			continue;
+		}
+
+		long long modifiedTime =
+			(static_cast<long long>(findData.ftLastWriteTime.dwHighDateTime) << 32) |
+			findData.ftLastWriteTime.dwLowDateTime;
+		RecordFileTime(childPath, modifiedTime, pChangedFiles);
+	} while (FindNextFileA(findHandle, &findData));
+
+	FindClose(findHandle);
+}
+
+#else
+
+/***********************************************************
+ *  ScanDirectory()
+ *
+ *  This method is used for comparing the modification time
+ *  of every file below the directory with the last scan.
+ ***********************************************************/
+void FileWatcher::ScanDirectory(const std::string& directoryPath, std::vector<std::string>* pChangedFiles)
+{
+	DIR* directory = opendir(directoryPath.c_str());
+	if (directory == NULL)
+	{
+		return;
+	}
+
+	struct dirent* entry = NULL;
+	while ((entry = readdir(directory)) != NULL)
+	{
+		std::string name = entry->d_name;
+		if (name == "." || name == "..")
+		{
+			continue;
+		}
+
+		std::string childPath = directoryPath + "/" + name;
+		struct stat childStat;
+		if (stat(childPath.c_str(), &childStat) != 0)
+		{
+			continue;
+		}
+		if (S_ISDIR(childStat.st_mode))
+		{
+			ScanDirectory(childPath, pChangedFiles);
+			continue;
+		}
+
+		RecordFileTime(childPath, static_cast<long long>(childStat.st_mtime), pChangedFiles);
+	}
+	closedir(directory);
+}
+
+#endif
+
+/***********************************************************
+ *  PollChanges()
+ *
+ *  This method is used for rescanning the watched directories
+ *  at a limited rate and returning the changed files.
+ ***********************************************************/
+void FileWatcher::PollChanges(std::vector<std::string>& changedFiles)
+{
+	changedFiles.clear();
+
+	long long now = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+	if (now - m_lastScanTime < SCAN_INTERVAL_MS)
+	{
+		return;
+	}
+	m_lastScanTime = now;
+
+	for (const std::string& directoryPath : m_watchedDirectories)
+	{
+		ScanDirectory(directoryPath, &changedFiles);
+	}
+}
+
+#endif
@@ -0,0 +1,59 @@
+///////////////////////////////////////////////////////////////////////////////
+// filewatcher.h
+// ============
+// watch asset directories for changed files to support hot reloading
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  FileWatcher
+ *
+ *  This class reports files that were written inside the
+ *  watched directories (and their sub directories).  On Linux
+ *  the changes come from inotify; Windows and the other POSIX
+ *  platforms fall back to periodically comparing file
+ *  modification times.
+ ***********************************************************/
+class FileWatcher
+{
+public:
+	// constructor
+	FileWatcher();
+	// destructor
+	~FileWatcher();
+
+	// start watching a directory and all of its sub directories
+	bool WatchDirectory(const std::string& directoryPath);
+
+	// collect the files changed since the previous poll - never blocks
+	void PollChanges(std::vector<std::string>& changedFiles);
+
+private:
+#ifdef __linux__
+	// inotify instance and the directory behind every watch descriptor
+	int m_inotifyFd;
+	std::unordered_map<int, std::string> m_watchedDirectories;
+
+	// add an inotify watch for a directory and its sub directories
+	void AddWatchRecursive(const std::string& directoryPath);
+#else
+	// watched directories and the last seen modification time of each file
+	std::vector<std::string> m_watchedDirectories;
+	std::unordered_map<std::string, long long> m_fileTimes;
+	// time of the last directory scan, scans are rate limited
+	long long m_lastScanTime;
+
+	// record the modification times of all files below a directory
+	void ScanDirectory(const std::string& directoryPath, std::vector<std::string>* pChangedFiles);
+	// compare one file with its last seen modification time
+	void RecordFileTime(const std::string& filePath, long long modifiedTime, std::vector<std::string>* pChangedFiles);
+#endif
+};
@@ -0,0 +1,235 @@
+///////////////////////////////////////////////////////////////////////////////
+// frustumculler.cpp
+// ============
+// test world-space bounding boxes against the camera frustum
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrustumCuller.h"
+
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define FRUSTUM_CULL_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FRUSTUM_CULL_SSE 1
+#endif
+
+namespace
+{
+	// the SoA arrays are padded so the widest loop never reads past the end
+	const size_t BOX_PADDING = 8;
+}
+
+/***********************************************************
+ *  FrustumCuller()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrustumCuller::FrustumCuller()
+{
+	for (int i = 0; i < 6; ++i)
+	{
+		m_planes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		m_absoluteNormals[i] = glm::vec3(0.0f);
+	}
+}
+
+/***********************************************************
+ *  SetFrustum()
+ *
+ *  This method is used for extracting the six planes of the
+ *  view frustum from the combined projection and view matrix
+ *  (Gribb/Hartmann), normalized so the plane distances are
+ *  in world units.
+ ***********************************************************/
+void FrustumCuller::SetFrustum(const glm::mat4& viewProjection)
+{
+	// rows of the matrix - glm stores columns
+	glm::vec4 rows[4];
+	for (int row = 0; row < 4; ++row)
+	{
+		rows[row] = glm::vec4(viewProjection[0][row], viewProjection[1][row], viewProjection[2][row], viewProjection[3][row]);
+	}
+
+	m_planes[0] = rows[3] + rows[0];   // left
+	m_planes[1] = rows[3] - rows[0];   // right
+	m_planes[2] = rows[3] + rows[1];   // bottom
+	m_planes[3] = rows[3] - rows[1];   // top
+	m_planes[4] = rows[3] + rows[2];   // near
+	m_planes[5] = rows[3] - rows[2];   // far
+
+	for (int i = 0; i < 6; ++i)
+	{
+		float length = glm::length(glm::vec3(m_planes[i]));
+		if (length > 0.0f)
+		{
+			m_planes[i] /= length;
+		}
+		m_absoluteNormals[i] = glm::abs(glm::vec3(m_planes[i]));
+	}
+}
+
+/***********************************************************
+ *  Resize()
+ *
+ *  This method is used for setting the number of boxes.
+ ***********************************************************/
+void FrustumCuller::Resize(size_t boxCount)
+{
+	m_boxCount = boxCount;
+	size_t paddedCount = (boxCount + BOX_PADDING - 1) / BOX_PADDING * BOX_PADDING;
+	m_centerX.resize(paddedCount, 0.0f);
+	m_centerY.resize(paddedCount, 0.0f);
+	m_centerZ.resize(paddedCount, 0.0f);
+	m_extentX.resize(paddedCount, 0.0f);
+	m_extentY.resize(paddedCount, 0.0f);
+	m_extentZ.resize(paddedCount, 0.0f);
+}
+
+/***********************************************************
+ *  SetBox()
+ *
+ *  This method is used for storing the world-space bounds
+ *  of a box.
+ ***********************************************************/
+void FrustumCuller::SetBox(size_t index, const glm::vec3& center, const glm::vec3& extents)
+{
+	m_centerX[index] = center.x;
+	m_centerY[index] = center.y;
+	m_centerZ[index] = center.z;
+	m_extentX[index] = extents.x;
+	m_extentY[index] = extents.y;
+	m_extentZ[index] = extents.z;
+}
+
+/***********************************************************
+ *  GetInstructionSet()
+ *
+ *  This method is used for naming the instruction set the
+ *  culling loop was compiled for.
+ ***********************************************************/
+const char* FrustumCuller::GetInstructionSet()
+{
+#if defined(FRUSTUM_CULL_AVX)
+	return "AVX";
+#elif defined(FRUSTUM_CULL_SSE)
+	return "SSE";
+#else
+	return "scalar";
+#endif
+}
+
+/***********************************************************
+ *  Cull()
+ *
+ *  This method is used for testing every box against the
+ *  frustum planes.  A box is outside when it lies completely
+ *  behind one plane: the distance of its center plus its
+ *  projected radius (the extents along the absolute normal)
+ *  is negative.
+ ***********************************************************/
+size_t FrustumCuller::Cull(std::vector<unsigned char>& visible) const
+{
+	visible.resize(m_boxCount);
+	size_t visibleCount = 0;
+
+#if defined(FRUSTUM_CULL_AVX)
+	const size_t LANES = 8;
+	const __m256 zero = _mm256_setzero_ps();
+	for (size_t first = 0; first < m_boxCount; first += LANES)
+	{
+		__m256 centerX = _mm256_loadu_ps(&m_centerX[first]);
+		__m256 centerY = _mm256_loadu_ps(&m_centerY[first]);
+		__m256 centerZ = _mm256_loadu_ps(&m_centerZ[first]);
+		__m256 extentX = _mm256_loadu_ps(&m_extentX[first]);
+		__m256 extentY = _mm256_loadu_ps(&m_extentY[first]);
+		__m256 extentZ = _mm256_loadu_ps(&m_extentZ[first]);
+
+		__m256 inside = _mm256_cmp_ps(zero, zero, _CMP_EQ_OQ);
+		for (int plane = 0; plane < 6; ++plane)
+		{
+			__m256 distance = _mm256_add_ps(
+				_mm256_add_ps(
+					_mm256_mul_ps(centerX, _mm256_set1_ps(m_planes[plane].x)),
+					_mm256_mul_ps(centerY, _mm256_set1_ps(m_planes[plane].y))),
+				_mm256_add_ps(
+					_mm256_mul_ps(centerZ, _mm256_set1_ps(m_planes[plane].z)),
+					_mm256_set1_ps(m_planes[plane].w)));
+			__m256 radius = _mm256_add_ps(
+				_mm256_add_ps(
+					_mm256_mul_ps(extentX, _mm256_set1_ps(m_absoluteNormals[plane].x)),
+					_mm256_mul_ps(extentY, _mm256_set1_ps(m_absoluteNormals[plane].y))),
+				_mm256_mul_ps(extentZ, _mm256_set1_ps(m_absoluteNormals[plane].z)));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_GE_OQ));
+		}
+
+		int mask = _mm256_movemask_ps(inside);
+		for (size_t lane = 0; lane < LANES && first + lane < m_boxCount; ++lane)
+		{
+			unsigned char bVisible = static_cast<unsigned char>((mask >> lane) & 1);
+			visible[first + lane] = bVisible;
+			visibleCount += bVisible;
+		}
+	}
+#elif defined(FRUSTUM_CULL_SSE)
+	const size_t LANES = 4;
+	const __m128 zero = _mm_setzero_ps();
+	for (size_t first = 0; first < m_boxCount; first += LANES)
+	{
+		__m128 centerX = _mm_loadu_ps(&m_centerX[first]);
+		__m128 centerY = _mm_loadu_ps(&m_centerY[first]);
+		__m128 centerZ = _mm_loadu_ps(&m_centerZ[first]);
+		__m128 extentX = _mm_loadu_ps(&m_extentX[first]);
+		__m128 extentY = _mm_loadu_ps(&m_extentY[first]);
+		__m128 extentZ = _mm_loadu_ps(&m_extentZ[first]);
+
+		__m128 inside = _mm_cmpeq_ps(zero, zero);
+		for (int plane = 0; plane < 6; ++plane)
+		{
+			__m128 distance = _mm_add_ps(
+				_mm_add_ps(
+					_mm_mul_ps(centerX, _mm_set1_ps(m_planes[plane].x)),
+					_mm_mul_ps(centerY, _mm_set1_ps(m_planes[plane].y))),
+				_mm_add_ps(
+					_mm_mul_ps(centerZ, _mm_set1_ps(m_planes[plane].z)),
+					_mm_set1_ps(m_planes[plane].w)));
+			__m128 radius = _mm_add_ps(
+				_mm_add_ps(
+					_mm_mul_ps(extentX, _mm_set1_ps(m_absoluteNormals[plane].x)),
+					_mm_mul_ps(extentY, _mm_set1_ps(m_absoluteNormals[plane].y))),
+				_mm_mul_ps(extentZ, _mm_set1_ps(m_absoluteNormals[plane].z)));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, radius), zero));
+		}
+
+		int mask = _mm_movemask_ps(inside);
+		for (size_t lane = 0; lane < LANES && first + lane < m_boxCount; ++lane)
+		{
+			unsigned char bVisible = static_cast<unsigned char>((mask >> lane) & 1);
+			visible[first + lane] = bVisible;
+			visibleCount += bVisible;
+		}
+	}
+#else
+	for (size_t i = 0; i < m_boxCount; ++i)
+	{
+		bool bInside = true;
+		for (int plane = 0; plane < 6 && bInside; ++plane)
+		{
+			float distance = m_centerX[i] * m_planes[plane].x + m_centerY[i] * m_planes[plane].y +
+				m_centerZ[i] * m_planes[plane].z + m_planes[plane].w;
+			float radius = m_extentX[i] * m_absoluteNormals[plane].x + m_extentY[i] * m_absoluteNormals[plane].y +
+				m_extentZ[i] * m_absoluteNormals[plane].z;
+			bInside = (distance + radius >= 0.0f);
+		}
+		visible[i] = bInside ? 1 : 0;
+		visibleCount += visible[i];
+	}
+#endif
+
+	return visibleCount;
+}
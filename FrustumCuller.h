@@ -0,0 +1,64 @@
+///////////////////////////////////////////////////////////////////////////////
+// frustumculler.h
+// ============
+// test world-space bounding boxes against the camera frustum
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  FrustumCuller
+ *
+ *  This class keeps the world-space bounding boxes of the
+ *  scene objects in SoA form (center and half extents, one
+ *  array per component) and tests them against the six
+ *  frustum planes, eight boxes per instruction with AVX,
+ *  four with SSE, one at a time otherwise.
+ ***********************************************************/
+class FrustumCuller
+{
+public:
+	// constructor - every box is visible until a frustum is set
+	FrustumCuller();
+
+	// extract the frustum planes from a projection * view matrix
+	void SetFrustum(const glm::mat4& viewProjection);
+	// frustum planes, xyz normal pointing inside and w distance
+	const glm::vec4* GetPlanes() const { return m_planes; }
+
+	// number of boxes, new boxes are empty and at the origin
+	void Resize(size_t boxCount);
+	size_t GetBoxCount() const { return m_boxCount; }
+	// set a box from its world-space center and half extents
+	void SetBox(size_t index, const glm::vec3& center, const glm::vec3& extents);
+
+	// flag the boxes that are at least partly inside the frustum,
+	// returns the number of visible boxes
+	size_t Cull(std::vector<unsigned char>& visible) const;
+
+	// name of the instruction set used by Cull()
+	static const char* GetInstructionSet();
+
+private:
+	// frustum planes (xyz normal pointing inside, w distance) and the
+	// absolute values of their normals
+	glm::vec4 m_planes[6];
+	glm::vec3 m_absoluteNormals[6];
+
+	size_t m_boxCount = 0;
+	// SoA box data, padded to a multiple of eight boxes
+	std::vector<float> m_centerX;
+	std::vector<float> m_centerY;
+	std::vector<float> m_centerZ;
+	std::vector<float> m_extentX;
+	std::vector<float> m_extentY;
+	std::vector<float> m_extentZ;
+};
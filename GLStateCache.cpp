@@ -0,0 +1,236 @@
+///////////////////////////////////////////////////////////////////////////////
+// glstatecache.cpp
+// ============
+// remember the current OpenGL state and skip calls that would not change it
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GLStateCache.h"
+
+/***********************************************************
+ *  GLStateCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+GLStateCache::GLStateCache()
+{
+	Invalidate();
+}
+
+/***********************************************************
+ *  Invalidate()
+ *
+ *  This method is used for forgetting all the shadowed state,
+ *  so the next call of every kind is passed on to OpenGL.
+ ***********************************************************/
+void GLStateCache::Invalidate()
+{
+	m_program = UNKNOWN;
+	m_vertexArray = UNKNOWN;
+	m_activeTextureUnit = UNKNOWN;
+	for (int unit = 0; unit < MAX_TEXTURE_UNITS; ++unit)
+	{
+		for (int target = 0; target < TEXTURE_TARGET_COUNT; ++target)
+		{
+			m_textures[unit][target] = UNKNOWN;
+		}
+	}
+	m_capabilities.clear();
+	m_cullFaceMode = UNKNOWN;
+	m_blendSourceFactor = UNKNOWN;
+	m_blendDestinationFactor = UNKNOWN;
+}
+
+/***********************************************************
+ *  UseProgram()
+ *
+ *  This method is used for binding a shader program.
+ ***********************************************************/
+void GLStateCache::UseProgram(GLuint program)
+{
+	if (m_program == program)
+	{
+		m_stats.skippedCalls++;
+		return;
+	}
+
+	glUseProgram(program);
+	m_program = program;
+	m_stats.issuedCalls++;
+}
+
+/***********************************************************
+ *  BindVertexArray()
+ *
+ *  This method is used for binding a vertex array object.
+ ***********************************************************/
+void GLStateCache::BindVertexArray(GLuint vertexArray)
+{
+	if (m_vertexArray == vertexArray)
+	{
+		m_stats.skippedCalls++;
+		return;
+	}
+
+	glBindVertexArray(vertexArray);
+	m_vertexArray = vertexArray;
+	m_stats.issuedCalls++;
+}
+
+/***********************************************************
+ *  GetTargetIndex()
+ *
+ *  This method is used for mapping a texture target to its
+ *  slot in the texture unit table.
+ ***********************************************************/
+int GLStateCache::GetTargetIndex(GLenum target)
+{
+	switch (target)
+	{
+	case GL_TEXTURE_2D:
+		return 0;
+	case GL_TEXTURE_2D_ARRAY:
+		return 1;
+	default:
+		return -1;
+	}
+}
+
+/***********************************************************
+ *  BindTexture()
+ *
+ *  This method is used for binding a texture to a texture
+ *  unit.  The active texture unit is only switched when the
+ *  binding actually has to change.
+ ***********************************************************/
+void GLStateCache::BindTexture(GLuint unit, GLenum target, GLuint texture)
+{
+	int targetIndex = GetTargetIndex(target);
+	bool bTracked = (targetIndex >= 0 && unit < static_cast<GLuint>(MAX_TEXTURE_UNITS));
+	if (bTracked && m_textures[unit][targetIndex] == texture)
+	{
+		m_stats.skippedCalls++;
+		return;
+	}
+
+	if (m_activeTextureUnit != unit)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		m_activeTextureUnit = unit;
+		m_stats.issuedCalls++;
+	}
+
+	glBindTexture(target, texture);
+	m_stats.issuedCalls++;
+	if (bTracked)
+	{
+		m_textures[unit][targetIndex] = texture;
+	}
+}
+
+/***********************************************************
+ *  ActiveTexture()
+ *
+ *  This method is used for selecting the texture unit that
+ *  texture uploads and parameter changes apply to.
+ ***********************************************************/
+void GLStateCache::ActiveTexture(GLuint unit)
+{
+	if (m_activeTextureUnit == unit)
+	{
+		m_stats.skippedCalls++;
+		return;
+	}
+
+	glActiveTexture(GL_TEXTURE0 + unit);
+	m_activeTextureUnit = unit;
+	m_stats.issuedCalls++;
+}
+
+/***********************************************************
+ *  SetEnabled()
+ *
+ *  This method is used for changing an enable bit when it
+ *  differs from the shadowed value.
+ ***********************************************************/
+void GLStateCache::SetEnabled(GLenum capability, bool bEnabled)
+{
+	for (auto& state : m_capabilities)
+	{
+		if (state.first == capability)
+		{
+			if (state.second == bEnabled)
+			{
+				m_stats.skippedCalls++;
+				return;
+			}
+			state.second = bEnabled;
+			bEnabled ? glEnable(capability) : glDisable(capability);
+			m_stats.issuedCalls++;
+			return;
+		}
+	}
+
+	m_capabilities.push_back(std::make_pair(capability, bEnabled));
+	bEnabled ? glEnable(capability) : glDisable(capability);
+	m_stats.issuedCalls++;
+}
+
+/***********************************************************
+ *  Enable()
+ *
+ *  This method is used for turning on an OpenGL capability.
+ ***********************************************************/
+void GLStateCache::Enable(GLenum capability)
+{
+	SetEnabled(capability, true);
+}
+
+/***********************************************************
+ *  Disable()
+ *
+ *  This method is used for turning off an OpenGL capability.
+ ***********************************************************/
+void GLStateCache::Disable(GLenum capability)
+{
+	SetEnabled(capability, false);
+}
+
+/***********************************************************
+ *  CullFace()
+ *
+ *  This method is used for selecting the culled faces.
+ ***********************************************************/
+void GLStateCache::CullFace(GLenum mode)
+{
+	if (m_cullFaceMode == mode)
+	{
+		m_stats.skippedCalls++;
+		return;
+	}
+
+	glCullFace(mode);
+	m_cullFaceMode = mode;
+	m_stats.issuedCalls++;
+}
+
+/***********************************************************
+ *  BlendFunc()
+ *
+ *  This method is used for setting the blending factors.
+ ***********************************************************/
+void GLStateCache::BlendFunc(GLenum sourceFactor, GLenum destinationFactor)
+{
+	if (m_blendSourceFactor == sourceFactor && m_blendDestinationFactor == destinationFactor)
+	{
+		m_stats.skippedCalls++;
+		return;
+	}
+
+	glBlendFunc(sourceFactor, destinationFactor);
+	m_blendSourceFactor = sourceFactor;
+	m_blendDestinationFactor = destinationFactor;
+	m_stats.issuedCalls++;
+}
@@ -0,0 +1,90 @@
+///////////////////////////////////////////////////////////////////////////////
+// glstatecache.h
+// ============
+// remember the current OpenGL state and skip calls that would not change it
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  GLStateCache
+ *
+ *  This class shadows the OpenGL state that is changed while
+ *  rendering - the bound program, vertex array, textures,
+ *  enable bits and a few fixed function settings.  A call is
+ *  only passed on to OpenGL when it changes the state.  All
+ *  code that changes this state must go through the cache,
+ *  or call Invalidate() afterwards.
+ ***********************************************************/
+class GLStateCache
+{
+public:
+	// constructor
+	GLStateCache();
+
+	// number of texture units tracked by the cache
+	static const int MAX_TEXTURE_UNITS = 32;
+
+	// state change counters, accumulated until ResetStats()
+	struct STATE_STATS
+	{
+		// calls passed on to OpenGL
+		unsigned int issuedCalls = 0;
+		// calls skipped because the state already matched
+		unsigned int skippedCalls = 0;
+	};
+
+	void UseProgram(GLuint program);
+	void BindVertexArray(GLuint vertexArray);
+	// bind a texture to a texture unit (0 based, not GL_TEXTURE0 based)
+	void BindTexture(GLuint unit, GLenum target, GLuint texture);
+	// select the unit whose bound texture is edited - BindTexture()
+	// skips the unit switch when the texture is already bound
+	void ActiveTexture(GLuint unit);
+	void Enable(GLenum capability);
+	void Disable(GLenum capability);
+	void SetEnabled(GLenum capability, bool bEnabled);
+	void CullFace(GLenum mode);
+	void BlendFunc(GLenum sourceFactor, GLenum destinationFactor);
+
+	GLuint GetProgram() const { return m_program; }
+
+	// forget the shadowed state, e.g. after objects were deleted
+	void Invalidate();
+
+	// counters for state that is shadowed elsewhere (uniform values)
+	void CountIssued() { m_stats.issuedCalls++; }
+	void CountSkipped() { m_stats.skippedCalls++; }
+
+	const STATE_STATS& GetStats() const { return m_stats; }
+	void ResetStats() { m_stats = STATE_STATS(); }
+
+private:
+	// value used for state that was never set through the cache
+	static const GLuint UNKNOWN = 0xFFFFFFFFu;
+	// texture targets tracked per unit
+	static const int TEXTURE_TARGET_COUNT = 2;
+
+	GLuint m_program;
+	GLuint m_vertexArray;
+	GLuint m_activeTextureUnit;
+	GLuint m_textures[MAX_TEXTURE_UNITS][TEXTURE_TARGET_COUNT];
+	// enable bits that were set through the cache
+	std::vector<std::pair<GLenum, bool>> m_capabilities;
+	GLenum m_cullFaceMode;
+	GLenum m_blendSourceFactor;
+	GLenum m_blendDestinationFactor;
+
+	STATE_STATS m_stats;
+
+	// tracked slot of a texture target, -1 when not tracked
+	static int GetTargetIndex(GLenum target);
+};
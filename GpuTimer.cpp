@@ -0,0 +1,139 @@
+///////////////////////////////////////////////////////////////////////////////
+// gputimer.cpp
+// ============
+// measure the GPU time spent on a range of draw calls
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GpuTimer.h"
+
+/***********************************************************
+ *  GpuTimer()
+ *
+ *  The constructor for the class - the queries are created
+ *  on first use, once an OpenGL context exists.
+ ***********************************************************/
+GpuTimer::GpuTimer()
+{
+	for (int i = 0; i < QUERY_COUNT; ++i)
+	{
+		m_queries[i] = 0;
+		m_bPending[i] = false;
+	}
+	m_nextQuery = 0;
+	m_bRunning = false;
+	m_totalMs = 0.0;
+	m_sampleCount = 0;
+}
+
+/***********************************************************
+ *  ~GpuTimer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+GpuTimer::~GpuTimer()
+{
+	if (m_queries[0] != 0)
+	{
+		glDeleteQueries(QUERY_COUNT, m_queries);
+	}
+}
+
+/***********************************************************
+ *  Begin()
+ *
+ *  This method is used for starting a measurement.  When all
+ *  the queries are still waiting for the GPU the measurement
+ *  is skipped instead of blocking.
+ ***********************************************************/
+void GpuTimer::Begin()
+{
+	if (m_queries[0] == 0)
+	{
+		glGenQueries(QUERY_COUNT, m_queries);
+	}
+
+	CollectResults();
+	if (m_bPending[m_nextQuery])
+	{
+		return;
+	}
+
+	glBeginQuery(GL_TIME_ELAPSED, m_queries[m_nextQuery]);
+	m_bRunning = true;
+}
+
+/***********************************************************
+ *  End()
+ *
+ *  This method is used for ending the current measurement.
+ ***********************************************************/
+void GpuTimer::End()
+{
+	if (!m_bRunning)
+	{
+		return;
+	}
+
+	glEndQuery(GL_TIME_ELAPSED);
+	m_bRunning = false;
+	m_bPending[m_nextQuery] = true;
+	m_nextQuery = (m_nextQuery + 1) % QUERY_COUNT;
+}
+
+/***********************************************************
+ *  CollectResults()
+ *
+ *  This method is used for accumulating the results of the
+ *  queries that are available without waiting.
+ ***********************************************************/
+void GpuTimer::CollectResults()
+{
+	for (int i = 0; i < QUERY_COUNT; ++i)
+	{
+		if (!m_bPending[i])
+		{
+			continue;
+		}
+
+		GLint available = 0;
+		glGetQueryObjectiv(m_queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available == 0)
+		{
+			continue;
+		}
+
+		GLuint64 elapsedNs = 0;
+		glGetQueryObjectui64v(m_queries[i], GL_QUERY_RESULT, &elapsedNs);
+		m_bPending[i] = false;
+		m_totalMs += static_cast<double>(elapsedNs) / 1000000.0;
+		m_sampleCount++;
+	}
+}
+
+/***********************************************************
+ *  GetAverageMs()
+ *
+ *  This method is used for getting the average measured time.
+ ***********************************************************/
+double GpuTimer::GetAverageMs() const
+{
+	if (m_sampleCount == 0)
+	{
+		return 0.0;
+	}
+	return m_totalMs / m_sampleCount;
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This method is used for clearing the accumulated results.
+ ***********************************************************/
+void GpuTimer::Reset()
+{
+	m_totalMs = 0.0;
+	m_sampleCount = 0;
+}
@@ -0,0 +1,54 @@
+///////////////////////////////////////////////////////////////////////////////
+// gputimer.h
+// ============
+// measure the GPU time spent on a range of draw calls
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  GpuTimer
+ *
+ *  This class wraps GL_TIME_ELAPSED queries around a range
+ *  of draw calls.  Several queries are kept in flight and
+ *  only read back once the GPU reports them available, so
+ *  timing never stalls the pipeline.
+ ***********************************************************/
+class GpuTimer
+{
+public:
+	// constructor
+	GpuTimer();
+	// destructor
+	~GpuTimer();
+
+	// start and stop timing the draw calls issued in between
+	void Begin();
+	void End();
+
+	// average GPU time of the finished measurements in milliseconds
+	double GetAverageMs() const;
+	int GetSampleCount() const { return m_sampleCount; }
+	// forget the finished measurements
+	void Reset();
+
+private:
+	// number of queries in flight before a measurement is skipped
+	static const int QUERY_COUNT = 4;
+
+	GLuint m_queries[QUERY_COUNT];
+	bool m_bPending[QUERY_COUNT];
+	int m_nextQuery;
+	bool m_bRunning;
+
+	double m_totalMs;
+	int m_sampleCount;
+
+	// read back the results of the queries the GPU has finished
+	void CollectResults();
+};
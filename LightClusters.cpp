@@ -0,0 +1,441 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightclusters.cpp
+// ============
+// assign the point lights to the clusters of the view frustum they reach
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LightClusters.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+	// never spread the slices over more threads than this
+	const int MAX_THREADS = 8;
+}
+
+/***********************************************************
+ *  LightClusters()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+LightClusters::LightClusters(int threadCount)
+{
+	m_view = glm::mat4(0.0f);
+	m_projection = glm::mat4(0.0f);
+	m_bOrthographic = false;
+	m_nearPlane = 0.1f;
+	m_farPlane = 100.0f;
+	m_depthSliceScale = 0.0f;
+	m_depthSliceBias = 0.0f;
+	m_clusterMins.resize(CLUSTER_COUNT);
+	m_clusterMaxs.resize(CLUSTER_COUNT);
+	m_clusterLights.resize(static_cast<size_t>(CLUSTER_COUNT) * MAX_LIGHTS_PER_CLUSTER);
+	m_clusterLightCounts.resize(CLUSTER_COUNT, 0);
+	m_sliceDropped.resize(GRID_Z, 0);
+	m_clusters.resize(CLUSTER_COUNT);
+	m_generation = 0;
+	m_busyWorkers = 0;
+	m_bStopping = false;
+	m_nextSlice = 0;
+
+	threadCount = std::min(threadCount, MAX_THREADS);
+	for (int i = 0; i < threadCount; ++i)
+	{
+		m_workers.push_back(std::thread(&LightClusters::WorkerLoop, this));
+	}
+}
+
+/***********************************************************
+ *  ~LightClusters()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+LightClusters::~LightClusters()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStopping = true;
+	}
+	m_workReady.notify_all();
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+}
+
+/***********************************************************
+ *  GetDefaultThreadCount()
+ *
+ *  This method is used for getting the number of light
+ *  assignment threads to use on this machine.
+ ***********************************************************/
+int LightClusters::GetDefaultThreadCount()
+{
+	int threadCount = static_cast<int>(std::thread::hardware_concurrency()) - 1;
+	return std::min((threadCount > 1) ? threadCount : 1, MAX_THREADS);
+}
+
+/***********************************************************
+ *  SetCamera()
+ *
+ *  This method is used for setting the camera the clusters
+ *  follow.  The near and far planes are read back from the
+ *  projection matrix, and the cluster boxes only change
+ *  with the projection - moving the camera only moves the
+ *  lights relative to the clusters.
+ ***********************************************************/
+bool LightClusters::SetCamera(const glm::mat4& view, const glm::mat4& projection)
+{
+	bool bViewChanged = (view != m_view);
+	bool bProjectionChanged = (projection != m_projection);
+	m_view = view;
+	if (!bProjectionChanged)
+	{
+		return bViewChanged;
+	}
+	m_projection = projection;
+
+	// clip z = A * z + B (times -z for a perspective projection)
+	float a = projection[2][2];
+	float b = projection[3][2];
+	m_bOrthographic = (projection[3][3] == 1.0f);
+	if (m_bOrthographic)
+	{
+		m_nearPlane = (b + 1.0f) / a;
+		m_farPlane = (b - 1.0f) / a;
+	}
+	else
+	{
+		m_nearPlane = b / (a - 1.0f);
+		m_farPlane = b / (a + 1.0f);
+	}
+	m_nearPlane = std::max(m_nearPlane, 0.001f);
+	m_farPlane = std::max(m_farPlane, m_nearPlane * 2.0f);
+
+	float logRange = std::log(m_farPlane / m_nearPlane);
+	m_depthSliceScale = GRID_Z / logRange;
+	m_depthSliceBias = -GRID_Z * std::log(m_nearPlane) / logRange;
+	BuildClusterBounds();
+	return true;
+}
+
+/***********************************************************
+ *  GetSliceNear()
+ *
+ *  This method is used for getting the view depth a slice
+ *  starts at.  Each slice is the same factor deeper than
+ *  the one before, so clusters stay roughly cube shaped.
+ ***********************************************************/
+float LightClusters::GetSliceNear(int slice) const
+{
+	return m_nearPlane * std::pow(m_farPlane / m_nearPlane, static_cast<float>(slice) / GRID_Z);
+}
+
+/***********************************************************
+ *  GetDepthSlice()
+ *
+ *  This method is used for getting the slice of a view
+ *  depth, the way the fragment shader computes it.
+ ***********************************************************/
+int LightClusters::GetDepthSlice(float depth) const
+{
+	int slice = static_cast<int>(std::floor(std::log(std::max(depth, m_nearPlane)) * m_depthSliceScale + m_depthSliceBias));
+	return glm::clamp(slice, 0, GRID_Z - 1);
+}
+
+/***********************************************************
+ *  BuildClusterBounds()
+ *
+ *  This method is used for computing the view space box of
+ *  every cluster from the corners of its screen tile at the
+ *  near and far depth of its slice.
+ ***********************************************************/
+void LightClusters::BuildClusterBounds()
+{
+	const glm::mat4& projection = m_projection;
+	for (int z = 0; z < GRID_Z; ++z)
+	{
+		float depths[2] = { GetSliceNear(z), GetSliceNear(z + 1) };
+		for (int y = 0; y < GRID_Y; ++y)
+		{
+			for (int x = 0; x < GRID_X; ++x)
+			{
+				glm::vec3 boxMin(FLT_MAX);
+				glm::vec3 boxMax(-FLT_MAX);
+				for (int corner = 0; corner < 8; ++corner)
+				{
+					float ndcX = -1.0f + 2.0f * (x + (corner & 1)) / GRID_X;
+					float ndcY = -1.0f + 2.0f * (y + ((corner >> 1) & 1)) / GRID_Y;
+					float depth = depths[corner >> 2];
+					glm::vec3 point;
+					if (m_bOrthographic)
+					{
+						point.x = (ndcX - projection[3][0]) / projection[0][0];
+						point.y = (ndcY - projection[3][1]) / projection[1][1];
+					}
+					else
+					{
+						point.x = depth * (ndcX + projection[2][0]) / projection[0][0];
+						point.y = depth * (ndcY + projection[2][1]) / projection[1][1];
+					}
+					point.z = -depth;
+					boxMin = glm::min(boxMin, point);
+					boxMax = glm::max(boxMax, point);
+				}
+
+				int cluster = x + GRID_X * (y + GRID_Y * z);
+				m_clusterMins[cluster] = boxMin;
+				m_clusterMaxs[cluster] = boxMax;
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  ComputeLightBounds()
+ *
+ *  This method is used for finding the range of screen
+ *  tiles and depth slices a light can reach.  The corners
+ *  of the view space box around its sphere are projected to
+ *  the screen; a sphere reaching in front of the near plane
+ *  may cover any tile.
+ ***********************************************************/
+bool LightClusters::ComputeLightBounds(const LightManager::POINT_LIGHT& light, LIGHT_BOUNDS& bounds) const
+{
+	bounds.center = glm::vec3(m_view * glm::vec4(light.position, 1.0f));
+	bounds.radius = light.range;
+	bounds.bUnbounded = (light.range <= 0.0f);
+	bounds.minX = 0;
+	bounds.maxX = GRID_X - 1;
+	bounds.minY = 0;
+	bounds.maxY = GRID_Y - 1;
+	bounds.minZ = 0;
+	bounds.maxZ = GRID_Z - 1;
+	if (bounds.bUnbounded)
+	{
+		return true;
+	}
+
+	float minDepth = -bounds.center.z - bounds.radius;
+	float maxDepth = -bounds.center.z + bounds.radius;
+	if (maxDepth < m_nearPlane || minDepth > m_farPlane)
+	{
+		return false;
+	}
+	bounds.minZ = GetDepthSlice(minDepth);
+	bounds.maxZ = GetDepthSlice(std::min(maxDepth, m_farPlane));
+
+	if (!m_bOrthographic && minDepth <= m_nearPlane)
+	{
+		return true;
+	}
+
+	const glm::mat4& projection = m_projection;
+	glm::vec2 ndcMin(FLT_MAX);
+	glm::vec2 ndcMax(-FLT_MAX);
+	for (int corner = 0; corner < 8; ++corner)
+	{
+		glm::vec2 point(
+			bounds.center.x + ((corner & 1) ? bounds.radius : -bounds.radius),
+			bounds.center.y + ((corner & 2) ? bounds.radius : -bounds.radius));
+		glm::vec2 ndc;
+		if (m_bOrthographic)
+		{
+			ndc.x = projection[0][0] * point.x + projection[3][0];
+			ndc.y = projection[1][1] * point.y + projection[3][1];
+		}
+		else
+		{
+			float depth = (corner & 4) ? maxDepth : minDepth;
+			ndc.x = projection[0][0] * point.x / depth - projection[2][0];
+			ndc.y = projection[1][1] * point.y / depth - projection[2][1];
+		}
+		ndcMin = glm::min(ndcMin, ndc);
+		ndcMax = glm::max(ndcMax, ndc);
+	}
+	if (ndcMax.x < -1.0f || ndcMin.x > 1.0f || ndcMax.y < -1.0f || ndcMin.y > 1.0f)
+	{
+		return false;
+	}
+
+	bounds.minX = glm::clamp(static_cast<int>(std::floor((ndcMin.x * 0.5f + 0.5f) * GRID_X)), 0, GRID_X - 1);
+	bounds.maxX = glm::clamp(static_cast<int>(std::floor((ndcMax.x * 0.5f + 0.5f) * GRID_X)), 0, GRID_X - 1);
+	bounds.minY = glm::clamp(static_cast<int>(std::floor((ndcMin.y * 0.5f + 0.5f) * GRID_Y)), 0, GRID_Y - 1);
+	bounds.maxY = glm::clamp(static_cast<int>(std::floor((ndcMax.y * 0.5f + 0.5f) * GRID_Y)), 0, GRID_Y - 1);
+	return true;
+}
+
+/***********************************************************
+ *  AssignLights()
+ *
+ *  This method is used for listing the lights reaching each
+ *  cluster.  The screen and depth range of every light is
+ *  found up front; then the depth slices are shared out to
+ *  the worker threads, each filling the fixed size lists of
+ *  the clusters in its slices, and the lists are packed
+ *  into one light index list for the shader.
+ ***********************************************************/
+void LightClusters::AssignLights(const std::vector<LightManager::POINT_LIGHT>& lights)
+{
+	auto startTime = std::chrono::steady_clock::now();
+
+	m_lightBounds.clear();
+	for (size_t i = 0; i < lights.size(); ++i)
+	{
+		LIGHT_BOUNDS bounds;
+		bounds.lightIndex = static_cast<GLuint>(i);
+		if (ComputeLightBounds(lights[i], bounds))
+		{
+			m_lightBounds.push_back(bounds);
+		}
+	}
+
+	m_nextSlice = 0;
+	if (m_workers.empty())
+	{
+		AssignSlices();
+	}
+	else
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_busyWorkers = static_cast<int>(m_workers.size());
+			m_generation++;
+		}
+		m_workReady.notify_all();
+		// the calling thread takes slices as well
+		AssignSlices();
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_workDone.wait(lock, [this] { return m_busyWorkers == 0; });
+	}
+
+	m_lightIndices.clear();
+	unsigned int maxClusterLights = 0;
+	for (int cluster = 0; cluster < CLUSTER_COUNT; ++cluster)
+	{
+		GLuint count = m_clusterLightCounts[cluster];
+		m_clusters[cluster].offset = static_cast<GLuint>(m_lightIndices.size());
+		m_clusters[cluster].count = count;
+		const GLuint* pLights = &m_clusterLights[static_cast<size_t>(cluster) * MAX_LIGHTS_PER_CLUSTER];
+		m_lightIndices.insert(m_lightIndices.end(), pLights, pLights + count);
+		maxClusterLights = std::max(maxClusterLights, static_cast<unsigned int>(count));
+	}
+	for (unsigned int dropped : m_sliceDropped)
+	{
+		m_stats.droppedLights += dropped;
+	}
+
+	m_stats.assignments++;
+	m_stats.assignMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	m_stats.listedLights += m_lightIndices.size();
+	m_stats.maxClusterLights = std::max(m_stats.maxClusterLights, maxClusterLights);
+}
+
+/***********************************************************
+ *  AssignSlices()
+ *
+ *  This method is used for taking depth slices that no
+ *  thread took yet until none are left.
+ ***********************************************************/
+void LightClusters::AssignSlices()
+{
+	for (;;)
+	{
+		int slice = m_nextSlice.fetch_add(1);
+		if (slice >= GRID_Z)
+		{
+			return;
+		}
+		AssignSlice(slice);
+	}
+}
+
+/***********************************************************
+ *  AssignSlice()
+ *
+ *  This method is used for filling the light lists of the
+ *  clusters of one depth slice.  Within the tiles a light
+ *  covers, its sphere is tested against each cluster box,
+ *  which drops the clusters in the corners of its square.
+ *  Only this thread writes the lists of the slice.
+ ***********************************************************/
+void LightClusters::AssignSlice(int slice)
+{
+	int firstCluster = GRID_X * GRID_Y * slice;
+	std::fill(m_clusterLightCounts.begin() + firstCluster,
+		m_clusterLightCounts.begin() + firstCluster + GRID_X * GRID_Y, 0);
+	unsigned int dropped = 0;
+
+	for (const LIGHT_BOUNDS& bounds : m_lightBounds)
+	{
+		if (slice < bounds.minZ || slice > bounds.maxZ)
+		{
+			continue;
+		}
+
+		float radiusSquared = bounds.radius * bounds.radius;
+		for (int y = bounds.minY; y <= bounds.maxY; ++y)
+		{
+			for (int x = bounds.minX; x <= bounds.maxX; ++x)
+			{
+				int cluster = firstCluster + x + GRID_X * y;
+				if (!bounds.bUnbounded)
+				{
+					glm::vec3 closest = glm::clamp(bounds.center, m_clusterMins[cluster], m_clusterMaxs[cluster]);
+					glm::vec3 offset = closest - bounds.center;
+					if (glm::dot(offset, offset) > radiusSquared)
+					{
+						continue;
+					}
+				}
+
+				GLuint& count = m_clusterLightCounts[cluster];
+				if (count >= MAX_LIGHTS_PER_CLUSTER)
+				{
+					dropped++;
+					continue;
+				}
+				m_clusterLights[static_cast<size_t>(cluster) * MAX_LIGHTS_PER_CLUSTER + count] = bounds.lightIndex;
+				count++;
+			}
+		}
+	}
+	m_sliceDropped[slice] = dropped;
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is used for running a worker thread, which
+ *  waits for the next assignment and helps with its slices.
+ ***********************************************************/
+void LightClusters::WorkerLoop()
+{
+	unsigned int generation = 0;
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for (;;)
+	{
+		m_workReady.wait(lock, [this, generation] { return m_bStopping || m_generation != generation; });
+		if (m_bStopping)
+		{
+			return;
+		}
+		generation = m_generation;
+
+		lock.unlock();
+		AssignSlices();
+		lock.lock();
+
+		if (--m_busyWorkers == 0)
+		{
+			m_workDone.notify_one();
+		}
+	}
+}
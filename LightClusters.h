@@ -0,0 +1,156 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightclusters.h
+// ============
+// assign the point lights to the clusters of the view frustum they reach
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "LightManager.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  LightClusters
+ *
+ *  This class splits the view frustum into a grid of
+ *  clusters - tiles across the screen, and slices in depth
+ *  that grow exponentially with the distance - and lists
+ *  the point lights whose sphere of influence reaches each
+ *  cluster.  The fragment shader finds its cluster from its
+ *  screen position and depth, and only shades the lights of
+ *  that list, so the cost per fragment depends on the lights
+ *  nearby rather than on all the lights of the scene.  The
+ *  depth slices are shared out to a pool of worker threads.
+ *  The class makes no OpenGL calls - the caller uploads the
+ *  clusters and the light index list.
+ ***********************************************************/
+class LightClusters
+{
+public:
+	// must match CLUSTER_GRID_X/Y/Z in the fragment shader
+	static const int GRID_X = 16;
+	static const int GRID_Y = 9;
+	static const int GRID_Z = 24;
+	static const int CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+	// lights listed per cluster, the rest are dropped and counted
+	static const int MAX_LIGHTS_PER_CLUSTER = 128;
+
+	// the light list of a cluster in the light index list - the std430
+	// layout of the uvec2 entries of the ClusterBlock
+	struct CLUSTER
+	{
+		GLuint offset;
+		GLuint count;
+	};
+
+	// light assignment counters, accumulated until ResetStats()
+	struct CLUSTER_STATS
+	{
+		unsigned int assignments = 0;
+		double assignMs = 0.0;
+		size_t listedLights = 0;
+		unsigned int maxClusterLights = 0;
+		unsigned int droppedLights = 0;
+	};
+
+	// constructor - with no worker threads the slices are
+	// assigned on the calling thread
+	explicit LightClusters(int threadCount);
+	// destructor
+	~LightClusters();
+
+	// one worker per core, leaving a core for the OpenGL thread
+	static int GetDefaultThreadCount();
+
+	// camera the clusters are laid out for, the lights have to be
+	// assigned again when this returns true
+	bool SetCamera(const glm::mat4& view, const glm::mat4& projection);
+	// list the lights reaching every cluster
+	void AssignLights(const std::vector<LightManager::POINT_LIGHT>& lights);
+
+	const std::vector<CLUSTER>& GetClusters() const { return m_clusters; }
+	const std::vector<GLuint>& GetLightIndices() const { return m_lightIndices; }
+	// the depth slice of a view depth d is log(d) * scale + bias
+	float GetDepthSliceScale() const { return m_depthSliceScale; }
+	float GetDepthSliceBias() const { return m_depthSliceBias; }
+	int GetThreadCount() const { return static_cast<int>(m_workers.size()); }
+
+	const CLUSTER_STATS& GetStats() const { return m_stats; }
+	void ResetStats() { m_stats = CLUSTER_STATS(); }
+
+private:
+	// view space sphere of a light and the clusters its box covers
+	struct LIGHT_BOUNDS
+	{
+		// index of the light in the uploaded light buffer
+		GLuint lightIndex;
+		glm::vec3 center;
+		float radius;
+		// lights without a range reach every cluster untested
+		bool bUnbounded;
+		int minX;
+		int maxX;
+		int minY;
+		int maxY;
+		int minZ;
+		int maxZ;
+	};
+
+	glm::mat4 m_view;
+	glm::mat4 m_projection;
+	bool m_bOrthographic;
+	float m_nearPlane;
+	float m_farPlane;
+	float m_depthSliceScale;
+	float m_depthSliceBias;
+	// view space box of every cluster
+	std::vector<glm::vec3> m_clusterMins;
+	std::vector<glm::vec3> m_clusterMaxs;
+
+	// lights of the current assignment
+	std::vector<LIGHT_BOUNDS> m_lightBounds;
+	// fixed size light list of every cluster, filled by the slices
+	std::vector<GLuint> m_clusterLights;
+	std::vector<GLuint> m_clusterLightCounts;
+	std::vector<unsigned int> m_sliceDropped;
+	// compacted result
+	std::vector<CLUSTER> m_clusters;
+	std::vector<GLuint> m_lightIndices;
+
+	std::vector<std::thread> m_workers;
+	std::mutex m_mutex;
+	std::condition_variable m_workReady;
+	std::condition_variable m_workDone;
+	unsigned int m_generation;
+	int m_busyWorkers;
+	bool m_bStopping;
+	std::atomic<int> m_nextSlice;
+
+	CLUSTER_STATS m_stats;
+
+	// view depth range of a depth slice
+	float GetSliceNear(int slice) const;
+	// depth slice holding a view depth
+	int GetDepthSlice(float depth) const;
+	// recompute the view space boxes of the clusters
+	void BuildClusterBounds();
+	// the screen tiles and depth slices a light covers, false when
+	// it reaches no cluster
+	bool ComputeLightBounds(const LightManager::POINT_LIGHT& light, LIGHT_BOUNDS& bounds) const;
+	// assign the lights to the clusters of the slices not taken yet
+	void AssignSlices();
+	void AssignSlice(int slice);
+	// worker thread body
+	void WorkerLoop();
+};
@@ -0,0 +1,339 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightmanager.cpp
+// ============
+// manage the scene light sources stored in the shader lighting uniform block
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LightManager.h"
+
+#include <cstring>
+
+// the byte offsets must match the std140 layout of the LightBlock
+static_assert(sizeof(LightManager::DIRECTIONAL_LIGHT) == 64, "DirectionalLight std140 size mismatch");
+static_assert(sizeof(LightManager::POINT_LIGHT) == 64, "PointLight std140 size mismatch");
+static_assert(sizeof(LightManager::SPOT_LIGHT) == 96, "SpotLight std140 size mismatch");
+static_assert(offsetof(LightManager::POINT_LIGHT, range) == 12, "PointLight.range std140 offset mismatch");
+static_assert(offsetof(LightManager::SPOT_LIGHT, cutOff) == 28, "SpotLight.cutOff std140 offset mismatch");
+static_assert(offsetof(LightManager::SPOT_LIGHT, ambient) == 48, "SpotLight.ambient std140 offset mismatch");
+static_assert(offsetof(LightManager::LIGHT_BLOCK, pointLights) == 64, "LightBlock.pointLights std140 offset mismatch");
+static_assert(offsetof(LightManager::LIGHT_BLOCK, spotLight) == 384, "LightBlock.spotLight std140 offset mismatch");
+
+/***********************************************************
+ *  LightManager()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+LightManager::LightManager()
+{
+	m_lightBuffer = 0;
+	// all lights start out zeroed and inactive
+	memset(&m_lightBlock, 0, sizeof(m_lightBlock));
+	m_activePointLights = 0;
+	m_bPointLightsDirty = false;
+	m_pointLightVersion = 0;
+	m_dirtyBegin = 0;
+	m_dirtyEnd = sizeof(m_lightBlock);
+}
+
+/***********************************************************
+ *  ~LightManager()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+LightManager::~LightManager()
+{
+	DestroyLightBuffer();
+}
+
+/***********************************************************
+ *  CreateLightBuffer()
+ *
+ *  This method is used for creating the uniform buffer that
+ *  backs the LightBlock and attaching it to its binding point.
+ ***********************************************************/
+void LightManager::CreateLightBuffer()
+{
+	if (m_lightBuffer != 0)
+	{
+		return;
+	}
+
+	glGenBuffers(1, &m_lightBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_lightBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(m_lightBlock), &m_lightBlock, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, LIGHT_BLOCK_BINDING, m_lightBuffer);
+
+	// the whole block was just uploaded
+	m_dirtyBegin = sizeof(m_lightBlock);
+	m_dirtyEnd = 0;
+}
+
+/***********************************************************
+ *  DestroyLightBuffer()
+ *
+ *  This method is used for freeing the light uniform buffer.
+ ***********************************************************/
+void LightManager::DestroyLightBuffer()
+{
+	if (m_lightBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_lightBuffer);
+		m_lightBuffer = 0;
+	}
+}
+
+/***********************************************************
+ *  WriteLight()
+ *
+ *  This method is used for copying a light into the light
+ *  block, widening the dirty range only when bytes changed.
+ ***********************************************************/
+void LightManager::WriteLight(void* destination, const void* source, size_t size)
+{
+	if (memcmp(destination, source, size) == 0)
+	{
+		return;
+	}
+
+	memcpy(destination, source, size);
+
+	size_t begin = static_cast<const char*>(destination) - reinterpret_cast<const char*>(&m_lightBlock);
+	size_t end = begin + size;
+	if (begin < m_dirtyBegin)
+	{
+		m_dirtyBegin = begin;
+	}
+	if (end > m_dirtyEnd)
+	{
+		m_dirtyEnd = end;
+	}
+}
+
+/***********************************************************
+ *  SetDirectionalLight()
+ *
+ *  This method is used for defining the directional light.
+ ***********************************************************/
+void LightManager::SetDirectionalLight(
+	glm::vec3 direction,
+	glm::vec3 ambient,
+	glm::vec3 diffuse,
+	glm::vec3 specular,
+	bool bActive)
+{
+	DIRECTIONAL_LIGHT light;
+	memset(&light, 0, sizeof(light));
+	light.direction = direction;
+	light.ambient = ambient;
+	light.diffuse = diffuse;
+	light.specular = specular;
+	light.bActive = bActive ? 1 : 0;
+
+	WriteLight(&m_lightBlock.directionalLight, &light, sizeof(light));
+}
+
+/***********************************************************
+ *  ClearDirectionalLight()
+ *
+ *  This method is used for removing the directional light,
+ *  before a scene defines its own.
+ ***********************************************************/
+void LightManager::ClearDirectionalLight()
+{
+	DIRECTIONAL_LIGHT light;
+	memset(&light, 0, sizeof(light));
+
+	WriteLight(&m_lightBlock.directionalLight, &light, sizeof(light));
+}
+
+/***********************************************************
+ *  SetPointLight()
+ *
+ *  This method is used for defining one of the point lights.
+ ***********************************************************/
+void LightManager::SetPointLight(
+	int index,
+	glm::vec3 position,
+	glm::vec3 ambient,
+	glm::vec3 diffuse,
+	glm::vec3 specular,
+	float range,
+	bool bActive)
+{
+	if (index < 0 || index >= MAX_POINT_LIGHTS)
+	{
+		return;
+	}
+
+	POINT_LIGHT light;
+	memset(&light, 0, sizeof(light));
+	light.position = position;
+	light.range = range;
+	light.ambient = ambient;
+	light.diffuse = diffuse;
+	light.specular = specular;
+	light.bActive = bActive ? 1 : 0;
+
+	if (index >= static_cast<int>(m_pointLights.size()))
+	{
+		POINT_LIGHT unused;
+		memset(&unused, 0, sizeof(unused));
+		m_pointLights.resize(index + 1, unused);
+	}
+	m_pointLights[index] = light;
+	m_bPointLightsDirty = true;
+}
+
+/***********************************************************
+ *  SetPointLightActive()
+ *
+ *  This method is used for turning a point light on or off
+ *  without changing the rest of its definition.
+ ***********************************************************/
+void LightManager::SetPointLightActive(int index, bool bActive)
+{
+	if (index < 0 || index >= static_cast<int>(m_pointLights.size()))
+	{
+		return;
+	}
+
+	m_pointLights[index].bActive = bActive ? 1 : 0;
+	m_bPointLightsDirty = true;
+}
+
+/***********************************************************
+ *  ClearPointLights()
+ *
+ *  This method is used for removing all the point lights,
+ *  before a scene defines its own.
+ ***********************************************************/
+void LightManager::ClearPointLights()
+{
+	m_pointLights.clear();
+	m_bPointLightsDirty = true;
+}
+
+/***********************************************************
+ *  PackPointLights()
+ *
+ *  This method is used for collecting the active point
+ *  lights once they changed, and writing the first of them
+ *  to the front of the light block, so a shader compiled for
+ *  N point lights only has to loop over the first N entries.
+ *  The remaining entries are cleared and marked inactive.
+ ***********************************************************/
+void LightManager::PackPointLights()
+{
+	m_activeLights.clear();
+	for (const POINT_LIGHT& light : m_pointLights)
+	{
+		if (light.bActive != 0)
+		{
+			m_activeLights.push_back(light);
+		}
+	}
+
+	POINT_LIGHT packedLights[TOTAL_POINT_LIGHTS];
+	memset(packedLights, 0, sizeof(packedLights));
+	int activeCount = 0;
+	for (; activeCount < TOTAL_POINT_LIGHTS && activeCount < static_cast<int>(m_activeLights.size()); ++activeCount)
+	{
+		packedLights[activeCount] = m_activeLights[activeCount];
+	}
+
+	for (int i = 0; i < TOTAL_POINT_LIGHTS; ++i)
+	{
+		WriteLight(&m_lightBlock.pointLights[i], &packedLights[i], sizeof(POINT_LIGHT));
+	}
+	m_activePointLights = activeCount;
+	m_bPointLightsDirty = false;
+	m_pointLightVersion++;
+}
+
+/***********************************************************
+ *  SetSpotLight()
+ *
+ *  This method is used for defining the spot light.
+ ***********************************************************/
+void LightManager::SetSpotLight(
+	glm::vec3 position,
+	glm::vec3 direction,
+	float cutOff,
+	float outerCutOff,
+	float constant,
+	float linear,
+	float quadratic,
+	glm::vec3 ambient,
+	glm::vec3 diffuse,
+	glm::vec3 specular,
+	bool bActive)
+{
+	SPOT_LIGHT light;
+	memset(&light, 0, sizeof(light));
+	light.position = position;
+	light.direction = direction;
+	light.cutOff = cutOff;
+	light.outerCutOff = outerCutOff;
+	light.constant = constant;
+	light.linear = linear;
+	light.quadratic = quadratic;
+	light.ambient = ambient;
+	light.diffuse = diffuse;
+	light.specular = specular;
+	light.bActive = bActive ? 1 : 0;
+
+	WriteLight(&m_lightBlock.spotLight, &light, sizeof(light));
+}
+
+/***********************************************************
+ *  ClearSpotLight()
+ *
+ *  This method is used for removing the spot light, before
+ *  a scene defines its own.
+ ***********************************************************/
+void LightManager::ClearSpotLight()
+{
+	SPOT_LIGHT light;
+	memset(&light, 0, sizeof(light));
+
+	WriteLight(&m_lightBlock.spotLight, &light, sizeof(light));
+}
+
+/***********************************************************
+ *  UploadLights()
+ *
+ *  This method is used for sending the changed byte range of
+ *  the light block to the uniform buffer.  Nothing is sent
+ *  when no light changed since the previous upload.  Point
+ *  lights are packed here rather than on every change, so
+ *  defining hundreds of them packs them only once.
+ ***********************************************************/
+void LightManager::UploadLights()
+{
+	if (m_bPointLightsDirty)
+	{
+		PackPointLights();
+	}
+	if (m_lightBuffer == 0 || m_dirtyBegin >= m_dirtyEnd)
+	{
+		return;
+	}
+
+	glBindBuffer(GL_UNIFORM_BUFFER, m_lightBuffer);
+	glBufferSubData(
+		GL_UNIFORM_BUFFER,
+		static_cast<GLintptr>(m_dirtyBegin),
+		static_cast<GLsizeiptr>(m_dirtyEnd - m_dirtyBegin),
+		reinterpret_cast<const char*>(&m_lightBlock) + m_dirtyBegin);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	m_stats.uploads++;
+	m_stats.uploadedBytes += static_cast<unsigned int>(m_dirtyEnd - m_dirtyBegin);
+
+	m_dirtyBegin = sizeof(m_lightBlock);
+	m_dirtyEnd = 0;
+}
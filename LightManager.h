@@ -0,0 +1,195 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightmanager.h
+// ============
+// manage the scene light sources stored in the shader lighting uniform block
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  LightManager
+ *
+ *  This class keeps a CPU copy of the std140 "LightBlock"
+ *  uniform block declared in the fragment shader and uploads
+ *  only the byte ranges that changed since the last upload.
+ *  Any number of point lights can be defined; the block only
+ *  holds the first TOTAL_POINT_LIGHTS active ones, for the
+ *  shaders that do not cull the lights into clusters.
+ ***********************************************************/
+class LightManager
+{
+public:
+	// constructor
+	LightManager();
+	// destructor
+	~LightManager();
+
+	// uniform buffer binding point used by the LightBlock
+	static const GLuint LIGHT_BLOCK_BINDING = 0;
+	// must match TOTAL_POINT_LIGHTS in the fragment shader - the point
+	// lights of the light block
+	static const int TOTAL_POINT_LIGHTS = 5;
+	// point light indices that can be defined
+	static const int MAX_POINT_LIGHTS = 4096;
+
+	// the structs below mirror the std140 layout of the light
+	// structs in the fragment shader - vec3 members are aligned
+	// to 16 bytes and the bool flags are stored as 4 byte ints
+	struct DIRECTIONAL_LIGHT
+	{
+		glm::vec3 direction;
+		float padding0;
+		glm::vec3 ambient;
+		float padding1;
+		glm::vec3 diffuse;
+		float padding2;
+		glm::vec3 specular;
+		int bActive;
+	};
+
+	// also the std430 layout of the clustered point light buffer
+	struct POINT_LIGHT
+	{
+		glm::vec3 position;
+		// distance the light fades out at, 0 reaches everything
+		float range;
+		glm::vec3 ambient;
+		float padding1;
+		glm::vec3 diffuse;
+		float padding2;
+		glm::vec3 specular;
+		int bActive;
+	};
+
+	struct SPOT_LIGHT
+	{
+		glm::vec3 position;
+		float padding0;
+		glm::vec3 direction;
+		float cutOff;
+		float outerCutOff;
+		float constant;
+		float linear;
+		float quadratic;
+		glm::vec3 ambient;
+		float padding1;
+		glm::vec3 diffuse;
+		float padding2;
+		glm::vec3 specular;
+		int bActive;
+	};
+
+	struct LIGHT_BLOCK
+	{
+		DIRECTIONAL_LIGHT directionalLight;
+		POINT_LIGHT pointLights[TOTAL_POINT_LIGHTS];
+		SPOT_LIGHT spotLight;
+	};
+
+	// light buffer upload counters, accumulated until ResetStats()
+	struct LIGHT_STATS
+	{
+		unsigned int uploads = 0;
+		unsigned int uploadedBytes = 0;
+	};
+
+	// create the uniform buffer and attach it to its binding point
+	void CreateLightBuffer();
+	// free the uniform buffer
+	void DestroyLightBuffer();
+
+	// define the directional light
+	void SetDirectionalLight(
+		glm::vec3 direction,
+		glm::vec3 ambient,
+		glm::vec3 diffuse,
+		glm::vec3 specular,
+		bool bActive = true);
+	// turn the directional light off
+	void ClearDirectionalLight();
+
+	// define one of the point lights
+	void SetPointLight(
+		int index,
+		glm::vec3 position,
+		glm::vec3 ambient,
+		glm::vec3 diffuse,
+		glm::vec3 specular,
+		float range = 0.0f,
+		bool bActive = true);
+
+	// turn one of the point lights on or off
+	void SetPointLightActive(int index, bool bActive);
+	// forget every point light
+	void ClearPointLights();
+
+	// define the spot light
+	void SetSpotLight(
+		glm::vec3 position,
+		glm::vec3 direction,
+		float cutOff,
+		float outerCutOff,
+		float constant,
+		float linear,
+		float quadratic,
+		glm::vec3 ambient,
+		glm::vec3 diffuse,
+		glm::vec3 specular,
+		bool bActive = true);
+	// turn the spot light off
+	void ClearSpotLight();
+
+	// upload the changed part of the light block, if any
+	void UploadLights();
+
+	// active light sources, used to pick the matching shader permutation
+	bool IsDirectionalLightActive() const { return m_lightBlock.directionalLight.bActive != 0; }
+	// active point lights in the light block, at most TOTAL_POINT_LIGHTS
+	int GetActivePointLightCount() const { return m_activePointLights; }
+	bool IsSpotLightActive() const { return m_lightBlock.spotLight.bActive != 0; }
+	// the lights that cast shadows, used to place the shadow maps
+	const DIRECTIONAL_LIGHT& GetDirectionalLight() const { return m_lightBlock.directionalLight; }
+	const SPOT_LIGHT& GetSpotLight() const { return m_lightBlock.spotLight; }
+
+	// every active point light, in index order - up to date after UploadLights()
+	const std::vector<POINT_LIGHT>& GetActivePointLights() const { return m_activeLights; }
+	// indices in use, the next free index is this count
+	int GetPointLightSlotCount() const { return static_cast<int>(m_pointLights.size()); }
+	// changes whenever a point light changes
+	unsigned int GetPointLightVersion() const { return m_pointLightVersion; }
+
+	const LIGHT_STATS& GetStats() const { return m_stats; }
+	void ResetStats() { m_stats = LIGHT_STATS(); }
+
+private:
+	// uniform buffer object holding the light block
+	GLuint m_lightBuffer;
+	// CPU copy of the light block
+	LIGHT_BLOCK m_lightBlock;
+	// point lights by index - the block holds the active ones packed first
+	std::vector<POINT_LIGHT> m_pointLights;
+	std::vector<POINT_LIGHT> m_activeLights;
+	int m_activePointLights;
+	// point lights changed since they were last packed
+	bool m_bPointLightsDirty;
+	unsigned int m_pointLightVersion;
+	// byte range of the light block changed since the last upload
+	size_t m_dirtyBegin;
+	size_t m_dirtyEnd;
+
+	LIGHT_STATS m_stats;
+
+	// copy a light into the block and mark its bytes dirty if they changed
+	void WriteLight(void* destination, const void* source, size_t size);
+	// copy the active point lights to the front of the block
+	void PackPointLights();
+};
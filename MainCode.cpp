@@ -24,8 +24,28 @@
 #include "ViewManager.h"
 #include "ShapeMeshes.h"
 #include "ShaderManager.h"
+#include "FileWatcher.h"
+#include "TransformStore.h"
+#include "BoundingVolumeHierarchy.h"
+#include "FrustumCuller.h"
 #include "sw_version.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
 // Namespace for declaring global variables
 namespace
 {
@@ -41,12 +61,58 @@ namespace
 	ShaderManager* g_ShaderManager = nullptr;
 	// view manager object for managing the 3D view setup and projection to 2D
 	ViewManager* g_ViewManager = nullptr;
+	// file watcher object for hot reloading changed shaders and textures
+	FileWatcher* g_FileWatcher = nullptr;
+
+	// number of seconds between the periodic frame statistics reports
+	const double STATS_REPORT_INTERVAL = 5.0;
+
+	// options passed on the command line
+	struct COMMAND_LINE_OPTIONS
+	{
+		// compile specialized shader permutations instead of branching
+		bool bShaderPermutations = true;
+		// run the transform micro-benchmark and exit
+		bool bBenchmarkTransforms = false;
+		// run the bounding volume hierarchy benchmark and exit
+		bool bBenchmarkBvh = false;
+		// threads decoding the texture images, 0 decodes them in turn
+		int textureThreads = TextureLoader::GetDefaultThreadCount();
+		// load BC1/BC3 textures from the compressed texture cache
+		bool bTextureCache = true;
+		// megabytes of texture mip levels uploaded per frame, 0 loads
+		// every texture before the first frame
+		int textureBudgetMB = 8;
+		// megabytes of video memory the textures are kept under by
+		// dropping mip levels, 0 only drops the levels not needed
+		int textureMemoryMB = 0;
+		// point lights added over the ceiling of the scene
+		int generatedLights = 0;
+		// threads assigning the point lights to the view clusters
+		int lightThreads = LightClusters::GetDefaultThreadCount();
+		// shade the opaque objects in a light pass over a G-buffer
+		bool bDeferredShading = false;
+		// time the forward and deferred pipelines on the scene and exit
+		bool bBenchmarkPipelines = false;
+	};
+	COMMAND_LINE_OPTIONS g_Options;
 }
 
 // Function declarations - all functions that are called manually
 // need to be pre-declared at the beginning of the source code.
+bool ParseCommandLine(int argc, char* argv[]);
+void BenchmarkTransforms();
+void BenchmarkBvh();
+void BenchmarkPipelines();
+void RenderFrame();
 bool InitializeGLFW();
 bool InitializeGLEW();
+void ReportFrameStats(int frameCount);
+void PickClickedObject();
+void ProcessChangedFiles();
+bool HasExtension(const std::string& filename, const std::string& extension);
+bool IsImageFile(const std::string& filename);
+double GetPeakMemoryMB();
 
 
 /***********************************************************
@@ -57,6 +123,25 @@ bool InitializeGLEW();
  ***********************************************************/
 int main(int argc, char* argv[])
 {
+	if (ParseCommandLine(argc, argv) == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	// the benchmarks run on the CPU only, no window is needed
+	if (g_Options.bBenchmarkTransforms || g_Options.bBenchmarkBvh)
+	{
+		if (g_Options.bBenchmarkTransforms)
+		{
+			BenchmarkTransforms();
+		}
+		if (g_Options.bBenchmarkBvh)
+		{
+			BenchmarkBvh();
+		}
+		return(EXIT_SUCCESS);
+	}
+
 	// if GLFW fails initialization, then terminate the application
 	if (InitializeGLFW() == false)
 	{
@@ -81,6 +166,7 @@ int main(int argc, char* argv[])
 	}
 
 	// load the shader code from the external GLSL files
+	g_ShaderManager->SetPermutationsEnabled(g_Options.bShaderPermutations);
 	g_ShaderManager->LoadShaders(
 		"shaders/vertexShader.glsl",
 		"shaders/fragmentShader.glsl");
@@ -88,34 +174,78 @@ int main(int argc, char* argv[])
 
 	// try to create a new scene manager object and prepare the 3D scene
 	g_SceneManager = new SceneManager(g_ShaderManager);
+	g_SceneManager->SetTextureThreads(g_Options.textureThreads);
+	g_SceneManager->SetCompressedTextures(g_Options.bTextureCache);
+	g_SceneManager->SetTextureUploadBudget((size_t)g_Options.textureBudgetMB * 1024 * 1024);
+	g_SceneManager->SetTextureMemoryBudget((size_t)g_Options.textureMemoryMB * 1024 * 1024);
+	g_SceneManager->SetGeneratedLights(g_Options.generatedLights);
+	g_SceneManager->SetLightThreads(g_Options.lightThreads);
+	g_SceneManager->SetDeferredShading(g_Options.bDeferredShading);
 	g_SceneManager->PrepareScene();
 
+	// watch the asset directories so edited shaders and textures
+	// are reloaded without restarting the application
+	g_FileWatcher = new FileWatcher();
+	g_FileWatcher->WatchDirectory("shaders");
+	g_FileWatcher->WatchDirectory("textures");
+	g_FileWatcher->WatchDirectory("scenes");
+
+	std::cout << "INFO: Startup completed in " << glfwGetTime() * 1000.0 << " ms, peak memory "
+		<< GetPeakMemoryMB() << " MB" << std::endl;
+
+	// the pipeline benchmark takes over the window instead of the render loop
+	if (g_Options.bBenchmarkPipelines)
+	{
+		BenchmarkPipelines();
+		glfwSetWindowShouldClose(g_Window, true);
+	}
+
+	// frame statistics are averaged over each report interval
+	int statsFrameCount = 0;
+	double statsStartTime = glfwGetTime();
+	bool bFirstFrame = true;
+	g_ShaderManager->ResetStats();
+	g_ShaderManager->GetStateCache()->ResetStats();
+
 	// loop will keep running until the application is closed 
 	// or until an error has occurred
 	while (!glfwWindowShouldClose(g_Window))
 	{
-		// Enable z-depth
-		glEnable(GL_DEPTH_TEST);
-
-		// Clear the frame and z buffers
-		glClearColor(0.93f, 0.90f, 0.82f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		// reload any shaders or textures edited since the last frame
+		ProcessChangedFiles();
 
-		// convert from 3D object space to 2D view
-		g_ViewManager->PrepareSceneView();
-
-		// refresh the 3D scene
-		g_SceneManager->RenderScene();
+		RenderFrame();
 
+		// select the object under the cursor of a left click
+		PickClickedObject();
 
 		// Flips the the back buffer with the front buffer every frame.
 		glfwSwapBuffers(g_Window);
+		if (bFirstFrame)
+		{
+			std::cout << "INFO: First frame presented after " << glfwGetTime() * 1000.0 << " ms" << std::endl;
+			bFirstFrame = false;
+		}
 
 		// query the latest GLFW events
 		glfwPollEvents();
+
+		// periodically report the averaged per-frame statistics
+		statsFrameCount++;
+		if (glfwGetTime() - statsStartTime >= STATS_REPORT_INTERVAL)
+		{
+			ReportFrameStats(statsFrameCount);
+			statsFrameCount = 0;
+			statsStartTime = glfwGetTime();
+		}
 	}
 
 	// clear the allocated manager objects from memory
+	if (NULL != g_FileWatcher)
+	{
+		delete g_FileWatcher;
+		g_FileWatcher = NULL;
+	}
 	if (NULL != g_SceneManager)
 	{
 		delete g_SceneManager;
@@ -136,6 +266,395 @@ int main(int argc, char* argv[])
 	exit(EXIT_SUCCESS); 
 }
 
+/***********************************************************
+ *	ParseCommandLine()
+ *
+ *  This function is used to read the command line options.
+ *    --no-permutations   branch on the shader feature uniforms
+ *                        instead of compiling permutations
+ *    --bench-transforms  compare cached and rebuilt model
+ *                        matrices, then exit
+ *    --bench-bvh         time building, refitting and querying
+ *                        the bounding volume hierarchy, then exit
+ *    --texture-threads=N decode the texture images on N worker
+ *                        threads, 0 decodes them one at a time
+ *    --no-texture-cache  upload uncompressed RGB8/RGBA8 textures
+ *                        instead of the BC1/BC3 texture cache
+ *    --texture-budget=MB stream at most MB megabytes of texture
+ *                        levels per frame, 0 loads them all
+ *                        before the first frame
+ *    --texture-memory=MB keep the textures under MB megabytes of
+ *                        video memory by dropping their top mip
+ *                        levels, 0 only drops the unneeded ones
+ *    --lights=N          add N point lights in a grid over the
+ *                        ceiling of the scene
+ *    --light-threads=N   assign the point lights to the view
+ *                        clusters on N worker threads, 0 assigns
+ *                        them on the render thread
+ *    --deferred          shade the opaque objects in a light pass
+ *                        over a G-buffer instead of forward
+ *    --bench-pipelines   time the forward and the deferred
+ *                        pipeline on the scene, then exit
+ ***********************************************************/
+bool ParseCommandLine(int argc, char* argv[])
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string argument = argv[i];
+		if (argument == "--no-permutations")
+		{
+			g_Options.bShaderPermutations = false;
+		}
+		else if (argument == "--bench-transforms")
+		{
+			g_Options.bBenchmarkTransforms = true;
+		}
+		else if (argument == "--bench-bvh")
+		{
+			g_Options.bBenchmarkBvh = true;
+		}
+		else if (argument == "--no-texture-cache")
+		{
+			g_Options.bTextureCache = false;
+		}
+		else if (argument.compare(0, 18, "--texture-threads=") == 0)
+		{
+			g_Options.textureThreads = std::max(0, atoi(argument.c_str() + 18));
+		}
+		else if (argument.compare(0, 17, "--texture-budget=") == 0)
+		{
+			g_Options.textureBudgetMB = std::max(0, atoi(argument.c_str() + 17));
+		}
+		else if (argument.compare(0, 9, "--lights=") == 0)
+		{
+			g_Options.generatedLights = std::max(0, atoi(argument.c_str() + 9));
+		}
+		else if (argument.compare(0, 16, "--light-threads=") == 0)
+		{
+			g_Options.lightThreads = std::max(0, atoi(argument.c_str() + 16));
+		}
+		else if (argument.compare(0, 17, "--texture-memory=") == 0)
+		{
+			g_Options.textureMemoryMB = std::max(0, atoi(argument.c_str() + 17));
+		}
+		else if (argument == "--deferred")
+		{
+			g_Options.bDeferredShading = true;
+		}
+		else if (argument == "--bench-pipelines")
+		{
+			g_Options.bBenchmarkPipelines = true;
+		}
+		else
+		{
+			std::cerr << "ERROR: Unknown command line option: " << argument << std::endl;
+			std::cerr << "Usage: " << argv[0] << " [--no-permutations] [--bench-transforms] [--bench-bvh] [--texture-threads=N] [--no-texture-cache] [--texture-budget=MB] [--texture-memory=MB] [--lights=N] [--light-threads=N] [--deferred] [--bench-pipelines]" << std::endl;
+			return(false);
+		}
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *	BenchmarkTransforms()
+ *
+ *  This function is used to measure the cost of the model
+ *  matrices of 10k objects per frame: rebuilt from five
+ *  matrices every frame, composed directly every frame, and
+ *  cached with only 1% of the objects moving each frame.
+ ***********************************************************/
+void BenchmarkTransforms()
+{
+	const size_t OBJECT_COUNT = 10000;
+	const size_t MOVING_OBJECTS = OBJECT_COUNT / 100;
+	const int FRAME_COUNT = 200;
+
+	std::vector<glm::vec3> scales(OBJECT_COUNT);
+	std::vector<glm::vec3> rotations(OBJECT_COUNT);
+	std::vector<glm::vec3> positions(OBJECT_COUNT);
+	for (size_t i = 0; i < OBJECT_COUNT; ++i)
+	{
+		float value = static_cast<float>(i);
+		scales[i] = glm::vec3(1.0f + (i % 7) * 0.25f, 1.0f + (i % 5) * 0.5f, 1.0f + (i % 3));
+		rotations[i] = glm::vec3(value * 0.37f, value * 1.13f, value * 0.71f);
+		positions[i] = glm::vec3((i % 100) * 2.0f, (i % 13) * 0.5f, (i / 100) * 2.0f);
+	}
+
+	std::vector<glm::mat4> matrices(OBJECT_COUNT);
+	// summed so the compiler cannot drop the work
+	float checksum = 0.0f;
+
+	auto startTime = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < FRAME_COUNT; ++frame)
+	{
+		for (size_t i = 0; i < OBJECT_COUNT; ++i)
+		{
+			matrices[i] = glm::translate(positions[i]) *
+				glm::rotate(glm::radians(rotations[i].z), glm::vec3(0.0f, 0.0f, 1.0f)) *
+				glm::rotate(glm::radians(rotations[i].y), glm::vec3(0.0f, 1.0f, 0.0f)) *
+				glm::rotate(glm::radians(rotations[i].x), glm::vec3(1.0f, 0.0f, 0.0f)) *
+				glm::scale(scales[i]);
+		}
+		checksum += matrices[frame % OBJECT_COUNT][0][0];
+	}
+	double rebuildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+	startTime = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < FRAME_COUNT; ++frame)
+	{
+		for (size_t i = 0; i < OBJECT_COUNT; ++i)
+		{
+			matrices[i] = TransformStore::ComposeModelMatrix(scales[i], rotations[i], positions[i]);
+		}
+		checksum += matrices[frame % OBJECT_COUNT][0][0];
+	}
+	double composeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+	TransformStore store;
+	for (size_t i = 0; i < OBJECT_COUNT; ++i)
+	{
+		store.Add(scales[i], rotations[i], positions[i]);
+	}
+	store.Update();
+
+	startTime = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < FRAME_COUNT; ++frame)
+	{
+		for (size_t moving = 0; moving < MOVING_OBJECTS; ++moving)
+		{
+			size_t i = (frame * MOVING_OBJECTS + moving) % OBJECT_COUNT;
+			store.SetPosition(i, positions[i] + glm::vec3(0.0f, frame * 0.01f, 0.0f));
+		}
+		store.Update();
+		checksum += store.GetModelMatrix(frame % OBJECT_COUNT)[0][0];
+	}
+	double cachedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+	std::cout << "BENCH: model matrices of " << OBJECT_COUNT << " objects, " << FRAME_COUNT << " frames" << std::endl;
+	std::cout << "BENCH: rebuilt from 5 matrices: " << rebuildMs / FRAME_COUNT << " ms/frame" << std::endl;
+	std::cout << "BENCH: composed directly: " << composeMs / FRAME_COUNT << " ms/frame" << std::endl;
+	std::cout << "BENCH: cached, " << MOVING_OBJECTS << " moving: " << cachedMs / FRAME_COUNT << " ms/frame"
+		<< " (" << (cachedMs > 0.0 ? rebuildMs / cachedMs : 0.0) << "x faster than rebuilt)" << std::endl;
+	std::cout << "BENCH: checksum " << checksum << std::endl;
+}
+
+/***********************************************************
+ *	BenchmarkBvh()
+ *
+ *  This function is used to measure building, refitting and
+ *  querying the bounding volume hierarchy over 1k, 10k and
+ *  100k random boxes.  The frustum query is compared with
+ *  testing every box linearly through the frustum culler.
+ ***********************************************************/
+void BenchmarkBvh()
+{
+	const size_t OBJECT_COUNTS[] = { 1000, 10000, 100000 };
+	const int QUERY_COUNT = 1000;
+	const int FRUSTUM_QUERY_COUNT = 100;
+
+	// summed so the compiler cannot drop the work
+	size_t checksum = 0;
+
+	for (size_t objectCount : OBJECT_COUNTS)
+	{
+		// boxes spread through a cube that grows with the object count,
+		// so that the density of the scene stays the same
+		std::mt19937 random(12345);
+		float worldSize = 4.0f * std::cbrt(static_cast<float>(objectCount));
+		std::uniform_real_distribution<float> positionDistribution(0.0f, worldSize);
+		std::uniform_real_distribution<float> sizeDistribution(0.1f, 1.0f);
+		std::uniform_real_distribution<float> unitDistribution(-1.0f, 1.0f);
+
+		std::vector<glm::vec3> boxMins(objectCount);
+		std::vector<glm::vec3> boxMaxs(objectCount);
+		for (size_t i = 0; i < objectCount; ++i)
+		{
+			glm::vec3 center(positionDistribution(random), positionDistribution(random), positionDistribution(random));
+			glm::vec3 extents(sizeDistribution(random), sizeDistribution(random), sizeDistribution(random));
+			boxMins[i] = center - extents;
+			boxMaxs[i] = center + extents;
+		}
+
+		BoundingVolumeHierarchy bvh;
+		auto startTime = std::chrono::steady_clock::now();
+		bvh.Build(boxMins, boxMaxs);
+		double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+		// move 1% of the objects a little and refit
+		size_t movingObjects = objectCount / 100;
+		startTime = std::chrono::steady_clock::now();
+		for (size_t moving = 0; moving < movingObjects; ++moving)
+		{
+			size_t i = (moving * 97) % objectCount;
+			glm::vec3 offset(0.0f, 0.25f, 0.0f);
+			bvh.SetObjectBounds(static_cast<uint32_t>(i), boxMins[i] + offset, boxMaxs[i] + offset);
+		}
+		size_t refitNodes = bvh.Refit();
+		double refitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+		// camera at one corner looking at the center of the cube
+		glm::vec3 cameraPosition(-2.0f, worldSize * 0.5f, -2.0f);
+		glm::mat4 view = glm::lookAt(cameraPosition, glm::vec3(worldSize * 0.5f), glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, worldSize * 0.5f);
+		FrustumCuller culler;
+		culler.SetFrustum(projection * view);
+		culler.Resize(objectCount);
+		for (size_t i = 0; i < objectCount; ++i)
+		{
+			culler.SetBox(i, (boxMins[i] + boxMaxs[i]) * 0.5f, (boxMaxs[i] - boxMins[i]) * 0.5f);
+		}
+
+		std::vector<uint32_t> objects;
+		startTime = std::chrono::steady_clock::now();
+		for (int query = 0; query < FRUSTUM_QUERY_COUNT; ++query)
+		{
+			bvh.QueryFrustum(culler.GetPlanes(), objects);
+			checksum += objects.size();
+		}
+		double frustumMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+		size_t bvhVisible = objects.size();
+
+		std::vector<unsigned char> visible;
+		size_t linearVisible = 0;
+		startTime = std::chrono::steady_clock::now();
+		for (int query = 0; query < FRUSTUM_QUERY_COUNT; ++query)
+		{
+			linearVisible = culler.Cull(visible);
+			checksum += linearVisible;
+		}
+		double linearMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+		std::vector<BoundingVolumeHierarchy::RAY_HIT> hits;
+		startTime = std::chrono::steady_clock::now();
+		for (int query = 0; query < QUERY_COUNT; ++query)
+		{
+			glm::vec3 direction(unitDistribution(random), unitDistribution(random), unitDistribution(random));
+			bvh.QueryRay(cameraPosition, direction, worldSize * 2.0f, hits);
+			checksum += hits.size();
+		}
+		double rayMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+		startTime = std::chrono::steady_clock::now();
+		for (int query = 0; query < QUERY_COUNT; ++query)
+		{
+			glm::vec3 center(positionDistribution(random), positionDistribution(random), positionDistribution(random));
+			bvh.QueryOverlap(center - glm::vec3(2.0f), center + glm::vec3(2.0f), objects);
+			checksum += objects.size();
+		}
+		double overlapMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+		std::cout << "BENCH: BVH of " << objectCount << " objects, " << bvh.GetNodeCount() << " nodes ("
+			<< bvh.GetNodeCount() * sizeof(BoundingVolumeHierarchy::BVH_NODE) / 1024 << " KB)" << std::endl;
+		std::cout << "BENCH:   build (SAH): " << buildMs << " ms" << std::endl;
+		std::cout << "BENCH:   refit after " << movingObjects << " moved: " << refitMs << " ms, "
+			<< refitNodes << " nodes" << std::endl;
+		std::cout << "BENCH:   frustum query: " << frustumMs / FRUSTUM_QUERY_COUNT << " ms, " << bvhVisible
+			<< " visible (linear " << FrustumCuller::GetInstructionSet() << " test: " << linearMs / FRUSTUM_QUERY_COUNT
+			<< " ms, " << linearVisible << " visible)" << std::endl;
+		std::cout << "BENCH:   ray query: " << rayMs * 1000.0 / QUERY_COUNT << " us" << std::endl;
+		std::cout << "BENCH:   overlap query: " << overlapMs * 1000.0 / QUERY_COUNT << " us" << std::endl;
+	}
+	std::cout << "BENCH: checksum " << checksum << std::endl;
+}
+
+/***********************************************************
+ *	RenderFrame()
+ *
+ *  This function is used to clear the window and render the
+ *  3D scene from the current camera into the back buffer.
+ ***********************************************************/
+void RenderFrame()
+{
+	// Enable z-depth - only reaches OpenGL when it is not already on
+	g_ShaderManager->GetStateCache()->Enable(GL_DEPTH_TEST);
+
+	// Clear the frame and z buffers
+	glClearColor(0.93f, 0.90f, 0.82f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	// convert from 3D object space to 2D view
+	g_ViewManager->PrepareSceneView();
+
+	// refresh the 3D scene, culled to the camera frustum and
+	// sorted by distance from the camera
+	g_SceneManager->SetCamera(
+		g_ViewManager->GetViewMatrix(),
+		g_ViewManager->GetProjectionMatrix(),
+		g_ViewManager->GetCameraPosition());
+	g_SceneManager->RenderScene();
+}
+
+/***********************************************************
+ *	BenchmarkPipelines()
+ *
+ *  This function is used to compare the forward and the
+ *  deferred pipeline on the loaded scene - with the point
+ *  lights of the scene file, and with many point lights
+ *  added over the ceiling.  Each run renders some frames to
+ *  settle the texture streaming and the caches, then times
+ *  a fixed number of frames with the vertical sync off.
+ ***********************************************************/
+void BenchmarkPipelines()
+{
+	const int WARMUP_FRAMES = 120;
+	const int FRAME_COUNT = 300;
+	// generated point lights of the runs, on top of the scene file lights
+	const int GENERATED_LIGHT_COUNTS[] = { 0, 1024 };
+
+	glfwSwapInterval(0);
+	for (int lightCount : GENERATED_LIGHT_COUNTS)
+	{
+		g_SceneManager->SetGeneratedLights(lightCount);
+		g_SceneManager->ReloadScene();
+
+		double frameMs[2] = { 0.0, 0.0 };
+		for (int pipeline = 0; pipeline < 2; ++pipeline)
+		{
+			bool bDeferred = (pipeline == 1);
+			if (g_SceneManager->SetDeferredShading(bDeferred) == false)
+			{
+				std::cout << "BENCH: deferred pipeline not supported" << std::endl;
+				continue;
+			}
+
+			for (int frame = 0; frame < WARMUP_FRAMES; ++frame)
+			{
+				RenderFrame();
+				glfwSwapBuffers(g_Window);
+				glfwPollEvents();
+			}
+			glFinish();
+			g_SceneManager->ResetPipelineStats();
+
+			auto startTime = std::chrono::steady_clock::now();
+			for (int frame = 0; frame < FRAME_COUNT; ++frame)
+			{
+				RenderFrame();
+				glfwSwapBuffers(g_Window);
+				glfwPollEvents();
+			}
+			glFinish();
+			frameMs[pipeline] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count() / FRAME_COUNT;
+
+			std::cout << "BENCH: " << (bDeferred ? "deferred" : "forward") << " pipeline, "
+				<< g_SceneManager->GetPointLightCount() << " point lights: " << frameMs[pipeline] << " ms/frame"
+				<< ", opaque objects " << g_SceneManager->GetOpaquePassMs() << " ms GPU";
+			if (bDeferred)
+			{
+				std::cout << " + light pass " << g_SceneManager->GetLightPassMs() << " ms GPU";
+			}
+			std::cout << std::endl;
+		}
+		if (frameMs[0] > 0.0 && frameMs[1] > 0.0)
+		{
+			std::cout << "BENCH: deferred/forward frame time with " << g_SceneManager->GetPointLightCount()
+				<< " point lights: " << frameMs[1] / frameMs[0] << "x" << std::endl;
+		}
+	}
+	g_SceneManager->SetDeferredShading(g_Options.bDeferredShading);
+}
+
 /***********************************************************
  *	InitializeGLFW()
  * 
@@ -188,4 +707,167 @@ bool InitializeGLEW()
 	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
 
 	return(true);
+}
+
+/***********************************************************
+ *	HasExtension()
+ *
+ *  This function is used to check the extension of a file.
+ ***********************************************************/
+bool HasExtension(const std::string& filename, const std::string& extension)
+{
+	return filename.size() > extension.size() &&
+		filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+/***********************************************************
+ *	IsImageFile()
+ *
+ *  This function is used to check whether a file is an image
+ *  that can be loaded as a texture.
+ ***********************************************************/
+bool IsImageFile(const std::string& filename)
+{
+	return HasExtension(filename, ".jpg") ||
+		HasExtension(filename, ".jpeg") ||
+		HasExtension(filename, ".png") ||
+		HasExtension(filename, ".bmp") ||
+		HasExtension(filename, ".tga");
+}
+
+/***********************************************************
+ *	ProcessChangedFiles()
+ *
+ *  This function is used to hot reload the shader program or
+ *  the textures whose files changed on disk.
+ ***********************************************************/
+void ProcessChangedFiles()
+{
+	static std::vector<std::string> changedFiles;
+	g_FileWatcher->PollChanges(changedFiles);
+
+	bool bShaderChanged = false;
+	bool bSceneChanged = false;
+	for (const std::string& filename : changedFiles)
+	{
+		if (HasExtension(filename, ".glsl"))
+		{
+			bShaderChanged = true;
+		}
+		else if (HasExtension(filename, ".scene"))
+		{
+			bSceneChanged = true;
+		}
+		else if (IsImageFile(filename))
+		{
+			g_SceneManager->ReloadTexture(filename);
+		}
+	}
+
+	if (bSceneChanged)
+	{
+		std::cout << "INFO: Scene file changed, reloading" << std::endl;
+		g_SceneManager->ReloadScene();
+	}
+
+	// both shader files are rebuilt together, once per batch of changes
+	if (bShaderChanged)
+	{
+		std::cout << "INFO: Shader source changed, recompiling" << std::endl;
+		g_ShaderManager->ReloadShaders();
+		g_SceneManager->ReloadShadowShaders();
+	}
+}
+
+/***********************************************************
+ *	PickClickedObject()
+ *
+ *  This function is used to ray cast the last left click,
+ *  if any, into the scene and report the object that was
+ *  hit and the time the ray cast took.
+ ***********************************************************/
+void PickClickedObject()
+{
+	glm::vec3 origin;
+	glm::vec3 direction;
+	if (!g_ViewManager->GetPickRay(origin, direction))
+	{
+		return;
+	}
+
+	SceneManager::PICK_RESULT pick;
+	auto startTime = std::chrono::steady_clock::now();
+	bool bHit = g_SceneManager->PickObject(origin, direction, pick);
+	double pickMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+	if (bHit)
+	{
+		std::cout << "PICK: " << pick.name << " at (" << pick.point.x << ", " << pick.point.y << ", "
+			<< pick.point.z << "), " << pick.distance << " units away (" << pickMs << " ms)" << std::endl;
+	}
+	else
+	{
+		std::cout << "PICK: nothing (" << pickMs << " ms)" << std::endl;
+	}
+}
+
+/***********************************************************
+ *	ReportFrameStats()
+ *
+ *  This function is used to print the per-frame averages of
+ *  the renderer statistics collected since the last report.
+ ***********************************************************/
+void ReportFrameStats(int frameCount)
+{
+	if (frameCount <= 0)
+	{
+		return;
+	}
+
+	const ShaderManager::UNIFORM_STATS& uniformStats = g_ShaderManager->GetStats();
+	std::cout << "STATS: " << frameCount << " frames"
+		<< " | uniform uploads/frame: handle " << uniformStats.handleUploads / frameCount
+		<< ", by name " << uniformStats.nameUploads / frameCount
+		<< " | uniform location lookups avoided/frame: " << uniformStats.lookupsAvoided / frameCount
+		<< " | shader program switches/frame: " << uniformStats.programSwitches / frameCount
+		<< std::endl;
+	g_ShaderManager->ResetStats();
+
+	GLStateCache* pStateCache = g_ShaderManager->GetStateCache();
+	std::cout << "STATS: GL state calls/frame: issued " << pStateCache->GetStats().issuedCalls / frameCount
+		<< ", skipped " << pStateCache->GetStats().skippedCalls / frameCount << std::endl;
+	pStateCache->ResetStats();
+
+	g_SceneManager->ReportFrameStats(frameCount);
+}
+
+/***********************************************************
+ *	GetPeakMemoryMB()
+ *
+ *  This function is used to get the largest amount of memory
+ *  the process has held so far, in megabytes.
+ ***********************************************************/
+double GetPeakMemoryMB()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+	}
+	return 0.0;
+#else
+	// the peak resident set size is reported in bytes on macOS
+	// and in kilobytes on Linux
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+	{
+#ifdef __APPLE__
+		return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+		return usage.ru_maxrss / 1024.0;
+#endif
+	}
+	return 0.0;
+#endif
 }
\ No newline at end of file
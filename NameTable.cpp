@@ -0,0 +1,154 @@
+///////////////////////////////////////////////////////////////////////////////
+// nametable.cpp
+// ============
+// map names to small integer handles with a flat open addressing hash table
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#include "NameTable.h"
+
+#include <cstring>
+
+namespace
+{
+	// slots of a new table, always a power of two
+	const size_t INITIAL_SLOTS = 16;
+}
+
+/***********************************************************
+ *  NameTable()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+NameTable::NameTable()
+{
+	m_count = 0;
+	Clear();
+}
+
+/***********************************************************
+ *  Insert()
+ *
+ *  This method is used for registering a name under a
+ *  handle.  The table grows before it is half full, which
+ *  keeps the probe sequences short.
+ ***********************************************************/
+void NameTable::Insert(const std::string& name, int handle)
+{
+	if ((m_count + 1) * 2 > m_slots.size())
+	{
+		Grow();
+	}
+
+	uint64_t hash = HashName(name);
+	SLOT& slot = m_slots[FindSlot(name, hash)];
+	if (slot.handle == NOT_FOUND)
+	{
+		slot.hash = hash;
+		slot.nameOffset = static_cast<uint32_t>(m_names.size());
+		slot.nameLength = static_cast<uint32_t>(name.size());
+		m_names.insert(m_names.end(), name.begin(), name.end());
+		m_count++;
+	}
+	slot.handle = handle;
+}
+
+/***********************************************************
+ *  Find()
+ *
+ *  This method is used for getting the handle a name was
+ *  registered under.
+ ***********************************************************/
+int NameTable::Find(const std::string& name) const
+{
+	return m_slots[FindSlot(name, HashName(name))].handle;
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all the names.
+ ***********************************************************/
+void NameTable::Clear()
+{
+	SLOT empty = { 0, NOT_FOUND, 0, 0 };
+	m_slots.assign(INITIAL_SLOTS, empty);
+	m_names.clear();
+	m_count = 0;
+}
+
+/***********************************************************
+ *  FindSlot()
+ *
+ *  This method is used for probing the slots from the one
+ *  the hash points at until the name or an empty slot is
+ *  found.  Names are only compared when the hashes match.
+ ***********************************************************/
+size_t NameTable::FindSlot(const std::string& name, uint64_t hash) const
+{
+	size_t mask = m_slots.size() - 1;
+	size_t index = static_cast<size_t>(hash) & mask;
+	for (;;)
+	{
+		const SLOT& slot = m_slots[index];
+		if (slot.handle == NOT_FOUND)
+		{
+			return index;
+		}
+		if (slot.hash == hash && slot.nameLength == name.size() &&
+			memcmp(m_names.data() + slot.nameOffset, name.data(), name.size()) == 0)
+		{
+			return index;
+		}
+		index = (index + 1) & mask;
+	}
+}
+
+/***********************************************************
+ *  Grow()
+ *
+ *  This method is used for doubling the number of slots.
+ *  The names stay where they are in the name buffer; only
+ *  the slots are placed again from their stored hashes.
+ ***********************************************************/
+void NameTable::Grow()
+{
+	std::vector<SLOT> oldSlots;
+	oldSlots.swap(m_slots);
+	SLOT empty = { 0, NOT_FOUND, 0, 0 };
+	m_slots.assign(oldSlots.size() * 2, empty);
+
+	size_t mask = m_slots.size() - 1;
+	for (const SLOT& slot : oldSlots)
+	{
+		if (slot.handle == NOT_FOUND)
+		{
+			continue;
+		}
+		size_t index = static_cast<size_t>(slot.hash) & mask;
+		while (m_slots[index].handle != NOT_FOUND)
+		{
+			index = (index + 1) & mask;
+		}
+		m_slots[index] = slot;
+	}
+}
+
+/***********************************************************
+ *  HashName()
+ *
+ *  This method is used for hashing a name with 64-bit
+ *  FNV-1a.
+ ***********************************************************/
+uint64_t NameTable::HashName(const std::string& name)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for (unsigned char c : name)
+	{
+		hash ^= c;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
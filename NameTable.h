@@ -0,0 +1,69 @@
+///////////////////////////////////////////////////////////////////////////////
+// nametable.h
+// ============
+// map names to small integer handles with a flat open addressing hash table
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  NameTable
+ *
+ *  This class maps names to the integer handles they were
+ *  registered with.  The slots are one flat array probed
+ *  linearly, each holding the precomputed hash of its name,
+ *  and the names are packed into a single character buffer,
+ *  so a lookup hashes the name once, touches a few adjacent
+ *  slots and compares characters only when the hashes match.
+ *  Names are registered while a scene is loaded; lookups
+ *  never allocate.
+ ***********************************************************/
+class NameTable
+{
+public:
+	// returned for names that were never registered
+	static const int NOT_FOUND = -1;
+
+	// constructor
+	NameTable();
+
+	// register a name under a handle, replacing the handle of a name
+	// that is already registered
+	void Insert(const std::string& name, int handle);
+	// handle registered for the name, or NOT_FOUND
+	int Find(const std::string& name) const;
+	// forget all the names
+	void Clear();
+
+	size_t GetCount() const { return m_count; }
+
+private:
+	// one slot of the table, empty while its handle is NOT_FOUND
+	struct SLOT
+	{
+		uint64_t hash;
+		int handle;
+		// the name inside m_names
+		uint32_t nameOffset;
+		uint32_t nameLength;
+	};
+
+	std::vector<SLOT> m_slots;
+	std::vector<char> m_names;
+	size_t m_count;
+
+	// slot holding the name, or the empty slot it would go in
+	size_t FindSlot(const std::string& name, uint64_t hash) const;
+	// double the slots and insert the names again
+	void Grow();
+	// 64-bit FNV-1a of the name
+	static uint64_t HashName(const std::string& name);
+};
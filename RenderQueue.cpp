@@ -0,0 +1,162 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderqueue.cpp
+// ============
+// sort the draw items of a frame into a state change minimizing order
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderQueue.h"
+
+#include <algorithm>
+
+namespace
+{
+	const int PASS_SHIFT = 62;
+	const uint32_t DEPTH_MAX = (1u << 24) - 1;
+
+	// depth quantized to 24 bits, closer is smaller
+	uint64_t QuantizeDepth(float depth)
+	{
+		float normalized = depth / RenderQueue::MAX_SORT_DEPTH;
+		normalized = std::min(std::max(normalized, 0.0f), 1.0f);
+		return static_cast<uint64_t>(normalized * DEPTH_MAX);
+	}
+}
+
+const float RenderQueue::MAX_SORT_DEPTH = 256.0f;
+
+/***********************************************************
+ *  MakeKey()
+ *
+ *  This method is used for packing the sort criteria of an
+ *  item into a key that sorts in drawing order.
+ ***********************************************************/
+uint64_t RenderQueue::MakeKey(
+	RENDER_PASS pass,
+	uint32_t variant,
+	uint32_t texture,
+	uint32_t mesh,
+	float depth)
+{
+	uint64_t state =
+		(static_cast<uint64_t>(variant & 0xff) << 16) |
+		(static_cast<uint64_t>(texture & 0xff) << 8) |
+		static_cast<uint64_t>(mesh & 0xff);
+	uint64_t quantizedDepth = QuantizeDepth(depth);
+
+	uint64_t key = static_cast<uint64_t>(pass) << PASS_SHIFT;
+	if (pass == PASS_TRANSPARENT)
+	{
+		// farthest first, the state only breaks ties
+		key |= (DEPTH_MAX - quantizedDepth) << 38;
+		key |= state << 14;
+	}
+	else
+	{
+		// state first, front to back inside a state group
+		key |= state << 38;
+		key |= quantizedDepth << 14;
+	}
+	return key;
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all the queued items.
+ ***********************************************************/
+void RenderQueue::Clear()
+{
+	m_items.clear();
+}
+
+/***********************************************************
+ *  Push()
+ *
+ *  This method is used for adding an item to the queue.
+ ***********************************************************/
+void RenderQueue::Push(uint64_t key, uint32_t objectIndex)
+{
+	RENDER_ITEM item;
+	item.key = key;
+	item.objectIndex = objectIndex;
+	m_items.push_back(item);
+}
+
+/***********************************************************
+ *  Sort()
+ *
+ *  This method is used for sorting the items by key with an
+ *  LSD radix sort over the 8 key bytes.  Bytes that are the
+ *  same for every item are skipped, which drops most passes
+ *  since the low key bits are rarely all in use.
+ ***********************************************************/
+void RenderQueue::Sort()
+{
+	const size_t itemCount = m_items.size();
+	if (itemCount < 2)
+	{
+		return;
+	}
+	m_sortBuffer.resize(itemCount);
+
+	// count all the byte histograms in a single pass over the keys
+	uint32_t histograms[8][256] = {};
+	for (const RENDER_ITEM& item : m_items)
+	{
+		for (int byteIndex = 0; byteIndex < 8; ++byteIndex)
+		{
+			histograms[byteIndex][(item.key >> (byteIndex * 8)) & 0xff]++;
+		}
+	}
+
+	RENDER_ITEM* pSource = m_items.data();
+	RENDER_ITEM* pDestination = m_sortBuffer.data();
+	for (int byteIndex = 0; byteIndex < 8; ++byteIndex)
+	{
+		uint32_t* histogram = histograms[byteIndex];
+		int shift = byteIndex * 8;
+
+		// every item has the same value in this byte
+		if (histogram[(pSource[0].key >> shift) & 0xff] == itemCount)
+		{
+			continue;
+		}
+
+		uint32_t offset = 0;
+		for (int value = 0; value < 256; ++value)
+		{
+			uint32_t count = histogram[value];
+			histogram[value] = offset;
+			offset += count;
+		}
+
+		for (size_t i = 0; i < itemCount; ++i)
+		{
+			pDestination[histogram[(pSource[i].key >> shift) & 0xff]++] = pSource[i];
+		}
+		std::swap(pSource, pDestination);
+	}
+
+	// an odd number of passes leaves the result in the scratch buffer
+	if (pSource != m_items.data())
+	{
+		m_items.swap(m_sortBuffer);
+	}
+}
+
+/***********************************************************
+ *  FindPassBegin()
+ *
+ *  This method is used for finding where a pass starts in
+ *  the sorted items.
+ ***********************************************************/
+size_t RenderQueue::FindPassBegin(RENDER_PASS pass) const
+{
+	uint64_t passKey = static_cast<uint64_t>(pass) << PASS_SHIFT;
+	auto first = std::lower_bound(m_items.begin(), m_items.end(), passKey,
+		[](const RENDER_ITEM& item, uint64_t key) { return item.key < key; });
+	return static_cast<size_t>(first - m_items.begin());
+}
@@ -0,0 +1,75 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderqueue.h
+// ============
+// sort the draw items of a frame into a state change minimizing order
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  RenderQueue
+ *
+ *  This class collects one draw item per object with a 64-bit
+ *  sort key and sorts the items with an LSD radix sort.  The
+ *  key puts the render pass in the top bits, so the passes
+ *  are drawn in order.  Opaque items are grouped by shader
+ *  variant, texture and mesh and drawn front to back inside
+ *  a group; transparent items are drawn back to front.
+ *
+ *  opaque key:      pass:2 | variant:8 | texture:8 | mesh:8 | depth:24 | 0:14
+ *  transparent key: pass:2 | ~depth:24 | variant:8 | texture:8 | mesh:8 | 0:14
+ ***********************************************************/
+class RenderQueue
+{
+public:
+	// render passes in drawing order
+	enum RENDER_PASS
+	{
+		PASS_TIMED = 0,      // opaque items measured by the GPU timer
+		PASS_OPAQUE = 1,
+		PASS_TRANSPARENT = 2,
+		PASS_COUNT
+	};
+
+	struct RENDER_ITEM
+	{
+		uint64_t key;
+		// object drawn by the item
+		uint32_t objectIndex;
+	};
+
+	// distance from the camera that maps to the largest depth value
+	static const float MAX_SORT_DEPTH;
+
+	// build the sort key of an item; variant, texture and mesh
+	// are truncated to 8 bits, depth is the distance to the camera
+	static uint64_t MakeKey(
+		RENDER_PASS pass,
+		uint32_t variant,
+		uint32_t texture,
+		uint32_t mesh,
+		float depth);
+
+	// remove all items, keeping the allocated memory
+	void Clear();
+	// add an item to the queue
+	void Push(uint64_t key, uint32_t objectIndex);
+	// sort the items by key
+	void Sort();
+
+	const std::vector<RENDER_ITEM>& GetItems() const { return m_items; }
+	// index of the first sorted item of a pass (or the item count)
+	size_t FindPassBegin(RENDER_PASS pass) const;
+
+private:
+	std::vector<RENDER_ITEM> m_items;
+	// scratch buffer of the radix sort
+	std::vector<RENDER_ITEM> m_sortBuffer;
+};
@@ -0,0 +1,140 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenegraph.cpp
+// ============
+// parent/child transforms of the scene objects and their groups
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneGraph.h"
+
+/***********************************************************
+ *  AddNode()
+ *
+ *  This method is used for appending a node to the graph.
+ *  The subtree of the parent and of all its ancestors grows
+ *  by the new node.
+ ***********************************************************/
+uint32_t SceneGraph::AddNode(
+	uint32_t parent,
+	const glm::vec3& scaleXYZ,
+	const glm::vec3& rotationDegrees,
+	const glm::vec3& positionXYZ)
+{
+	uint32_t node = static_cast<uint32_t>(m_parents.size());
+
+	// appending keeps the depth-first order only below an open subtree
+	if (parent != NO_PARENT && (parent >= node || m_subtreeEnds[parent] != node))
+	{
+		return NO_PARENT;
+	}
+
+	m_localTransforms.Add(scaleXYZ, rotationDegrees, positionXYZ);
+	m_parents.push_back(parent);
+	m_subtreeEnds.push_back(node + 1);
+	m_worldMatrices.push_back(glm::mat4(1.0f));
+	m_dirty.push_back(0);
+
+	for (uint32_t ancestor = parent; ancestor != NO_PARENT; ancestor = m_parents[ancestor])
+	{
+		m_subtreeEnds[ancestor] = node + 1;
+	}
+	return node;
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all the nodes.
+ ***********************************************************/
+void SceneGraph::Clear()
+{
+	m_localTransforms.Clear();
+	m_parents.clear();
+	m_subtreeEnds.clear();
+	m_worldMatrices.clear();
+	m_dirty.clear();
+	m_version++;
+}
+
+/***********************************************************
+ *  SetLocalScale()
+ *
+ *  This method is used for changing the scale of a node
+ *  relative to its parent.
+ ***********************************************************/
+void SceneGraph::SetLocalScale(uint32_t node, const glm::vec3& scaleXYZ)
+{
+	m_localTransforms.SetScale(node, scaleXYZ);
+}
+
+/***********************************************************
+ *  SetLocalRotation()
+ *
+ *  This method is used for changing the rotation of a node
+ *  relative to its parent.
+ ***********************************************************/
+void SceneGraph::SetLocalRotation(uint32_t node, const glm::vec3& rotationDegrees)
+{
+	m_localTransforms.SetRotation(node, rotationDegrees);
+}
+
+/***********************************************************
+ *  SetLocalPosition()
+ *
+ *  This method is used for changing the position of a node
+ *  relative to its parent.
+ ***********************************************************/
+void SceneGraph::SetLocalPosition(uint32_t node, const glm::vec3& positionXYZ)
+{
+	m_localTransforms.SetPosition(node, positionXYZ);
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for recomputing the world matrices of
+ *  every subtree whose root changed.  One forward sweep is
+ *  enough: parents come before their children, and a changed
+ *  subtree is recomputed as a whole and then skipped.
+ ***********************************************************/
+size_t SceneGraph::Update()
+{
+	const std::vector<uint32_t>& changedNodes = m_localTransforms.GetDirtyIndices();
+	if (changedNodes.empty())
+	{
+		return 0;
+	}
+	for (uint32_t node : changedNodes)
+	{
+		m_dirty[node] = 1;
+	}
+	m_localTransforms.Update();
+
+	size_t updated = 0;
+	uint32_t nodeCount = static_cast<uint32_t>(m_parents.size());
+	uint32_t node = 0;
+	while (node < nodeCount)
+	{
+		if (m_dirty[node] == 0)
+		{
+			node++;
+			continue;
+		}
+
+		uint32_t subtreeEnd = m_subtreeEnds[node];
+		for (uint32_t child = node; child < subtreeEnd; ++child)
+		{
+			uint32_t parent = m_parents[child];
+			const glm::mat4& local = m_localTransforms.GetModelMatrix(child);
+			m_worldMatrices[child] = (parent == NO_PARENT) ? local : m_worldMatrices[parent] * local;
+			m_dirty[child] = 0;
+		}
+		updated += subtreeEnd - node;
+		node = subtreeEnd;
+	}
+
+	m_version++;
+	return updated;
+}
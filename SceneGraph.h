@@ -0,0 +1,74 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenegraph.h
+// ============
+// parent/child transforms of the scene objects and their groups
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "TransformStore.h"
+
+/***********************************************************
+ *  SceneGraph
+ *
+ *  This class keeps a hierarchy of nodes, each with a local
+ *  transform relative to its parent.  The nodes are stored in
+ *  depth-first order, so the subtree of a node is the range
+ *  of nodes from the node to its subtree end, and a parent is
+ *  always stored before its children.  Update() recomputes
+ *  the world matrices of the changed subtrees only.
+ ***********************************************************/
+class SceneGraph
+{
+public:
+	static const uint32_t NO_PARENT = 0xffffffffu;
+
+	// append a node below a parent (or NO_PARENT for a root) and return
+	// its index; nodes must be added depth-first, so the parent has to be
+	// the last added node or one of its ancestors - NO_PARENT otherwise
+	uint32_t AddNode(
+		uint32_t parent,
+		const glm::vec3& scaleXYZ,
+		const glm::vec3& rotationDegrees,
+		const glm::vec3& positionXYZ);
+	// remove all the nodes
+	void Clear();
+	size_t GetNodeCount() const { return m_parents.size(); }
+
+	uint32_t GetParent(uint32_t node) const { return m_parents[node]; }
+	// index one past the last node of the subtree
+	uint32_t GetSubtreeEnd(uint32_t node) const { return m_subtreeEnds[node]; }
+
+	// change the local transform of a node, its subtree follows on Update()
+	void SetLocalScale(uint32_t node, const glm::vec3& scaleXYZ);
+	void SetLocalRotation(uint32_t node, const glm::vec3& rotationDegrees);
+	void SetLocalPosition(uint32_t node, const glm::vec3& positionXYZ);
+	const TransformStore& GetLocalTransforms() const { return m_localTransforms; }
+
+	// recompute the world matrices below the changed nodes, returns
+	// the number of world matrices recomputed
+	size_t Update();
+	// world matrix as of the last Update()
+	const glm::mat4& GetWorldMatrix(uint32_t node) const { return m_worldMatrices[node]; }
+	glm::vec3 GetWorldPosition(uint32_t node) const { return glm::vec3(m_worldMatrices[node][3]); }
+	// changes whenever Update() recomputed at least one world matrix
+	uint32_t GetVersion() const { return m_version; }
+
+private:
+	TransformStore m_localTransforms;
+	std::vector<uint32_t> m_parents;
+	std::vector<uint32_t> m_subtreeEnds;
+	std::vector<glm::mat4> m_worldMatrices;
+	// nodes whose subtree needs new world matrices
+	std::vector<unsigned char> m_dirty;
+	uint32_t m_version = 0;
+};
@@ -11,6 +11,11 @@
 
 #include "SceneManager.h"
 
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <fstream>
 #include <iostream>
 
 #ifndef STB_IMAGE_IMPLEMENTATION
@@ -18,16 +23,73 @@
 #include "stb_image.h"
 #endif
 
-#include <glm/gtx/transform.hpp>
-
 // declaration of global variables
 namespace
 {
-	const char* g_ModelName = "model";
-	const char* g_ColorValueName = "objectColor";
 	const char* g_TextureValueName = "objectTexture";
-	const char* g_UseTextureName = "bUseTexture";
-	const char* g_UseLightingName = "bUseLighting";
+	// scene description loaded by PrepareScene()
+	const char* g_SceneFileName = "scenes/desk.scene";
+	// depth-only shaders of the shadow maps
+	const char* g_ShadowVertexShaderName = "shaders/shadowVertexShader.glsl";
+	const char* g_ShadowFragmentShaderName = "shaders/shadowFragmentShader.glsl";
+	// light reaching a surface beyond the range of the spot light
+	const float SPOT_LIGHT_CUTOFF = 1.0f / 256.0f;
+	// color of the generated ceiling lights
+	const glm::vec3 g_GeneratedLightDiffuse(0.10f, 0.095f, 0.085f);
+	const glm::vec3 g_GeneratedLightSpecular(0.05f, 0.05f, 0.05f);
+
+	bool ReadVec2(std::istringstream& line, glm::vec2& value)
+	{
+		return static_cast<bool>(line >> value.x >> value.y);
+	}
+
+	bool ReadVec3(std::istringstream& line, glm::vec3& value)
+	{
+		return static_cast<bool>(line >> value.x >> value.y >> value.z);
+	}
+
+	bool ReadVec4(std::istringstream& line, glm::vec4& value)
+	{
+		return static_cast<bool>(line >> value.x >> value.y >> value.z >> value.w);
+	}
+
+	// distance at which the attenuation of a light drops to the cutoff,
+	// solving constant + linear * d + quadratic * d^2 = 1 / cutoff
+	float GetLightRange(float constant, float linear, float quadratic, float defaultRange)
+	{
+		float target = 1.0f / SPOT_LIGHT_CUTOFF - constant;
+		if (target <= 0.0f)
+		{
+			return 0.0f;
+		}
+		if (quadratic > 0.0f)
+		{
+			return (-linear + std::sqrt(linear * linear + 4.0f * quadratic * target)) / (2.0f * quadratic);
+		}
+		if (linear > 0.0f)
+		{
+			return target / linear;
+		}
+		return defaultRange;
+	}
+
+	// replace the contents of a storage buffer and attach it to its
+	// binding point - never empty, so the binding is always valid
+	void UploadStorageBuffer(GLuint& buffer, GLuint bindingPoint, const void* pData, size_t size)
+	{
+		if (buffer == 0)
+		{
+			glGenBuffers(1, &buffer);
+		}
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, std::max(size, static_cast<size_t>(16)), NULL, GL_STREAM_DRAW);
+		if (size > 0)
+		{
+			glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, pData);
+		}
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bindingPoint, buffer);
+	}
 }
 
 /***********************************************************
@@ -39,7 +101,57 @@ SceneManager::SceneManager(ShaderManager *pShaderManager)
 {
 	m_pShaderManager = pShaderManager;
 	m_basicMeshes = new ShapeMeshes();
-	m_loadedTextures = 0;
+	// all OpenGL state changes go through the cache of the shader manager
+	m_pStateCache = (NULL != m_pShaderManager) ? m_pShaderManager->GetStateCache() : &m_localStateCache;
+	m_basicMeshes->SetStateCache(m_pStateCache);
+	m_lightManager = new LightManager();
+	m_timedObjectsBegin = 0;
+	m_timedObjectsEnd = 0;
+	m_cameraPosition = glm::vec3(0.0f, 0.0f, 0.0f);
+	m_queueSortMs = 0.0;
+	m_queueSortCount = 0;
+	m_drawCalls = 0;
+	m_drawCommandCount = 0;
+	m_drawnInstances = 0;
+	m_instanceTransformVersion = 0;
+	m_bInstancesValid = false;
+	m_instanceUploads = 0;
+	m_boundsVersion = 0;
+	m_bBoundsValid = false;
+	m_visibleCount = 0;
+	m_culledCount = 0;
+	m_textureThreads = TextureLoader::GetDefaultThreadCount();
+	m_bCompressedTextures = true;
+	m_pTextureLoader = NULL;
+	m_textureUploadBudget = DEFAULT_TEXTURE_UPLOAD_BUDGET;
+	m_bTexturesStreaming = false;
+	m_bTextureResidency = false;
+	m_screenScale = 0.0f;
+	m_bOrthographic = false;
+	m_materialBuffer = 0;
+	m_bMaterialsDirty = false;
+	m_pShadowManager = NULL;
+	m_sceneBoundsMin = glm::vec3(0.0f);
+	m_sceneBoundsMax = glm::vec3(0.0f);
+	m_staticCasterCommand = 0;
+	m_staticCasterCommandCount = 0;
+	m_movingCasterCommand = 0;
+	m_movingCasterCommandCount = 0;
+	m_pLightClusters = NULL;
+	m_lightThreads = LightClusters::GetDefaultThreadCount();
+	m_generatedLightCount = 0;
+	m_pointLightBuffer = 0;
+	m_clusterBuffer = 0;
+	m_clusterLightBuffer = 0;
+	m_clusterLightVersion = 0;
+	m_bClustersDirty = true;
+	m_pDeferredRenderer = NULL;
+	m_inverseViewProjection = glm::mat4(1.0f);
+
+	if (NULL != m_pShaderManager)
+	{
+		ResolveShaderUniforms();
+	}
 }
 
 /***********************************************************
@@ -50,318 +162,579 @@ SceneManager::SceneManager(ShaderManager *pShaderManager)
 SceneManager::~SceneManager()
 {
 	m_pShaderManager = NULL;
+	// stop the texture decoding threads
+	delete m_pTextureLoader;
+	m_pTextureLoader = NULL;
+	delete m_pShadowManager;
+	m_pShadowManager = NULL;
+	delete m_pLightClusters;
+	m_pLightClusters = NULL;
+	delete m_pDeferredRenderer;
+	m_pDeferredRenderer = NULL;
 	delete m_basicMeshes;
 	m_basicMeshes = NULL;
+	delete m_lightManager;
+	m_lightManager = NULL;
+	if (m_materialBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_materialBuffer);
+		m_materialBuffer = 0;
+	}
+	GLuint clusterBuffers[3] = { m_pointLightBuffer, m_clusterBuffer, m_clusterLightBuffer };
+	glDeleteBuffers(3, clusterBuffers);
+	m_pointLightBuffer = 0;
+	m_clusterBuffer = 0;
+	m_clusterLightBuffer = 0;
+}
+
+/***********************************************************
+ *  ResolveShaderUniforms()
+ *
+ *  This method is used for requesting the handles of all the
+ *  shader uniforms that are set while rendering, so that the
+ *  per-frame code never has to look uniforms up by name.
+ ***********************************************************/
+void SceneManager::ResolveShaderUniforms()
+{
+	m_uniforms.objectTexture = m_pShaderManager->GetUniformHandle(g_TextureValueName);
+	for (int i = 0; i < MAX_MATERIALS; ++i)
+	{
+		std::string prefix = "materials[" + std::to_string(i) + "].";
+		m_uniforms.materialDiffuseColors[i] = m_pShaderManager->GetUniformHandle(prefix + "diffuseColor");
+		m_uniforms.materialSpecularColors[i] = m_pShaderManager->GetUniformHandle(prefix + "specularColor");
+		m_uniforms.materialShininess[i] = m_pShaderManager->GetUniformHandle(prefix + "shininess");
+	}
+	m_uniforms.directionalShadowMap = m_pShaderManager->GetUniformHandle("directionalShadowMap");
+	m_uniforms.directionalShadowMatrix = m_pShaderManager->GetUniformHandle("directionalShadowMatrix");
+	m_uniforms.bDirectionalShadow = m_pShaderManager->GetUniformHandle("bDirectionalShadow");
+	m_uniforms.spotShadowMap = m_pShaderManager->GetUniformHandle("spotShadowMap");
+	m_uniforms.spotShadowMatrix = m_pShaderManager->GetUniformHandle("spotShadowMatrix");
+	m_uniforms.bSpotShadow = m_pShaderManager->GetUniformHandle("bSpotShadow");
+	m_uniforms.clusterTileScale = m_pShaderManager->GetUniformHandle("clusterTileScale");
+	m_uniforms.clusterViewDirection = m_pShaderManager->GetUniformHandle("clusterViewDirection");
+	m_uniforms.clusterDepthSlice = m_pShaderManager->GetUniformHandle("clusterDepthSlice");
 }
 
 /***********************************************************
  *  CreateGLTexture()
  *
- *  This method is used for loading textures from image files,
- *  configuring the texture mapping parameters in OpenGL,
- *  generating the mipmaps, and loading the read texture into
- *  the next available texture slot in memory.
+ *  This method is used for registering a texture image file
+ *  under a tag.  Only the image header is read here; the
+ *  pixels are loaded into a texture array layer by the next
+ *  CreateTextureArrays(), once the sizes of all the images
+ *  are known.
+ ***********************************************************/
+bool SceneManager::CreateGLTexture(const char* filename, const std::string& tag, GLint wrapMode)
+{
+	TEXTURE_INFO texture;
+	texture.tag = tag;
+	texture.filename = filename;
+	texture.wrapMode = wrapMode;
+	texture.arrayIndex = -1;
+	texture.layer = -1;
+	texture.stream = -1;
+
+	if (!stbi_info(filename, &texture.width, &texture.height, &texture.colorChannels))
+	{
+		std::cout << "Could not load image:" << filename << std::endl;
+		return false;
+	}
+	if (texture.colorChannels != 3 && texture.colorChannels != 4)
+	{
+		std::cout << "Not implemented to handle image with " << texture.colorChannels << " channels" << std::endl;
+		return false;
+	}
+
+	// the first texture loaded from a file is the one reloaded with it
+	int handle = static_cast<int>(m_textureIDs.size());
+	m_textureIDs.push_back(texture);
+	m_textureTags.Insert(tag, handle);
+	if (m_textureFiles.Find(texture.filename) == NameTable::NOT_FOUND)
+	{
+		m_textureFiles.Insert(texture.filename, handle);
+	}
+	return true;
+}
+
+/***********************************************************
+ *  CreateTextureArrays()
+ *
+ *  This method is used for loading the registered texture
+ *  images that are not in a texture array yet.  Images with
+ *  the same size, channel count and wrap mode are stacked as
+ *  layers of one GL_TEXTURE_2D_ARRAY, so any number of them
+ *  needs only one texture unit, and objects using different
+ *  layers can be drawn together.  When the driver supports
+ *  it, the arrays are BC1/BC3 compressed and their mip levels
+ *  come from the texture cache.  The layers are not loaded
+ *  here - they are handed to the TextureLoader, which streams
+ *  them in over the next frames.
  ***********************************************************/
-bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
+void SceneManager::CreateTextureArrays()
 {
-	int width = 0;
-	int height = 0;
-	int colorChannels = 0;
-	GLuint textureID = 0;
+	GLint maxLayers = 256;
+	glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
 
 	// indicate to always flip images vertically when loaded
 	stbi_set_flip_vertically_on_load(true);
 
-	// try to parse the image data from the specified image file
-	unsigned char* image = stbi_load(
-		filename,
-		&width,
-		&height,
-		&colorChannels,
-		0);
-
-	// if the image was successfully read from the image file
-	if (image)
-	{
-		std::cout << "Successfully loaded image:" << filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels << std::endl;
-
-		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_2D, textureID);
-
-		// set the texture wrapping parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// set texture filtering parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		// if the loaded image is in RGB format
-		if (colorChannels == 3)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		// if the loaded image is in RGBA format - it supports transparency
-		else if (colorChannels == 4)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-		else
+	// the arrays are created first, then all of their layers are streamed in
+	std::vector<TextureLoader::LAYER_REQUEST> requests;
+	std::vector<size_t> newTextures;
+
+	for (size_t i = 0; i < m_textureIDs.size(); ++i)
+	{
+		if (m_textureIDs[i].arrayIndex >= 0)
 		{
-			std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
-			return false;
+			continue;
 		}
 
-		// generate the texture mipmaps for mapping textures to lower resolutions
-		glGenerateMipmap(GL_TEXTURE_2D);
+		// the new textures that fit in the same array as this one
+		const TEXTURE_INFO& first = m_textureIDs[i];
+		std::vector<size_t> layers;
+		for (size_t j = i; j < m_textureIDs.size() && layers.size() < static_cast<size_t>(maxLayers); ++j)
+		{
+			const TEXTURE_INFO& texture = m_textureIDs[j];
+			if (texture.arrayIndex < 0 &&
+				texture.width == first.width &&
+				texture.height == first.height &&
+				texture.colorChannels == first.colorChannels &&
+				texture.wrapMode == first.wrapMode)
+			{
+				layers.push_back(j);
+			}
+		}
+
+		TEXTURE_ARRAY textureArray;
+		textureArray.width = first.width;
+		textureArray.height = first.height;
+		textureArray.colorChannels = first.colorChannels;
+		textureArray.wrapMode = first.wrapMode;
+		textureArray.layers = static_cast<int>(layers.size());
+
+		// compressed arrays get all of their mip levels from the texture cache
+		textureArray.compressedFormat = (m_bCompressedTextures && TextureCache::IsSupported()) ?
+			TextureCache::GetCompressedFormat(first.colorChannels) : GL_NONE;
+		textureArray.baseLevel = 0;
+		AllocateTextureArray(textureArray, 0);
+
+		int arrayIndex = static_cast<int>(m_textureArrays.size());
+		for (size_t layer = 0; layer < layers.size(); ++layer)
+		{
+			TEXTURE_INFO& texture = m_textureIDs[layers[layer]];
+			texture.arrayIndex = arrayIndex;
+			texture.layer = static_cast<int>(layer);
+
+			TextureLoader::LAYER_REQUEST request;
+			request.filename = texture.filename;
+			request.width = texture.width;
+			request.height = texture.height;
+			request.colorChannels = texture.colorChannels;
+			request.textureArray = textureArray.ID;
+			request.textureUnit = static_cast<GLuint>(arrayIndex);
+			request.layer = texture.layer;
+			request.compressedFormat = textureArray.compressedFormat;
+			requests.push_back(request);
+			newTextures.push_back(layers[layer]);
+		}
+
+		m_textureArrays.push_back(textureArray);
+		m_textureResidency.AddArray(textureArray.width, textureArray.height, textureArray.layers, textureArray.compressedFormat);
+	}
 
-		// free the image data from local memory
-		stbi_image_free(image);
-		glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
+	if (requests.empty())
+	{
+		return;
+	}
 
-		// register the loaded texture and associate it with the special tag string
-		m_textureIDs[m_loadedTextures].ID = textureID;
-		m_textureIDs[m_loadedTextures].tag = tag;
-		m_loadedTextures++;
+	if (NULL == m_pTextureLoader)
+	{
+		m_pTextureLoader = new TextureLoader(m_textureThreads);
+	}
 
-		return true;
+	// every layer starts out as a placeholder and is decoded on the
+	// worker threads, then streamed in by UpdateTextureStreaming()
+	m_textureStreamStart = std::chrono::steady_clock::now();
+	m_bTexturesStreaming = true;
+	for (size_t i = 0; i < requests.size(); ++i)
+	{
+		m_textureIDs[newTextures[i]].stream = m_pTextureLoader->AddLayer(requests[i], m_pStateCache);
 	}
+	m_textureVisible.assign(m_textureIDs.size(), 0);
 
-	std::cout << "Could not load image:" << filename << std::endl;
+	bool bCompressed = false;
+	for (const TEXTURE_ARRAY& textureArray : m_textureArrays)
+	{
+		bCompressed = bCompressed || (textureArray.compressedFormat != GL_NONE);
+	}
+	std::cout << "INFO: streaming " << requests.size() << " texture layers, decoded on "
+		<< m_textureThreads << " threads" << std::endl;
+	std::cout << "INFO: texture memory " << m_textureResidency.GetMemoryBytes() / (1024.0 * 1024.0) << " MB "
+		<< (bCompressed ? "(BC1/BC3 with cached mipmaps)" : "(RGBA8 with CPU mipmaps)") << std::endl;
+
+	// levels can only be dropped when the arrays can be copied on the GPU
+	m_bTextureResidency = TextureResidency::IsSupported();
+	if (!m_bTextureResidency)
+	{
+		std::cout << "INFO: texture residency needs OpenGL 4.3, all mip levels stay resident" << std::endl;
+	}
+	else if (m_textureResidency.GetBudget() > 0)
+	{
+		std::cout << "INFO: texture memory budget " << m_textureResidency.GetBudget() / (1024.0 * 1024.0) << " MB" << std::endl;
+	}
 
-	// Error loading the image
-	return false;
+	// without an upload budget the textures are loaded before the first frame
+	if (m_textureUploadBudget == 0)
+	{
+		m_pTextureLoader->Finish(m_pStateCache);
+		ReportTextureStreaming();
+	}
 }
 
 /***********************************************************
- *  BindGLTextures()
+ *  AllocateTextureArray()
  *
- *  This method is used for binding the loaded textures to
- *  OpenGL texture memory slots.  There are up to 16 slots.
+ *  This method is used for creating the OpenGL texture of an
+ *  array, with storage for all of its layers and for the
+ *  mip levels from its base level down to 1x1.  The pixels
+ *  are left for the TextureLoader to stream in.
  ***********************************************************/
-void SceneManager::BindGLTextures()
+void SceneManager::AllocateTextureArray(TEXTURE_ARRAY& textureArray, GLuint textureUnit)
 {
-	for (int i = 0; i < m_loadedTextures; i++)
+	glGenTextures(1, &textureArray.ID);
+	m_pStateCache->BindTexture(textureUnit, GL_TEXTURE_2D_ARRAY, textureArray.ID);
+	m_pStateCache->ActiveTexture(textureUnit);
+
+	// set the texture wrapping parameters
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, textureArray.wrapMode);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, textureArray.wrapMode);
+	int width = std::max(1, textureArray.width >> textureArray.baseLevel);
+	int height = std::max(1, textureArray.height >> textureArray.baseLevel);
+	int levelCount = TextureCache::GetMipLevelCount(width, height);
+
+	// set texture filtering parameters - the shader clamps the mip
+	// level to the finest one streamed in for each layer
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+	for (int level = 0; level < levelCount; ++level)
 	{
-		// bind textures on corresponding texture units
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, m_textureIDs[i].ID);
+		if (textureArray.compressedFormat != GL_NONE)
+		{
+			GLsizei levelSize = static_cast<GLsizei>(
+				TextureCache::GetLevelSize(textureArray.compressedFormat, width, height) * textureArray.layers);
+			glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, textureArray.compressedFormat,
+				width, height, textureArray.layers, 0, levelSize, NULL);
+		}
+		else
+		{
+			GLenum internalFormat = (textureArray.colorChannels == 4) ? GL_RGBA8 : GL_RGB8;
+			GLenum pixelFormat = (textureArray.colorChannels == 4) ? GL_RGBA : GL_RGB;
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, level, internalFormat,
+				width, height, textureArray.layers,
+				0, pixelFormat, GL_UNSIGNED_BYTE, NULL);
+		}
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
 	}
 }
 
 /***********************************************************
- *  DestroyGLTextures()
+ *  ResizeTextureArray()
  *
- *  This method is used for freeing the memory in all the
- *  used texture memory slots.
+ *  This method is used for dropping or restoring the top
+ *  mip levels of a texture array.  A texture cannot change
+ *  its size, so a new one is allocated for the levels from
+ *  baseLevel down and the levels both have in common are
+ *  copied over on the GPU before the old one is deleted.
+ *  Restored levels are streamed in by the TextureLoader.
  ***********************************************************/
-void SceneManager::DestroyGLTextures()
+void SceneManager::ResizeTextureArray(int arrayIndex, int baseLevel)
 {
-	for (int i = 0; i < m_loadedTextures; i++)
+	TEXTURE_ARRAY& textureArray = m_textureArrays[arrayIndex];
+	int oldBaseLevel = textureArray.baseLevel;
+	GLuint oldTexture = textureArray.ID;
+	textureArray.baseLevel = baseLevel;
+	AllocateTextureArray(textureArray, static_cast<GLuint>(arrayIndex));
+
+	int levelCount = TextureCache::GetMipLevelCount(textureArray.width, textureArray.height);
+	for (int level = std::max(oldBaseLevel, baseLevel); level < levelCount; ++level)
+	{
+		glCopyImageSubData(
+			oldTexture, GL_TEXTURE_2D_ARRAY, level - oldBaseLevel, 0, 0, 0,
+			textureArray.ID, GL_TEXTURE_2D_ARRAY, level - baseLevel, 0, 0, 0,
+			std::max(1, textureArray.width >> level), std::max(1, textureArray.height >> level), textureArray.layers);
+	}
+	glDeleteTextures(1, &oldTexture);
+
+	for (const TEXTURE_INFO& texture : m_textureIDs)
 	{
-		glGenTextures(1, &m_textureIDs[i].ID);
+		if (texture.arrayIndex == arrayIndex && texture.stream >= 0)
+		{
+			m_pTextureLoader->SetLayerTexture(texture.stream, textureArray.ID, baseLevel);
+		}
+	}
+	m_textureResidency.SetBaseLevel(arrayIndex, baseLevel);
+
+	// the instances hold the finest level each object may sample
+	m_bInstancesValid = false;
+	if (baseLevel < oldBaseLevel && !m_bTexturesStreaming)
+	{
+		m_textureStreamStart = std::chrono::steady_clock::now();
+		m_bTexturesStreaming = true;
 	}
 }
 
 /***********************************************************
- *  FindTextureID()
+ *  UpdateTextureResidency()
  *
- *  This method is used for getting an ID for the previously
- *  loaded texture bitmap associated with the passed in tag.
+ *  This method is used for matching the mip levels held by
+ *  the texture arrays to the objects on screen.  Each queued
+ *  object covers about the projected diameter of its world
+ *  bounds in pixels, which together with its UV scale gives
+ *  the finest level its texture is sampled at.  Arrays drop
+ *  the levels above the finest any of their objects needs
+ *  and get them back when the camera comes closer.
  ***********************************************************/
-int SceneManager::FindTextureID(std::string tag)
+void SceneManager::UpdateTextureResidency()
 {
-	int textureID = -1;
-	int index = 0;
-	bool bFound = false;
+	if (!m_bTextureResidency || NULL == m_pTextureLoader)
+	{
+		return;
+	}
 
-	while ((index < m_loadedTextures) && (bFound == false))
+	const SCENE_OBJECTS& objects = m_sceneObjects;
+	m_textureResidency.BeginFrame();
+	for (const RenderQueue::RENDER_ITEM& item : m_renderQueue.GetItems())
 	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
+		size_t i = item.objectIndex;
+		if (objects.textured[i] == 0 || objects.textureArrays[i] < 0)
 		{
-			textureID = m_textureIDs[index].ID;
-			bFound = true;
+			continue;
 		}
-		else
-			index++;
+
+		glm::vec3 center = (m_worldBoundsMins[i] + m_worldBoundsMaxs[i]) * 0.5f;
+		float radius = glm::length(m_worldBoundsMaxs[i] - m_worldBoundsMins[i]) * 0.5f;
+		float screenPixels = 2.0f * radius * m_screenScale;
+		if (!m_bOrthographic)
+		{
+			// the near side of the bounds, the camera may be inside them
+			float distance = glm::length(center - m_cameraPosition) - radius;
+			screenPixels = (distance > 0.0f) ? screenPixels / distance : FLT_MAX;
+		}
+		float uvRepeats = std::max(objects.uvScales[i].x, objects.uvScales[i].y);
+		m_textureResidency.RequestLevel(objects.textureArrays[i], screenPixels, uvRepeats);
 	}
 
-	return(textureID);
+	m_textureResidency.Update(m_resizedArrays);
+	for (int arrayIndex : m_resizedArrays)
+	{
+		ResizeTextureArray(arrayIndex, m_textureResidency.GetTargetLevel(arrayIndex));
+	}
 }
 
 /***********************************************************
- *  FindTextureSlot()
+ *  ReloadTexture()
  *
- *  This method is used for getting a slot index for the previously
- *  loaded texture bitmap associated with the passed in tag.
+ *  This method is used for streaming a loaded texture in
+ *  again after its image file changed on disk.  The old
+ *  texture stays in use until the new image is decoded, so
+ *  rendering does not stall.  An image that changed size or
+ *  format no longer fits its array and is only picked up by
+ *  a restart.
  ***********************************************************/
-int SceneManager::FindTextureSlot(std::string tag)
+bool SceneManager::ReloadTexture(const std::string& filename)
 {
-	int textureSlot = -1;
-	int index = 0;
-	bool bFound = false;
-
-	while ((index < m_loadedTextures) && (bFound == false))
+	int handle = m_textureFiles.Find(filename);
+	if (handle == NameTable::NOT_FOUND || m_textureIDs[handle].stream < 0)
 	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureSlot = index;
-			bFound = true;
-		}
-		else
-			index++;
+		return false;
 	}
 
-	return(textureSlot);
+	const TEXTURE_INFO& texture = m_textureIDs[handle];
+	std::cout << "Reloading texture:" << texture.tag << " from " << texture.filename << std::endl;
+	m_pTextureLoader->ReloadLayer(texture.stream);
+	m_textureStreamStart = std::chrono::steady_clock::now();
+	m_bTexturesStreaming = true;
+	return true;
 }
 
 /***********************************************************
- *  FindMaterial()
+ *  UpdateTextureStreaming()
  *
- *  This method is used for getting a material from the previously
- *  defined materials list that is associated with the passed in tag.
+ *  This method is used for streaming texture mip levels in
+ *  within the upload budget of a frame.  Textures of the
+ *  objects in the render queue are the ones in view, so they
+ *  are decoded and uploaded first.  Once a layer gains a
+ *  sharper level the instance data is rewritten, since it
+ *  holds the finest level each object may sample.
  ***********************************************************/
-bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
+void SceneManager::UpdateTextureStreaming()
 {
-	if (m_objectMaterials.size() == 0)
+	if (NULL == m_pTextureLoader || !m_bTexturesStreaming)
 	{
-		return(false);
+		return;
 	}
 
-	int index = 0;
-	bool bFound = false;
-	while ((index < m_objectMaterials.size()) && (bFound == false))
+	const SCENE_OBJECTS& objects = m_sceneObjects;
+	std::fill(m_textureVisible.begin(), m_textureVisible.end(), 0);
+	for (const RenderQueue::RENDER_ITEM& item : m_renderQueue.GetItems())
 	{
-		if (m_objectMaterials[index].tag.compare(tag) == 0)
+		if (objects.textured[item.objectIndex] != 0)
 		{
-			bFound = true;
-			material.diffuseColor = m_objectMaterials[index].diffuseColor;
-			material.specularColor = m_objectMaterials[index].specularColor;
-			material.shininess = m_objectMaterials[index].shininess;
+			m_textureVisible[objects.textures[item.objectIndex].index] = 1;
 		}
-		else
+	}
+	for (size_t i = 0; i < m_textureIDs.size(); ++i)
+	{
+		if (m_textureIDs[i].stream >= 0)
 		{
-			index++;
+			m_pTextureLoader->SetLayerVisible(m_textureIDs[i].stream, m_textureVisible[i] != 0);
 		}
 	}
 
-	return(true);
+	if (m_pTextureLoader->Update(m_textureUploadBudget, m_pStateCache))
+	{
+		m_bInstancesValid = false;
+	}
+	ReportTextureStreaming();
 }
 
 /***********************************************************
- *  SetTransformations()
+ *  ReportTextureStreaming()
  *
- *  This method is used for setting the transform buffer
- *  using the passed in transformation values.
+ *  This method is used for printing how long it took to
+ *  stream the textures in at the levels they are held at.
  ***********************************************************/
-void SceneManager::SetTransformations(
-	glm::vec3 scaleXYZ,
-	float XrotationDegrees,
-	float YrotationDegrees,
-	float ZrotationDegrees,
-	glm::vec3 positionXYZ,
-	glm::vec3 offset)
+void SceneManager::ReportTextureStreaming()
 {
-	// variables for this method
-	glm::mat4 model;
-	glm::mat4 scale;
-	glm::mat4 rotationX;
-	glm::mat4 rotationY;
-	glm::mat4 rotationZ;
-	glm::mat4 translation;
-
-	// set the scale value in the transform buffer
-	scale = glm::scale(scaleXYZ);
-	// set the rotation values in the transform buffer
-	rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
-	rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
-	rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
-	// set the translation value in the transform buffer
-	translation = glm::translate(positionXYZ + offset);
-
-	model = translation * rotationZ * rotationY * rotationX * scale;
+	if (!m_bTexturesStreaming || m_pTextureLoader->GetStreamingCount() > 0)
+	{
+		return;
+	}
 
-	if (NULL != m_pShaderManager)
+	m_bTexturesStreaming = false;
+	m_bInstancesValid = false;
+	double streamMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_textureStreamStart).count();
+	std::cout << "INFO: all " << m_pTextureLoader->GetLayerCount() << " texture layers streamed in after "
+		<< streamMs << " ms";
+	if (m_pTextureLoader->GetEncodedCount() > 0)
 	{
-		m_pShaderManager->setMat4Value(g_ModelName, model);
+		std::cout << ", " << m_pTextureLoader->GetEncodedCount() << " compressed into the texture cache";
 	}
+	std::cout << std::endl;
 }
 
 /***********************************************************
- *  SetShaderColor()
+ *  BindGLTextures()
  *
- *  This method is used for setting the passed in color
- *  into the shader for the next draw command
+ *  This method is used for binding the texture arrays to
+ *  OpenGL texture units, one unit per array.
  ***********************************************************/
-void SceneManager::SetShaderColor(
-	float redColorValue,
-	float greenColorValue,
-	float blueColorValue,
-	float alphaValue)
+void SceneManager::BindGLTextures()
 {
-	// variables for this method
-	glm::vec4 currentColor;
-
-	currentColor.r = redColorValue;
-	currentColor.g = greenColorValue;
-	currentColor.b = blueColorValue;
-	currentColor.a = alphaValue;
+	GLint maxUnits = 16;
+	glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &maxUnits);
+	// the units from there up hold the shadow maps
+	maxUnits = std::min(maxUnits, static_cast<GLint>(ShadowManager::FIRST_TEXTURE_UNIT));
+	if (static_cast<GLint>(m_textureArrays.size()) > maxUnits)
+	{
+		std::cerr << "ERROR: " << m_textureArrays.size() << " texture arrays do not fit in "
+			<< maxUnits << " texture units" << std::endl;
+	}
 
-	if (NULL != m_pShaderManager)
+	for (size_t i = 0; i < m_textureArrays.size() && static_cast<GLint>(i) < maxUnits; i++)
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, false);
-		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
+		// bind texture arrays on corresponding texture units
+		m_pStateCache->BindTexture(static_cast<GLuint>(i), GL_TEXTURE_2D_ARRAY, m_textureArrays[i].ID);
 	}
 }
 
 /***********************************************************
- *  SetShaderTexture()
+ *  DestroyGLTextures()
  *
- *  This method is used for setting the texture data
- *  associated with the passed in ID into the shader.
+ *  This method is used for freeing the memory of all the
+ *  texture arrays.
  ***********************************************************/
-void SceneManager::SetShaderTexture(
-	std::string textureTag)
+void SceneManager::DestroyGLTextures()
 {
-	if (NULL != m_pShaderManager)
+	for (size_t i = 0; i < m_textureArrays.size(); i++)
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, true);
-
-		int textureID = -1;
-		textureID = FindTextureSlot(textureTag);
-		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
+		m_pStateCache->BindTexture(static_cast<GLuint>(i), GL_TEXTURE_2D_ARRAY, 0);
+		glDeleteTextures(1, &m_textureArrays[i].ID);
 	}
+	m_textureArrays.clear();
+	m_textureIDs.clear();
+	m_textureTags.Clear();
+	m_textureFiles.Clear();
+	m_textureResidency.Clear();
+	delete m_pTextureLoader;
+	m_pTextureLoader = NULL;
+	m_bTexturesStreaming = false;
 }
 
 /***********************************************************
- *  SetTextureUVScale()
+ *  FindTextureID()
  *
- *  This method is used for setting the texture UV scale
- *  values into the shader.
+ *  This method is used for getting the ID of the texture
+ *  array holding the previously loaded texture bitmap
+ *  associated with the passed in tag.
  ***********************************************************/
-void SceneManager::SetTextureUVScale(float u, float v)
+int SceneManager::FindTextureID(const std::string& tag) const
 {
-	if (NULL != m_pShaderManager)
+	int textureID = -1;
+	TextureHandle texture = FindTexture(tag);
+	if (texture.IsValid() && m_textureIDs[texture.index].arrayIndex >= 0)
 	{
-		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
+		textureID = static_cast<int>(m_textureArrays[m_textureIDs[texture.index].arrayIndex].ID);
 	}
+
+	return(textureID);
+}
+
+/***********************************************************
+ *  FindTexture()
+ *
+ *  This method is used for getting the handle of the
+ *  previously loaded texture bitmap associated with the
+ *  passed in tag, through the hash table of texture tags.
+ ***********************************************************/
+TextureHandle SceneManager::FindTexture(const std::string& tag) const
+{
+	TextureHandle texture;
+	texture.index = m_textureTags.Find(tag);
+	return(texture);
+}
+
+/***********************************************************
+ *  FindMaterial()
+ *
+ *  This method is used for getting the handle of a defined
+ *  material by tag, invalid when there is no such material.
+ ***********************************************************/
+MaterialHandle SceneManager::FindMaterial(const std::string& tag) const
+{
+	MaterialHandle material;
+	material.index = m_materialTags.Find(tag);
+	return(material);
 }
 
 /***********************************************************
- *  SetShaderMaterial()
+ *  SetShaderTexture()
  *
- *  This method is used for passing the material values
- *  into the shader.
+ *  This method is used for setting the texture array holding
+ *  the texture of the passed in handle into the shader.  The
+ *  layer comes from the instance data.
  ***********************************************************/
-void SceneManager::SetShaderMaterial(
-	std::string materialTag)
+void SceneManager::SetShaderTexture(TextureHandle texture)
 {
-	if (m_objectMaterials.size() > 0)
+	if (NULL != m_pShaderManager)
 	{
-		OBJECT_MATERIAL material;
-		bool bReturn = false;
+		m_pShaderManager->SetFeature(ShaderManager::FEATURE_TEXTURE, true);
 
-		bReturn = FindMaterial(materialTag, material);
-		if (bReturn == true)
+		if (texture.IsValid())
 		{
-			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
+			m_pShaderManager->setSampler2DValue(m_uniforms.objectTexture, m_textureIDs[texture.index].arrayIndex);
 		}
 	}
 }
@@ -393,584 +766,1448 @@ void SceneManager::PrepareScene()
 	m_basicMeshes->LoadHemisphereMesh();
 	m_basicMeshes->LoadPentagonalPrismMesh();
 
-	CreateGLTexture(
-		"textures/bark_5-4K/bark_5-4K/4K-bark_5-diffuse.jpg",
-		"bark");
-	CreateGLTexture(
-		"textures/blue_plaster_19-4K/blue_plaster_19-4K/4K-plaster_19.jpg-diffuse.jpg",
-		"blue_plaster");
-	CreateGLTexture(
-		"textures/PaintedPlaster002_4K-JPG/PaintedPlaster002_4K_Color.jpg",
-		"painted_plaster");
-	CreateGLTexture(
-		"textures/SurfaceImperfections016_4K-JPG/SurfaceImperfections016_4K_Color.jpg",
-		"surface_imperfections");
-	CreateGLTexture(
-		"textures/keyboard.jpg",
-		"keyboard");
-	CreateGLTexture(
-		"textures/black_leather_24-4K/black_leather_24-4K/4K-Leather_24_Base Color.jpg",
-		"black_leather");
-	CreateGLTexture(
-		"textures/mouse.png",
-		"mouse");
-	CreateGLTexture(
-		"textures/Jojo.jpg",
-		"jojo");
-	CreateGLTexture(
-		"textures/background.jpeg",
-		"background");
-	CreateGLTexture(
-		"textures/black_metal-4K/black_metal-4K/4K-metal_5-specular.jpg",
-		"black_metal");
-	CreateGLTexture(
-		"textures/brick_wall_001_4K-JPG/brick_wall_001/brick_wall_001_diffuse_4k.jpg",
-		"brick_wall");
-	CreateGLTexture(
-		"textures/Paper001_4K-JPG/Paper001_4K_Color.jpg",
-		"roof");
-	CreateGLTexture(
-		"textures/afromosia-4K/afromosia-4K/4K_afromosia_basecolor.png",
-		"afromosia_floor");
-
-	// Use standard repeat for the keyboard texture (no mirroring).
-	{
-		int keyboardTextureID = FindTextureID("keyboard");
-		if (keyboardTextureID >= 0)
-		{
-			glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(keyboardTextureID));
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-			glBindTexture(GL_TEXTURE_2D, 0);
-		}
-	}
-
-	// Clamp the mouse texture to avoid repeating artifacts on the body.
-	{
-		int mouseTextureID = FindTextureID("mouse");
-		if (mouseTextureID >= 0)
-		{
-			glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(mouseTextureID));
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-			glBindTexture(GL_TEXTURE_2D, 0);
+	// the lights live in a uniform buffer that is written once here
+	// and only re-uploaded when a light changes
+	m_lightManager->CreateLightBuffer();
+	if (NULL != m_pShaderManager)
+	{
+		m_pShaderManager->BindUniformBlock("LightBlock", LightManager::LIGHT_BLOCK_BINDING);
+		// the materials live in a storage buffer written when the scene
+		// file is loaded, on drivers that support them
+		m_pShaderManager->BindStorageBlock("MaterialBlock", MATERIAL_BLOCK_BINDING);
+
+		// the shadow samplers always point at their own units, so they
+		// never share a unit with a texture array even without shadows
+		m_pShaderManager->setSampler2DValue(m_uniforms.directionalShadowMap,
+			ShadowManager::FIRST_TEXTURE_UNIT + ShadowManager::SHADOW_DIRECTIONAL);
+		m_pShaderManager->setSampler2DValue(m_uniforms.spotShadowMap,
+			ShadowManager::FIRST_TEXTURE_UNIT + ShadowManager::SHADOW_SPOT);
+		// point lights are culled into clusters where the shader can read
+		// the light lists from storage buffers
+		if (m_pShaderManager->GetStorageBuffersSupported())
+		{
+			m_pShaderManager->BindStorageBlock("PointLightBlock", POINT_LIGHT_BLOCK_BINDING);
+			m_pShaderManager->BindStorageBlock("ClusterBlock", CLUSTER_BLOCK_BINDING);
+			m_pShaderManager->BindStorageBlock("ClusterLightBlock", CLUSTER_LIGHT_BLOCK_BINDING);
+			m_pLightClusters = new LightClusters(m_lightThreads);
+			std::cout << "INFO: Point lights culled into " << LightClusters::CLUSTER_COUNT << " clusters ("
+				<< LightClusters::GRID_X << "x" << LightClusters::GRID_Y << "x" << LightClusters::GRID_Z << ") on "
+				<< std::max(m_pLightClusters->GetThreadCount(), 1) << " threads" << std::endl;
+		}
+		else
+		{
+			std::cout << "INFO: No storage buffers, only the first " << LightManager::TOTAL_POINT_LIGHTS
+				<< " point lights are shaded" << std::endl;
+		}
+
+		m_pShadowManager = new ShadowManager(m_pStateCache);
+		if (m_pShadowManager->Create(g_ShadowVertexShaderName, g_ShadowFragmentShaderName) == false)
+		{
+			std::cerr << "ERROR: Shadow maps are disabled" << std::endl;
+			delete m_pShadowManager;
+			m_pShadowManager = NULL;
 		}
 	}
 
+	// the textures, materials, lights and objects come from the scene file
+	if (LoadSceneFile(g_SceneFileName) == false)
+	{
+		std::cerr << "ERROR: Could not load scene file: " << g_SceneFileName << std::endl;
+	}
+
 	BindGLTextures();
+	m_lightManager->UploadLights();
+	PrebuildShaderVariants();
 }
 
 /***********************************************************
- *  RenderScene()
+ *  ReloadScene()
  *
- *  This method is used for rendering the 3D scene by 
- *  transforming and drawing the basic 3D shapes
+ *  This method is used for loading the scene file again after
+ *  it changed on disk.  Textures that are already loaded are
+ *  kept, new ones are loaded and bound.
  ***********************************************************/
-void SceneManager::RenderScene()
+bool SceneManager::ReloadScene()
 {
-	// declare the variables for the transformations
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
+	if (LoadSceneFile(g_SceneFileName) == false)
+	{
+		std::cerr << "ERROR: Could not reload scene file: " << g_SceneFileName << std::endl;
+		return false;
+	}
 
-	if (NULL != m_pShaderManager)
+	BindGLTextures();
+	m_lightManager->UploadLights();
+	PrebuildShaderVariants();
+	return true;
+}
+
+/***********************************************************
+ *  ReloadShadowShaders()
+ *
+ *  This method is used for rebuilding the shadow map shader
+ *  program after its source changed on disk.
+ ***********************************************************/
+void SceneManager::ReloadShadowShaders()
+{
+	if (NULL != m_pShadowManager)
 	{
-		m_pShaderManager->setIntValue(g_UseLightingName, true);
-		m_pShaderManager->setVec3Value("material.diffuseColor", glm::vec3(1.0f, 1.0f, 1.0f));
-		m_pShaderManager->setVec3Value("material.specularColor", glm::vec3(0.35f, 0.35f, 0.35f));
-		m_pShaderManager->setFloatValue("material.shininess", 32.0f);
-
-		// Soft directional light to lift the scene and reveal plane highlights.
-		glm::vec3 previousAmbient = glm::vec3(0.28f, 0.28f, 0.28f);
-		glm::vec3 currentAmbient = glm::vec3(0.28f, 0.28f, 0.28f);
-		// Ambient values saved for quick restore after testing.
-		glm::vec3 directionalAmbientDefault = currentAmbient;
-		m_pShaderManager->setVec3Value("directionalLight.direction", glm::vec3(-0.2f, -1.0f, -0.1f));
-		m_pShaderManager->setVec3Value("directionalLight.ambient", directionalAmbientDefault);
-		m_pShaderManager->setVec3Value("directionalLight.diffuse", glm::vec3(0.18f, 0.18f, 0.18f));
-		m_pShaderManager->setVec3Value("directionalLight.specular", glm::vec3(0.22f, 0.22f, 0.22f));
-		m_pShaderManager->setIntValue("directionalLight.bActive", true);
-
-		// Disable unused point lights.
-		for (int i = 0; i < 5; ++i)
-		{
-			std::string lightBase = "pointLights[" + std::to_string(i) + "]";
-			m_pShaderManager->setIntValue(lightBase + ".bActive", false);
-		}
-
-		// Disable the monitor point light glow (spotlight used instead).
-		m_pShaderManager->setIntValue("pointLights[0].bActive", false);
-
-		// Soft point light fill to satisfy the point light requirement.
-		m_pShaderManager->setVec3Value("pointLights[1].position", glm::vec3(-12.5f, 18.0f, 0.0f));
-		glm::vec3 pointLightAmbientDefault = glm::vec3(0.12f, 0.12f, 0.12f);
-		m_pShaderManager->setVec3Value("pointLights[1].ambient", glm::vec3(0.0f, 0.0f, 0.0f)); // restore: pointLightAmbientDefault
-		m_pShaderManager->setVec3Value("pointLights[1].diffuse", glm::vec3(0.35f, 0.35f, 0.35f));
-		m_pShaderManager->setVec3Value("pointLights[1].specular", glm::vec3(0.25f, 0.25f, 0.25f));
-		m_pShaderManager->setIntValue("pointLights[1].bActive", true);
-
-		// Monitor spotlight aimed forward so it only lights what's in front of the screen.
-		glm::vec3 spotLightPosition(-7.3f, 4.2f, -2.15f);
-		glm::vec3 screenTarget(-7.3f, 3.0f, 1.0f);
-		glm::vec3 spotLightDirection = glm::normalize(screenTarget - spotLightPosition);
-		m_pShaderManager->setVec3Value("spotLight.position", spotLightPosition);
-		m_pShaderManager->setVec3Value("spotLight.direction", spotLightDirection);
-		m_pShaderManager->setFloatValue("spotLight.cutOff", glm::cos(glm::radians(20.0f)));
-		m_pShaderManager->setFloatValue("spotLight.outerCutOff", glm::cos(glm::radians(32.0f)));
-		m_pShaderManager->setFloatValue("spotLight.constant", 1.0f);
-		m_pShaderManager->setFloatValue("spotLight.linear", 0.30f);
-		m_pShaderManager->setFloatValue("spotLight.quadratic", 0.28f);
-		glm::vec3 spotLightAmbientDefault = glm::vec3(0.20f, 0.12f, 0.24f);
-		m_pShaderManager->setVec3Value("spotLight.ambient", glm::vec3(0.0f, 0.0f, 0.0f)); // restore: spotLightAmbientDefault
-		m_pShaderManager->setVec3Value("spotLight.diffuse", glm::vec3(8.50f, 5.75f, 10.50f));
-		m_pShaderManager->setVec3Value("spotLight.specular", glm::vec3(5.50f, 4.00f, 6.50f));
-		m_pShaderManager->setIntValue("spotLight.bActive", true);
-	}
-
-	// Marker cube at the point light position to help visualize the emitter.
-	// {
-	// 	glm::vec3 markerScale = glm::vec3(1.0f, 1.0f, 1.0f);
-	// 	glm::vec3 markerPosition = glm::vec3(-12.5f, 18.0f, 0.0f);
-	// 	SetTransformations(
-	// 		markerScale,
-	// 		0.0f,
-	// 		0.0f,
-	// 		0.0f,
-	// 		markerPosition);
-	// 	if (NULL != m_pShaderManager)
-	// 	{
-	// 		m_pShaderManager->setIntValue(g_UseLightingName, false);
-	// 	}
-	// 	SetShaderColor(1.0f, 0.95f, 0.2f, 1.0f);
-	// 	m_basicMeshes->DrawBoxMesh();
-	// 	if (NULL != m_pShaderManager)
-	// 	{
-	// 		m_pShaderManager->setIntValue(g_UseLightingName, true);
-	// 	}
-	// }
-
-	/*** Set needed transformations before drawing the basic mesh.  ***/
-	/*** This same ordering of code should be used for transforming ***/
-	/*** and drawing all the basic 3D shapes.						***/
-	/******************************************************************/
-	//set the XYZ scale for the mesh (table)
-	// draw back wall
-	scaleXYZ = glm::vec3(104.0f, 1.0f, 50.0f);
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(-12.5f, 10.0f, -37.5f);
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-	if (NULL != m_pShaderManager)
+		m_pShadowManager->ReloadShaders();
+	}
+}
+
+/***********************************************************
+ *  LoadSceneFile()
+ *
+ *  This method is used for loading a scene description file.
+ *  Each line starts with a keyword - texture, material, a
+ *  light type, object or group - followed by its values (see
+ *  the comments at the top of the scene file for the format).
+ *  Invalid lines are reported and skipped.  Groups become
+ *  scene graph nodes that their objects are placed under.
+ ***********************************************************/
+bool SceneManager::LoadSceneFile(const std::string& filename)
+{
+	std::ifstream sceneFile(filename);
+	if (!sceneFile.is_open())
 	{
-		m_pShaderManager->setIntValue(g_UseLightingName, false);
+		return false;
 	}
-	SetShaderTexture("background");
-	SetTextureUVScale(1.0f, -1.0f);
-	m_basicMeshes->DrawPlaneMesh();
-	if (NULL != m_pShaderManager)
+
+	auto startTime = std::chrono::steady_clock::now();
+
+	m_sceneObjects = SCENE_OBJECTS();
+	m_sceneGraph.Clear();
+	m_bInstancesValid = false;
+	m_bBoundsValid = false;
+	m_timedObjectsBegin = 0;
+	m_timedObjectsEnd = 0;
+	// every caster of the new scene starts out in the static shadow depth
+	m_movingObjects.clear();
+	if (NULL != m_pShadowManager)
 	{
-		m_pShaderManager->setIntValue(g_UseLightingName, true);
-	}
-
-	// draw floor (1/5 back, 4/5 front)
-	scaleXYZ = glm::vec3(104.0f, 1.0f, 75.0f);
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(-12.5f, -15.0f, 0.0f);
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-	SetShaderTexture("afromosia_floor");
-	SetTextureUVScale(6.0f, 6.0f);
-	m_basicMeshes->DrawPlaneMesh();
-
-	// draw left wall
-	scaleXYZ = glm::vec3(75.0f, 1.0f, 50.0f);
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 90.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(-64.5f, 10.0f, 0.0f);
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-	SetShaderTexture("brick_wall");
-	SetTextureUVScale(4.0f, 2.0f);
-	m_basicMeshes->DrawPlaneMesh();
-
-	// draw right wall
-	scaleXYZ = glm::vec3(75.0f, 1.0f, 50.0f);
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = -90.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(39.5f, 10.0f, 0.0f);
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-	SetShaderTexture("brick_wall");
-	SetTextureUVScale(4.0f, 2.0f);
-	m_basicMeshes->DrawPlaneMesh();
-
-	// draw front wall
-	scaleXYZ = glm::vec3(104.0f, 1.0f, 50.0f);
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 180.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(-12.5f, 10.0f, 37.5f);
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-	SetShaderTexture("brick_wall");
-	SetTextureUVScale(6.0f, 2.0f);
-	m_basicMeshes->DrawPlaneMesh();
-
-	// draw roof (portrait texture rotated to landscape)
-	scaleXYZ = glm::vec3(104.0f, 1.0f, 75.0f);
-	XrotationDegrees = 180.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(-12.5f, 35.0f, 0.0f);
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-	SetShaderTexture("roof");
-	SetTextureUVScale(-1.0f, 1.0f);
-	m_basicMeshes->DrawPlaneMesh();
-
-	//set the XYZ scale for the mesh (table)
-	scaleXYZ = glm::vec3(40.0f, 0.6f, 10.0f);
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 180.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(0.0f, -0.4f, 0.0f);
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-	if (NULL != m_pShaderManager)
+		m_pShadowManager->InvalidateAll();
+	}
+
+	// only the lights listed in the scene file are active, the generated
+	// point lights are added once the scene bounds are known
+	m_lightManager->ClearDirectionalLight();
+	m_lightManager->ClearPointLights();
+	m_lightManager->ClearSpotLight();
+
+	// groups that enclose the current line, innermost last
+	std::vector<uint32_t> groupNodes;
+
+	std::string text;
+	int lineNumber = 0;
+	while (std::getline(sceneFile, text))
 	{
-		m_pShaderManager->setVec3Value("material.diffuseColor", glm::vec3(1.0f, 1.0f, 1.0f));
-		m_pShaderManager->setVec3Value("material.specularColor", glm::vec3(1.2f, 1.2f, 1.2f));
-		m_pShaderManager->setFloatValue("material.shininess", 128.0f);
-	}
-	SetShaderTexture("bark");
-	SetTextureUVScale(4.0f, 4.0f);
-	m_basicMeshes->DrawBoxMesh();
-
-	// draw table legs (square posts + smashed sphere feet)
-	float tableHalfX = 20.0f;
-	float tableHalfZ = 5.0f;
-	float legInsetX = 1.5f;
-	float legInsetZ = 1.0f;
-	float tableBottomY = -0.7f;
-	float floorY = -15.0f;
-	float legHeight = tableBottomY - floorY;
-	float legCenterY = floorY + (legHeight * 0.5f);
-	float legSize = 1.2f;
-	glm::vec3 footScale = glm::vec3(2.4f, 0.4f, 2.4f);
-	float footCenterY = floorY;
-	glm::vec3 legOffsets[4] = {
-		glm::vec3(tableHalfX - legInsetX, 0.0f, tableHalfZ - legInsetZ),
-		glm::vec3(-(tableHalfX - legInsetX), 0.0f, tableHalfZ - legInsetZ),
-		glm::vec3(tableHalfX - legInsetX, 0.0f, -(tableHalfZ - legInsetZ)),
-		glm::vec3(-(tableHalfX - legInsetX), 0.0f, -(tableHalfZ - legInsetZ))
-	};
+		lineNumber++;
+
+		// strip comments and skip empty lines
+		size_t comment = text.find('#');
+		if (comment != std::string::npos)
+		{
+			text.erase(comment);
+		}
+		std::istringstream line(text);
+		std::string keyword;
+		if (!(line >> keyword))
+		{
+			continue;
+		}
+
+		bool bValid = true;
+		if (keyword == "texture")
+		{
+			// the file name may contain spaces, so it is the rest
+			// of the line without an optional wrap mode at the end
+			std::string tag;
+			std::string path;
+			line >> tag;
+			std::getline(line >> std::ws, path);
+			path.erase(path.find_last_not_of(" \t\r") + 1);
+
+			GLint wrapMode = GL_REPEAT;
+			size_t lastSpace = path.find_last_of(" \t");
+			if (lastSpace != std::string::npos)
+			{
+				std::string option = path.substr(lastSpace + 1);
+				if (option == "repeat" || option == "clamp")
+				{
+					wrapMode = (option == "clamp") ? GL_CLAMP_TO_EDGE : GL_REPEAT;
+					path.erase(path.find_last_not_of(" \t", lastSpace) + 1);
+				}
+			}
+
+			bValid = !tag.empty() && !path.empty();
+			if (bValid && !FindTexture(tag).IsValid())
+			{
+				CreateGLTexture(path.c_str(), tag, wrapMode);
+			}
+		}
+		else if (keyword == "material")
+		{
+			std::string tag;
+			OBJECT_MATERIAL material;
+			material.padding = 0.0f;
+			bValid = (line >> tag) &&
+				ReadVec3(line, material.diffuseColor) &&
+				ReadVec3(line, material.specularColor) &&
+				(line >> material.shininess);
+			if (bValid)
+			{
+				MaterialHandle handle = FindMaterial(tag);
+				bool bStorageBuffer = (NULL != m_pShaderManager) && m_pShaderManager->GetStorageBuffersSupported();
+				if (handle.IsValid())
+				{
+					m_objectMaterials[handle.index] = material;
+					m_bMaterialsDirty = true;
+				}
+				else if (bStorageBuffer || m_objectMaterials.size() < MAX_MATERIALS)
+				{
+					m_materialTags.Insert(tag, static_cast<int>(m_objectMaterials.size()));
+					m_objectMaterials.push_back(material);
+					m_bMaterialsDirty = true;
+				}
+				else
+				{
+					std::cerr << "ERROR: More than " << MAX_MATERIALS << " materials, skipping " << tag << std::endl;
+				}
+			}
+		}
+		else if (keyword == "directional_light")
+		{
+			glm::vec3 direction, ambient, diffuse, specular;
+			bValid = ReadVec3(line, direction) && ReadVec3(line, ambient) &&
+				ReadVec3(line, diffuse) && ReadVec3(line, specular);
+			if (bValid)
+			{
+				m_lightManager->SetDirectionalLight(direction, ambient, diffuse, specular);
+			}
+		}
+		else if (keyword == "point_light")
+		{
+			int index = -1;
+			glm::vec3 position, ambient, diffuse, specular;
+			bValid = (line >> index) && ReadVec3(line, position) && ReadVec3(line, ambient) &&
+				ReadVec3(line, diffuse) && ReadVec3(line, specular) &&
+				index >= 0 && index < LightManager::MAX_POINT_LIGHTS;
+			// the range is optional, without it the light reaches everything
+			float range = 0.0f;
+			if (!(line >> range))
+			{
+				range = 0.0f;
+			}
+			if (bValid)
+			{
+				m_lightManager->SetPointLight(index, position, ambient, diffuse, specular, std::max(range, 0.0f));
+			}
+		}
+		else if (keyword == "spot_light")
+		{
+			glm::vec3 position, target, ambient, diffuse, specular;
+			float cutOffDegrees = 0.0f, outerCutOffDegrees = 0.0f;
+			float constant = 0.0f, linear = 0.0f, quadratic = 0.0f;
+			bValid = ReadVec3(line, position) && ReadVec3(line, target) &&
+				(line >> cutOffDegrees >> outerCutOffDegrees >> constant >> linear >> quadratic) &&
+				ReadVec3(line, ambient) && ReadVec3(line, diffuse) && ReadVec3(line, specular);
+			if (bValid)
+			{
+				m_lightManager->SetSpotLight(
+					position,
+					glm::normalize(target - position),
+					glm::cos(glm::radians(cutOffDegrees)),
+					glm::cos(glm::radians(outerCutOffDegrees)),
+					constant,
+					linear,
+					quadratic,
+					ambient,
+					diffuse,
+					specular);
+			}
+		}
+		else if (keyword == "object")
+		{
+			uint32_t parentNode = groupNodes.empty() ? SceneGraph::NO_PARENT : groupNodes.back();
+			bValid = ParseSceneObject(line, parentNode);
+		}
+		else if (keyword == "group")
+		{
+			// the objects up to the matching end_group are placed
+			// relative to the group
+			std::string name;
+			glm::vec3 scaleXYZ, rotationXYZ, positionXYZ;
+			bValid = (line >> name) && ReadVec3(line, scaleXYZ) &&
+				ReadVec3(line, rotationXYZ) && ReadVec3(line, positionXYZ);
+			if (bValid)
+			{
+				uint32_t parentNode = groupNodes.empty() ? SceneGraph::NO_PARENT : groupNodes.back();
+				groupNodes.push_back(m_sceneGraph.AddNode(parentNode, scaleXYZ, rotationXYZ, positionXYZ));
+			}
+		}
+		else if (keyword == "end_group")
+		{
+			bValid = !groupNodes.empty();
+			if (bValid)
+			{
+				groupNodes.pop_back();
+			}
+		}
+		else if (keyword == "gpu_timer_begin")
+		{
+			m_timedObjectsBegin = m_sceneObjects.names.size();
+			m_timedObjectsEnd = m_timedObjectsBegin;
+		}
+		else if (keyword == "gpu_timer_end")
+		{
+			m_timedObjectsEnd = m_sceneObjects.names.size();
+		}
+		else
+		{
+			bValid = false;
+		}
 
-	SetShaderTexture("black_metal");
-	SetTextureUVScale(1.0f, 1.0f);
-	for (int i = 0; i < 4; ++i)
-	{
-		glm::vec3 legPos = glm::vec3(legOffsets[i].x, legCenterY, legOffsets[i].z);
-		SetTransformations(
-			glm::vec3(legSize, legHeight, legSize),
-			0.0f,
-			0.0f,
-			0.0f,
-			legPos);
-		m_basicMeshes->DrawBoxMesh();
-
-		glm::vec3 footPos = glm::vec3(legOffsets[i].x, footCenterY, legOffsets[i].z);
-		SetTransformations(
-			footScale,
-			0.0f,
-			0.0f,
-			0.0f,
-			footPos);
-		m_basicMeshes->DrawFlatSphereMesh();
-	}
-
-	// draw mouse pad (17.5% of table surface area)
-	scaleXYZ = glm::vec3(17.0f, 1.0f, 5.0f);
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(-4.5f, -0.05f, 1.5f);
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-	SetShaderTexture("surface_imperfections");
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawPlaneMesh();
-
-	// draw keyboard (78-key footprint, tilted plane, match texture aspect)
-	scaleXYZ = glm::vec3(8.4f, 1.0f, 2.74f);
-	XrotationDegrees = -15.0f;
-	YrotationDegrees = 190.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(-7.3f, 0.317f, 1.13f);
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-	SetShaderTexture("keyboard");
-	SetTextureUVScale(-1.0f, 1.0f);
-	m_basicMeshes->DrawPlaneMesh();
-
-	// draw keyboard wedge (fill gap to mousepad)
-	scaleXYZ = glm::vec3(8.4f, 0.71f, 2.74f);
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 190.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(-7.3f, -0.05f, 1.13f);
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-	SetShaderTexture("black_leather");
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawWedgeMesh();
-
-	// draw mouse (three-piece approximation)
-	// dimensions based on Apple Magic Mouse 2, scaled up for visibility and to fit the mouse pad
-	//Decided to use this one since I had so much trouble with the textures. Magic Mouse 2 does not have any visible textures. :)
-	float mouseLength = 0.113f;
-	float mouseWidth = 0.057f;
-	float mouseHeight = 0.021f;
-	float mouseScaleFactor = 15.0f;
-	float cylinderLength = (mouseLength - mouseWidth) * mouseScaleFactor;
-	float mouseHeightScaled = mouseHeight * mouseScaleFactor;
-	float mouseWidthScaled = mouseWidth * mouseScaleFactor;
-	float mouseYaw = -45.0f;
-	glm::vec3 mousePosition = glm::vec3(-1.04f, -0.05f + (mouseHeightScaled * 0.5f), 1.13f);
-	glm::vec3 cylinderScale = glm::vec3(cylinderLength, mouseHeightScaled, mouseWidthScaled);
-	glm::vec3 capScale = glm::vec3(mouseWidthScaled, mouseHeightScaled, mouseWidthScaled);
-
-	glm::mat4 mouseRotation = glm::rotate(glm::radians(mouseYaw), glm::vec3(0.0f, 1.0f, 0.0f));
-	glm::vec3 frontOffset = glm::vec3(cylinderLength * 0.5f, 0.0f, 0.0f);
-	glm::vec3 backOffset = glm::vec3(-cylinderLength * 0.5f, 0.0f, 0.0f);
-	glm::vec3 frontPosition = mousePosition + glm::vec3(mouseRotation * glm::vec4(frontOffset, 1.0f));
-	glm::vec3 backPosition = mousePosition + glm::vec3(mouseRotation * glm::vec4(backOffset, 1.0f));
+		if (!bValid)
+		{
+			std::cerr << "ERROR: " << filename << ":" << lineNumber << ": invalid scene line: " << text << std::endl;
+		}
+	}
 
-	if (NULL != m_pShaderManager)
+	if (!groupNodes.empty())
 	{
-		m_pShaderManager->setVec3Value("material.specularColor", glm::vec3(0.7f, 0.7f, 0.7f));
-		m_pShaderManager->setFloatValue("material.shininess", 128.0f);
-	}
-	SetShaderColor(1.0f, 1.0f, 1.0f, 1.0f);
-
-	// middle cylinder
-	SetTransformations(
-		cylinderScale,
-		0.0f,
-		mouseYaw,
-		0.0f,
-		mousePosition);
-	m_basicMeshes->DrawCylinderMesh();
-
-	// front hemisphere
-	SetTransformations(
-		capScale,
-		0.0f,
-		mouseYaw,
-		0.0f,
-		frontPosition);
-	m_basicMeshes->DrawHemisphereMesh();
-
-	// back hemisphere (rotate 180 to face backward)
-	SetTransformations(
-		capScale,
-		0.0f,
-		mouseYaw + 180.0f,
-		0.0f,
-		backPosition);
-	m_basicMeshes->DrawHemisphereMesh();
-
-	// draw monitor base (flat sphere)
-	scaleXYZ = glm::vec3(3.0f, 0.2f, 3.0f);
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 180.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(-7.3f, 0.0f, -2.5f);
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-	SetShaderColor(0.12f, 0.12f, 0.12f, 1.0f);
-	m_basicMeshes->DrawFlatSphereMesh();
-
-	// draw monitor neck (pentagonal prism)
-	scaleXYZ = glm::vec3(0.7f, 1.5f, 0.5f);
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 180.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(-7.3f, 1.0f, -2.5f);
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-	SetShaderColor(0.18f, 0.18f, 0.18f, 1.0f);
-	m_basicMeshes->DrawPentagonalPrismMesh();
-
-	// draw monitor frame (thin box)
-	float screenWidth = 8.4f;
-	float screenHeight = screenWidth * (9.0f / 16.0f);
-	float frameHeight = screenHeight + 0.5f;
-	float screenWidthInner = screenWidth - 0.1f;
-	float screenHeightInner = screenHeight - 0.1f;
-	scaleXYZ = glm::vec3(screenWidth, 0.12f, frameHeight);
-	XrotationDegrees = -90.0f;
-	YrotationDegrees = 180.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(-7.3f, 4.2f, -2.30f);
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-	SetShaderColor(0.08f, 0.08f, 0.08f, 1.0f);
-	m_basicMeshes->DrawBoxMesh();
-
-	// draw monitor screen (1080p aspect, shifted up for bottom bezel)
-	scaleXYZ = glm::vec3(screenWidthInner, 1.0f, screenHeightInner);
-	XrotationDegrees = -90.0f;
-	YrotationDegrees = 180.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(-7.3f, 4.2f + 0.25f, -2.22f);
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-	SetShaderTexture("jojo");
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawPlaneMesh();
-
-	// draw hollow mug body (light blue)
-	scaleXYZ = glm::vec3(2.0f, 4.0f, 2.0f); // radius = 2, height = 4
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(10.0f, 2.0f, -2.5f); // shifted X+10, Z=-2.5
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-	if (NULL != m_pShaderManager)
+		std::cerr << "ERROR: " << filename << ": " << groupNodes.size() << " group(s) without end_group" << std::endl;
+	}
+
+	// load the new textures and materials, then look up the array
+	// and layer of every textured object
+	CreateTextureArrays();
+	UploadMaterials();
+	SCENE_OBJECTS& objects = m_sceneObjects;
+	objects.textureArrays.assign(objects.names.size(), 0);
+	objects.textureLayers.assign(objects.names.size(), 0);
+	for (size_t i = 0; i < objects.names.size(); ++i)
+	{
+		if (objects.textured[i] != 0)
+		{
+			const TEXTURE_INFO& texture = m_textureIDs[objects.textures[i].index];
+			objects.textureArrays[i] = std::max(texture.arrayIndex, 0);
+			objects.textureLayers[i] = std::max(texture.layer, 0);
+		}
+	}
+
+	double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	std::cout << "INFO: Loaded scene " << filename << " with " << m_sceneObjects.names.size()
+		<< " objects (" << m_sceneGraph.GetNodeCount() << " scene graph nodes) in " << elapsedMs << " ms" << std::endl;
+	return true;
+}
+
+/***********************************************************
+ *  ParseSceneObject()
+ *
+ *  This method is used for reading the values of an object
+ *  line and appending the object to the scene arrays.  The
+ *  tags are resolved here, so nothing is looked up while
+ *  rendering.
+ ***********************************************************/
+bool SceneManager::ParseSceneObject(std::istringstream& line, uint32_t parentNode)
+{
+	std::string name, meshName, surface, materialTag, lighting, cullMode;
+	glm::vec3 scaleXYZ, rotationXYZ, positionXYZ;
+	if (!(line >> name >> meshName) ||
+		!ReadVec3(line, scaleXYZ) ||
+		!ReadVec3(line, rotationXYZ) ||
+		!ReadVec3(line, positionXYZ) ||
+		!(line >> surface))
+	{
+		return false;
+	}
+
+	int mesh = ShapeMeshes::FindMeshType(meshName);
+	if (mesh < 0)
+	{
+		return false;
+	}
+
+	// objects are either textured or a solid color
+	bool bTextured = false;
+	TextureHandle texture;
+	glm::vec4 color(1.0f, 1.0f, 1.0f, 1.0f);
+	if (surface == "texture")
+	{
+		std::string textureTag;
+		if (!(line >> textureTag))
+		{
+			return false;
+		}
+		texture = FindTexture(textureTag);
+		if (!texture.IsValid())
+		{
+			std::cerr << "ERROR: Unknown texture " << textureTag << " for object " << name << std::endl;
+			return false;
+		}
+		bTextured = true;
+	}
+	else if (surface != "color" || !ReadVec4(line, color))
 	{
-		m_pShaderManager->setVec3Value("material.diffuseColor", glm::vec3(1.0f, 1.0f, 1.0f));
-		m_pShaderManager->setVec3Value("material.specularColor", glm::vec3(0.3f, 0.3f, 0.3f));
-		m_pShaderManager->setFloatValue("material.shininess", 16.0f);
-	}
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
-	SetShaderTexture("painted_plaster");
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawHollowCylinderMesh();
-	glCullFace(GL_FRONT);
-	SetShaderTexture("blue_plaster");
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawHollowCylinderMesh();
-	glDisable(GL_CULL_FACE);
-
-	//** draw thin inner cylinder (painted plaster lining)
-	scaleXYZ = glm::vec3(1.99f, 4.0f, 1.99f); // slightly smaller radius to fit just inside the hollow mug body
-	XrotationDegrees = 0.0f;                  // could not get the main cylinder to get a different plaster
-	YrotationDegrees = 0.0f;                  // texture in the inside vs. the outside, so I added a second cylinder for the inside.
-	ZrotationDegrees = 0.0f;                  // Hopefully I learn how to by next assignment!
-	positionXYZ = glm::vec3(10.0f, 2.0f, -2.5f);
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_FRONT);
-	SetShaderTexture("painted_plaster");
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawHollowCylinderMesh();
-	glDisable(GL_CULL_FACE); 
-
-	// draw mug base (flat sphere)
-	scaleXYZ = glm::vec3(4.0f, 0.2f, 4.0f); // match mug outer diameter
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(10.0f, 0.1f, -2.5f); // shifted X+10, Z=-2.5
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-	SetShaderTexture("surface_imperfections");
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawFlatSphereMesh();
-
-	// draw mug handle (torus)
-	scaleXYZ = glm::vec3(1.6f, 1.6f, 1.6f); // uniform scale to keep donut shape
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 90.0f; // rotate so the ring is vertical
-	positionXYZ = glm::vec3(12.0f, 2.0f, -2.5f); // shifted X+10, Z=2.5
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-	SetShaderTexture("blue_plaster");
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawTorusMesh();
-	/****************************************************************/
+		return false;
+	}
+
+	glm::vec2 uvScale;
+	if (!ReadVec2(line, uvScale) || !(line >> materialTag >> lighting >> cullMode))
+	{
+		return false;
+	}
+
+	MaterialHandle material = FindMaterial(materialTag);
+	if (!material.IsValid())
+	{
+		std::cerr << "ERROR: Unknown material " << materialTag << " for object " << name << std::endl;
+		return false;
+	}
+	if ((lighting != "lit" && lighting != "unlit") ||
+		(cullMode != "none" && cullMode != "back" && cullMode != "front"))
+	{
+		return false;
+	}
+
+	uint32_t node = m_sceneGraph.AddNode(parentNode, scaleXYZ, rotationXYZ, positionXYZ);
+	if (node == SceneGraph::NO_PARENT)
+	{
+		return false;
+	}
+
+	m_sceneObjects.names.push_back(name);
+	m_sceneObjects.nodes.push_back(node);
+	m_sceneObjects.meshes.push_back(static_cast<ShapeMeshes::MeshType>(mesh));
+	m_sceneObjects.textured.push_back(bTextured ? 1 : 0);
+	m_sceneObjects.textures.push_back(texture);
+	m_sceneObjects.colors.push_back(color);
+	m_sceneObjects.uvScales.push_back(uvScale);
+	m_sceneObjects.materials.push_back(material);
+	m_sceneObjects.lit.push_back(lighting == "lit" ? 1 : 0);
+	m_sceneObjects.culled.push_back(cullMode != "none" ? 1 : 0);
+	m_sceneObjects.cullFaces.push_back(cullMode == "front" ? GL_FRONT : GL_BACK);
+	m_sceneObjects.transparent.push_back(color.a < 1.0f ? 1 : 0);
+	return true;
+}
+
+/***********************************************************
+ *  RenderScene()
+ *
+ *  This method is used for rendering the 3D scene by 
+ *  drawing the objects loaded from the scene file
+ ***********************************************************/
+void SceneManager::RenderScene()
+{
+	if (NULL == m_pShaderManager)
+	{
+		return;
+	}
+
+	// send any light changes to the light uniform block and
+	// select the lit shader permutations for the active lights
+	m_lightManager->UploadLights();
+	// clustered point lights are looped over at runtime, whatever the count
+	m_pShaderManager->SetActiveLights(
+		m_lightManager->IsDirectionalLightActive(),
+		(NULL != m_pLightClusters) ? 0 : m_lightManager->GetActivePointLightCount(),
+		m_lightManager->IsSpotLightActive());
+
+	// only the subtrees changed since the last frame are recomputed
+	m_sceneGraph.Update();
+	CullSceneObjects();
+	BuildRenderQueue();
+	UpdateTextureResidency();
+	UpdateTextureStreaming();
+	UploadInstances();
+	UpdateLightClusters();
+	RenderShadowMaps();
+
+	// the queue is sorted by pass, so each pass is one range
+	size_t opaqueBegin = m_renderQueue.FindPassBegin(RenderQueue::PASS_OPAQUE);
+	size_t transparentBegin = m_renderQueue.FindPassBegin(RenderQueue::PASS_TRANSPARENT);
+	if (NULL != m_pDeferredRenderer)
+	{
+		m_pDeferredRenderer->BeginGeometryPass();
+	}
+	m_wallPassTimer.Begin();
+	DrawQueuedObjects(0, opaqueBegin);
+	m_wallPassTimer.End();
+	m_opaquePassTimer.Begin();
+	DrawQueuedObjects(opaqueBegin, transparentBegin);
+	m_opaquePassTimer.End();
+	// the deferred pipeline shades the opaque pixels once they are all
+	// drawn, the transparent objects are always shaded forward over them
+	if (NULL != m_pDeferredRenderer)
+	{
+		m_pDeferredRenderer->EndGeometryPass();
+		m_pDeferredRenderer->RenderLightPass(m_inverseViewProjection);
+	}
+	DrawQueuedObjects(transparentBegin, m_renderQueue.GetItems().size());
+}
+
+/***********************************************************
+ *  SetDeferredShading()
+ *
+ *  This method is used for switching between the forward
+ *  and the deferred pipeline.  The G-buffer is created for
+ *  the viewport by the next SetCamera(), and freed again
+ *  when the forward pipeline is selected.
+ ***********************************************************/
+bool SceneManager::SetDeferredShading(bool bEnabled)
+{
+	if (!bEnabled || NULL == m_pShaderManager)
+	{
+		delete m_pDeferredRenderer;
+		m_pDeferredRenderer = NULL;
+		return !bEnabled;
+	}
+
+	if (NULL == m_pDeferredRenderer)
+	{
+		m_pDeferredRenderer = new DeferredRenderer(m_pShaderManager);
+		std::cout << "INFO: Deferred shading, the opaque objects are lit in one pass over a G-buffer" << std::endl;
+		// before PrepareScene the lights are not known yet, it prebuilds
+		// the deferred passes once the scene is loaded
+		if (!m_sceneObjects.names.empty())
+		{
+			PrebuildShaderVariants();
+		}
+	}
+	return true;
+}
+
+/***********************************************************
+ *  SetCamera()
+ *
+ *  This method is used for setting the camera of the next
+ *  frame, used for culling, for sorting by distance and for
+ *  the size of the objects on screen.
+ ***********************************************************/
+void SceneManager::SetCamera(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPosition)
+{
+	m_frustumCuller.SetFrustum(projection * view);
+	m_cameraPosition = cameraPosition;
+
+	// a projected height of 2 fills the viewport
+	GLint viewport[4] = { 0, 0, 0, 0 };
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	m_screenScale = projection[1][1] * viewport[3] * 0.5f;
+	m_bOrthographic = (projection[3][3] == 1.0f);
+
+	// the G-buffer follows the size of the viewport
+	if (NULL != m_pDeferredRenderer)
+	{
+		m_inverseViewProjection = glm::inverse(projection * view);
+		if (!m_pDeferredRenderer->Resize(viewport[2], viewport[3]))
+		{
+			std::cerr << "ERROR: No G-buffer, shading the opaque objects forward" << std::endl;
+			SetDeferredShading(false);
+		}
+	}
+
+	if (NULL != m_pLightClusters)
+	{
+		if (m_pLightClusters->SetCamera(view, projection))
+		{
+			m_bClustersDirty = true;
+		}
+		// the fragment shader finds its cluster from its pixel and its
+		// depth along the view direction
+		m_pShaderManager->setVec2Value(m_uniforms.clusterTileScale, glm::vec2(
+			static_cast<float>(LightClusters::GRID_X) / std::max(viewport[2], 1),
+			static_cast<float>(LightClusters::GRID_Y) / std::max(viewport[3], 1)));
+		m_pShaderManager->setVec3Value(m_uniforms.clusterViewDirection,
+			-glm::vec3(view[0][2], view[1][2], view[2][2]));
+		m_pShaderManager->setVec2Value(m_uniforms.clusterDepthSlice,
+			glm::vec2(m_pLightClusters->GetDepthSliceScale(), m_pLightClusters->GetDepthSliceBias()));
+	}
+}
+
+/***********************************************************
+ *  CullSceneObjects()
+ *
+ *  This method is used for flagging the objects that are
+ *  inside the camera frustum.  The world-space box of each
+ *  object is its mesh box transformed by the world matrix,
+ *  recomputed only after the scene graph changed.  The
+ *  boxes go to both the SIMD culler and the bounding volume
+ *  hierarchy, which is built once per scene and refit after.
+ *  Large scenes are culled through the hierarchy, small ones
+ *  with the linear SIMD test.
+ ***********************************************************/
+void SceneManager::CullSceneObjects()
+{
+	const SCENE_OBJECTS& objects = m_sceneObjects;
+	size_t objectCount = objects.names.size();
+	if (!m_bBoundsValid || m_boundsVersion != m_sceneGraph.GetVersion())
+	{
+		m_frustumCuller.Resize(objectCount);
+		m_worldBoundsMins.resize(objectCount);
+		m_worldBoundsMaxs.resize(objectCount);
+		m_movingObjects.resize(objectCount, 0);
+		m_sceneBoundsMin = glm::vec3(FLT_MAX);
+		m_sceneBoundsMax = glm::vec3(-FLT_MAX);
+		for (size_t i = 0; i < objectCount; ++i)
+		{
+			const ShapeMeshes::MESH_BOUNDS& bounds = m_basicMeshes->GetMeshBounds(objects.meshes[i]);
+			const glm::mat4& world = m_sceneGraph.GetWorldMatrix(objects.nodes[i]);
+			glm::vec3 localCenter = (bounds.min + bounds.max) * 0.5f;
+			glm::vec3 localExtents = (bounds.max - bounds.min) * 0.5f;
+
+			glm::vec3 center(world * glm::vec4(localCenter, 1.0f));
+			glm::vec3 extents =
+				glm::abs(glm::vec3(world[0])) * localExtents.x +
+				glm::abs(glm::vec3(world[1])) * localExtents.y +
+				glm::abs(glm::vec3(world[2])) * localExtents.z;
+			m_frustumCuller.SetBox(i, center, extents);
+			glm::vec3 boundsMin = center - extents;
+			glm::vec3 boundsMax = center + extents;
+			if (m_bBoundsValid && (boundsMin != m_worldBoundsMins[i] || boundsMax != m_worldBoundsMaxs[i]))
+			{
+				// a moved caster leaves the static shadow depth for good
+				if (NULL != m_pShadowManager && objects.transparent[i] == 0)
+				{
+					m_pShadowManager->ObjectMoved(m_worldBoundsMins[i], m_worldBoundsMaxs[i],
+						boundsMin, boundsMax, m_movingObjects[i] == 0);
+				}
+				m_movingObjects[i] = 1;
+			}
+			m_worldBoundsMins[i] = boundsMin;
+			m_worldBoundsMaxs[i] = boundsMax;
+			m_sceneBoundsMin = glm::min(m_sceneBoundsMin, boundsMin);
+			m_sceneBoundsMax = glm::max(m_sceneBoundsMax, boundsMax);
+			if (m_bBoundsValid)
+			{
+				m_bvh.SetObjectBounds(static_cast<uint32_t>(i), m_worldBoundsMins[i], m_worldBoundsMaxs[i]);
+			}
+		}
+		if (objectCount == 0)
+		{
+			m_sceneBoundsMin = glm::vec3(0.0f);
+			m_sceneBoundsMax = glm::vec3(0.0f);
+		}
+
+		if (m_bBoundsValid)
+		{
+			m_bvh.Refit();
+		}
+		else
+		{
+			m_bvh.Build(m_worldBoundsMins, m_worldBoundsMaxs);
+			AddGeneratedLights();
+		}
+		m_boundsVersion = m_sceneGraph.GetVersion();
+		m_bBoundsValid = true;
+	}
+
+	size_t visibleCount = 0;
+	if (objectCount >= BVH_CULL_MIN_OBJECTS)
+	{
+		m_bvh.QueryFrustum(m_frustumCuller.GetPlanes(), m_bvhVisibleObjects);
+		m_visibleObjects.assign(objectCount, 0);
+		for (uint32_t objectIndex : m_bvhVisibleObjects)
+		{
+			m_visibleObjects[objectIndex] = 1;
+		}
+		visibleCount = m_bvhVisibleObjects.size();
+	}
+	else
+	{
+		visibleCount = m_frustumCuller.Cull(m_visibleObjects);
+	}
+	m_visibleCount += static_cast<unsigned int>(visibleCount);
+	m_culledCount += static_cast<unsigned int>(objectCount - visibleCount);
+}
+
+/***********************************************************
+ *  PickObject()
+ *
+ *  This method is used for finding the object surface that
+ *  a ray hits first.  The bounding volume hierarchy gives the
+ *  objects whose boxes the ray enters, nearest first, and
+ *  only those are tested triangle by triangle, stopping once
+ *  the next box starts behind the nearest hit.  The ray is
+ *  moved into the local space of each object instead of
+ *  moving every triangle into world space; the direction is
+ *  not normalized there, so the hit distance stays in world
+ *  units.
+ ***********************************************************/
+bool SceneManager::PickObject(const glm::vec3& origin, const glm::vec3& direction, PICK_RESULT& result)
+{
+	result = PICK_RESULT();
+	if (!m_bBoundsValid)
+	{
+		return false;
+	}
+
+	const SCENE_OBJECTS& objects = m_sceneObjects;
+	const float EPSILON = 1e-7f;
+	float nearestDistance = FLT_MAX;
+
+	m_bvh.QueryRay(origin, direction, FLT_MAX, m_pickHits);
+	for (const BoundingVolumeHierarchy::RAY_HIT& hit : m_pickHits)
+	{
+		if (hit.distance >= nearestDistance)
+		{
+			break;
+		}
+
+		uint32_t objectIndex = hit.objectIndex;
+		glm::mat4 inverseWorld = glm::inverse(m_sceneGraph.GetWorldMatrix(objects.nodes[objectIndex]));
+		glm::vec3 localOrigin(inverseWorld * glm::vec4(origin, 1.0f));
+		glm::vec3 localDirection(inverseWorld * glm::vec4(direction, 0.0f));
+
+		// Moller-Trumbore ray/triangle test, both sides of each triangle
+		const std::vector<glm::vec3>& positions = m_basicMeshes->GetMeshPositions(objects.meshes[objectIndex]);
+		for (size_t i = 0; i + 2 < positions.size(); i += 3)
+		{
+			glm::vec3 edge1 = positions[i + 1] - positions[i];
+			glm::vec3 edge2 = positions[i + 2] - positions[i];
+			glm::vec3 p = glm::cross(localDirection, edge2);
+			float determinant = glm::dot(edge1, p);
+			if (std::fabs(determinant) < EPSILON)
+			{
+				continue;
+			}
+
+			float inverseDeterminant = 1.0f / determinant;
+			glm::vec3 t = localOrigin - positions[i];
+			float u = glm::dot(t, p) * inverseDeterminant;
+			if (u < 0.0f || u > 1.0f)
+			{
+				continue;
+			}
+			glm::vec3 q = glm::cross(t, edge1);
+			float v = glm::dot(localDirection, q) * inverseDeterminant;
+			if (v < 0.0f || u + v > 1.0f)
+			{
+				continue;
+			}
+
+			float distance = glm::dot(edge2, q) * inverseDeterminant;
+			if (distance > 0.0f && distance < nearestDistance)
+			{
+				nearestDistance = distance;
+				result.objectIndex = static_cast<int>(objectIndex);
+			}
+		}
+	}
+
+	if (result.objectIndex < 0)
+	{
+		return false;
+	}
+	result.name = objects.names[result.objectIndex];
+	result.distance = nearestDistance;
+	result.point = origin + direction * nearestDistance;
+	return true;
+}
+
+/***********************************************************
+ *  BuildRenderQueue()
+ *
+ *  This method is used for queueing every visible scene
+ *  object with a sort key and sorting the queue.  Opaque
+ *  objects end up grouped by shader permutation, texture and
+ *  mesh, so that consecutive draws share as much state as
+ *  possible, and transparent objects are drawn last from
+ *  back to front.
+ ***********************************************************/
+void SceneManager::BuildRenderQueue()
+{
+	auto startTime = std::chrono::steady_clock::now();
+
+	const SCENE_OBJECTS& objects = m_sceneObjects;
+	m_renderQueue.Clear();
+	for (size_t i = 0; i < objects.names.size(); ++i)
+	{
+		if (m_visibleObjects[i] == 0)
+		{
+			continue;
+		}
+
+		RenderQueue::RENDER_PASS pass = RenderQueue::PASS_OPAQUE;
+		if (objects.transparent[i] != 0)
+		{
+			pass = RenderQueue::PASS_TRANSPARENT;
+		}
+		else if (i >= m_timedObjectsBegin && i < m_timedObjectsEnd)
+		{
+			pass = RenderQueue::PASS_TIMED;
+		}
+
+		uint32_t variant =
+			(objects.lit[i] != 0 ? ShaderManager::FEATURE_LIGHTING : 0) |
+			(objects.textured[i] != 0 ? ShaderManager::FEATURE_TEXTURE : 0);
+		glm::vec3 position = m_sceneGraph.GetWorldPosition(objects.nodes[i]);
+		float depth = glm::length(position - m_cameraPosition);
+
+		m_renderQueue.Push(
+			RenderQueue::MakeKey(pass, variant, objects.textureArrays[i], objects.meshes[i], depth),
+			static_cast<uint32_t>(i));
+	}
+	m_renderQueue.Sort();
+
+	m_queueSortMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	m_queueSortCount++;
+}
+
+/***********************************************************
+ *  UploadInstances()
+ *
+ *  This method is used for writing the model matrix, color,
+ *  UV scale and material of every queued object into the
+ *  instance buffer, in queue order, with a single upload,
+ *  followed by the draw commands that reference them.
+ *  While the queue order and the transforms stay the same
+ *  the buffers already hold these values and are left alone.
+ ***********************************************************/
+void SceneManager::UploadInstances()
+{
+	const SCENE_OBJECTS& objects = m_sceneObjects;
+	const std::vector<RenderQueue::RENDER_ITEM>& items = m_renderQueue.GetItems();
+
+	bool bChanged = !m_bInstancesValid ||
+		m_instanceTransformVersion != m_sceneGraph.GetVersion() ||
+		m_instanceOrder.size() != items.size();
+	for (size_t item = 0; !bChanged && item < items.size(); ++item)
+	{
+		bChanged = (m_instanceOrder[item] != items[item].objectIndex);
+	}
+	if (!bChanged)
+	{
+		return;
+	}
+
+	m_instances.resize(items.size());
+	m_instanceOrder.resize(items.size());
+	for (size_t item = 0; item < items.size(); ++item)
+	{
+		WriteInstance(items[item].objectIndex, m_instances[item]);
+		m_instanceOrder[item] = items[item].objectIndex;
+	}
+
+	BuildDrawBatches();
+	AppendShadowCasters();
+	m_basicMeshes->UploadInstances(m_instances.data(), m_instances.size());
+	m_basicMeshes->UploadDrawCommands(m_drawCommands.data(), m_drawCommands.size());
+
+	m_instanceTransformVersion = m_sceneGraph.GetVersion();
+	m_bInstancesValid = true;
+	m_instanceUploads++;
+}
+
+/***********************************************************
+ *  WriteInstance()
+ *
+ *  This method is used for writing the model matrix, color,
+ *  UV scale, material and texture layer of a scene object
+ *  into its instance values.
+ ***********************************************************/
+void SceneManager::WriteInstance(size_t objectIndex, ShapeMeshes::INSTANCE_DATA& instance) const
+{
+	const SCENE_OBJECTS& objects = m_sceneObjects;
+	size_t i = objectIndex;
+	instance.model = m_sceneGraph.GetWorldMatrix(objects.nodes[i]);
+	instance.color = objects.colors[i];
+	instance.uvScale = objects.uvScales[i];
+	instance.materialIndex = static_cast<GLuint>(objects.materials[i].index);
+	instance.textureLayer = static_cast<GLuint>(objects.textureLayers[i]);
+	if (objects.textured[i] != 0 && m_textureIDs[objects.textures[i].index].stream >= 0)
+	{
+		// the finest mip level streamed in so far goes in the high bits,
+		// counted from the finest level the array still holds
+		int residentLevel = m_pTextureLoader->GetResidentLevel(m_textureIDs[objects.textures[i].index].stream) -
+			m_textureArrays[objects.textureArrays[i]].baseLevel;
+		instance.textureLayer |= static_cast<GLuint>(std::max(residentLevel, 0)) << 16;
+	}
+}
+
+/***********************************************************
+ *  AppendShadowCasters()
+ *
+ *  This method is used for adding the shadow casters after
+ *  the queued objects in the instance buffer, so both the
+ *  camera pass and the shadow passes draw from the same
+ *  buffer.  Every opaque object casts, in view of the camera
+ *  or not.  The static casters come first and the moving
+ *  ones after, each sorted by mesh for one draw command per
+ *  mesh, which makes every shadow pass one multi-draw call.
+ ***********************************************************/
+void SceneManager::AppendShadowCasters()
+{
+	m_staticCasterCommandCount = 0;
+	m_movingCasterCommandCount = 0;
+	if (NULL == m_pShadowManager)
+	{
+		return;
+	}
+
+	const SCENE_OBJECTS& objects = m_sceneObjects;
+	m_casterOrder.clear();
+	for (size_t i = 0; i < objects.names.size(); ++i)
+	{
+		if (objects.transparent[i] == 0)
+		{
+			m_casterOrder.push_back(static_cast<uint32_t>(i));
+		}
+	}
+	std::sort(m_casterOrder.begin(), m_casterOrder.end(), [this, &objects](uint32_t a, uint32_t b)
+	{
+		if (m_movingObjects[a] != m_movingObjects[b])
+		{
+			return m_movingObjects[a] < m_movingObjects[b];
+		}
+		return objects.meshes[a] != objects.meshes[b] ? objects.meshes[a] < objects.meshes[b] : a < b;
+	});
+
+	size_t firstInstance = m_instances.size();
+	m_instances.resize(firstInstance + m_casterOrder.size());
+	m_staticCasterCommand = m_drawCommands.size();
+	size_t first = 0;
+	while (first < m_casterOrder.size())
+	{
+		uint32_t i = m_casterOrder[first];
+		if (m_movingObjects[i] != 0 && m_movingCasterCommandCount == 0)
+		{
+			m_staticCasterCommandCount = m_drawCommands.size() - m_staticCasterCommand;
+			m_movingCasterCommand = m_drawCommands.size();
+		}
+
+		size_t last = first + 1;
+		while (last < m_casterOrder.size() &&
+			objects.meshes[m_casterOrder[last]] == objects.meshes[i] &&
+			m_movingObjects[m_casterOrder[last]] == m_movingObjects[i])
+		{
+			++last;
+		}
+		for (size_t caster = first; caster < last; ++caster)
+		{
+			WriteInstance(m_casterOrder[caster], m_instances[firstInstance + caster]);
+		}
+		m_drawCommands.push_back(m_basicMeshes->GetDrawCommand(objects.meshes[i],
+			static_cast<int>(firstInstance + first), static_cast<int>(last - first)));
+		if (m_movingObjects[i] != 0)
+		{
+			m_movingCasterCommandCount++;
+		}
+		first = last;
+	}
+	if (m_movingCasterCommandCount == 0)
+	{
+		m_staticCasterCommandCount = m_drawCommands.size() - m_staticCasterCommand;
+	}
+}
+
+/***********************************************************
+ *  RenderShadowMaps()
+ *
+ *  This method is used for placing the shadow map cameras on
+ *  the directional and spot lights, rendering the maps that
+ *  are out of date and setting them into the shader.  In
+ *  most frames no map is drawn at all; a map is drawn again
+ *  when its light changes, and only its moving casters are
+ *  drawn again when they move in view of the light.
+ ***********************************************************/
+void SceneManager::RenderShadowMaps()
+{
+	if (NULL == m_pShadowManager)
+	{
+		return;
+	}
+
+	const LightManager::DIRECTIONAL_LIGHT& directionalLight = m_lightManager->GetDirectionalLight();
+	const LightManager::SPOT_LIGHT& spotLight = m_lightManager->GetSpotLight();
+	float sceneSize = glm::length(m_sceneBoundsMax - m_sceneBoundsMin);
+	m_pShadowManager->SetDirectionalLight(directionalLight.direction, m_sceneBoundsMin, m_sceneBoundsMax,
+		directionalLight.bActive != 0);
+	m_pShadowManager->SetSpotLight(spotLight.position, spotLight.direction, spotLight.outerCutOff,
+		std::min(GetLightRange(spotLight.constant, spotLight.linear, spotLight.quadratic, sceneSize), sceneSize),
+		spotLight.bActive != 0);
+	m_pShadowManager->SetMovingCasters(m_movingCasterCommandCount > 0);
+
+	bool bRendered = false;
+	for (int i = 0; i < ShadowManager::SHADOW_MAP_COUNT; ++i)
+	{
+		ShadowManager::SHADOW_MAP map = static_cast<ShadowManager::SHADOW_MAP>(i);
+		if (m_pShadowManager->BeginStaticPass(map))
+		{
+			m_basicMeshes->DrawMeshesIndirect(m_staticCasterCommand, m_staticCasterCommandCount);
+			m_pShadowManager->EndPass();
+			bRendered = true;
+		}
+		if (m_pShadowManager->BeginMovingPass(map))
+		{
+			m_basicMeshes->DrawMeshesIndirect(m_movingCasterCommand, m_movingCasterCommandCount);
+			m_pShadowManager->EndPass();
+			bRendered = true;
+		}
+	}
+	m_pShadowManager->EndFrame();
+	m_pShadowManager->BindShadowMaps();
+
+	// back to the scene program, the shadow passes bound their own
+	if (bRendered)
+	{
+		m_pShaderManager->use();
+	}
+	bool bDirectionalShadow = m_pShadowManager->IsMapActive(ShadowManager::SHADOW_DIRECTIONAL);
+	bool bSpotShadow = m_pShadowManager->IsMapActive(ShadowManager::SHADOW_SPOT);
+	m_pShaderManager->setIntValue(m_uniforms.bDirectionalShadow, bDirectionalShadow);
+	m_pShaderManager->setIntValue(m_uniforms.bSpotShadow, bSpotShadow);
+	m_pShaderManager->setMat4Value(m_uniforms.directionalShadowMatrix,
+		m_pShadowManager->GetLightMatrix(ShadowManager::SHADOW_DIRECTIONAL));
+	m_pShaderManager->setMat4Value(m_uniforms.spotShadowMatrix,
+		m_pShadowManager->GetLightMatrix(ShadowManager::SHADOW_SPOT));
+}
+
+/***********************************************************
+ *  UpdateLightClusters()
+ *
+ *  This method is used for keeping the clustered point light
+ *  buffers up to date.  The active point lights are uploaded
+ *  when one of them changed; the lights are assigned to the
+ *  clusters again when they or the camera changed, so a
+ *  still camera in a still scene costs nothing per frame.
+ ***********************************************************/
+void SceneManager::UpdateLightClusters()
+{
+	if (NULL == m_pLightClusters)
+	{
+		return;
+	}
+
+	const std::vector<LightManager::POINT_LIGHT>& lights = m_lightManager->GetActivePointLights();
+	bool bLightsChanged = (m_pointLightBuffer == 0 || m_clusterLightVersion != m_lightManager->GetPointLightVersion());
+	if (bLightsChanged)
+	{
+		UploadStorageBuffer(m_pointLightBuffer, POINT_LIGHT_BLOCK_BINDING,
+			lights.data(), lights.size() * sizeof(LightManager::POINT_LIGHT));
+		m_clusterLightVersion = m_lightManager->GetPointLightVersion();
+	}
+	if (!bLightsChanged && !m_bClustersDirty)
+	{
+		return;
+	}
+
+	m_pLightClusters->AssignLights(lights);
+	const std::vector<LightClusters::CLUSTER>& clusters = m_pLightClusters->GetClusters();
+	const std::vector<GLuint>& lightIndices = m_pLightClusters->GetLightIndices();
+	UploadStorageBuffer(m_clusterBuffer, CLUSTER_BLOCK_BINDING,
+		clusters.data(), clusters.size() * sizeof(LightClusters::CLUSTER));
+	UploadStorageBuffer(m_clusterLightBuffer, CLUSTER_LIGHT_BLOCK_BINDING,
+		lightIndices.data(), lightIndices.size() * sizeof(GLuint));
+	m_bClustersDirty = false;
+}
+
+/***********************************************************
+ *  AddGeneratedLights()
+ *
+ *  This method is used for spreading the requested number of
+ *  extra point lights in an even grid just below the top of
+ *  the scene bounds, like the ceiling lights of an office.
+ *  Each light reaches far enough down to light the floor,
+ *  and the lights take the indices after those of the scene
+ *  file.
+ ***********************************************************/
+void SceneManager::AddGeneratedLights()
+{
+	if (m_generatedLightCount <= 0)
+	{
+		return;
+	}
+
+	glm::vec3 size = glm::max(m_sceneBoundsMax - m_sceneBoundsMin, glm::vec3(0.01f));
+	int columns = std::max(1, static_cast<int>(std::ceil(std::sqrt(m_generatedLightCount * size.x / size.z))));
+	int rows = (m_generatedLightCount + columns - 1) / columns;
+	glm::vec2 spacing(size.x / columns, size.z / rows);
+	float range = std::max(2.0f * std::max(spacing.x, spacing.y), 0.6f * size.y);
+	float height = m_sceneBoundsMax.y - 0.05f * size.y;
+
+	int firstIndex = m_lightManager->GetPointLightSlotCount();
+	int lightCount = std::min(m_generatedLightCount, LightManager::MAX_POINT_LIGHTS - firstIndex);
+	for (int i = 0; i < lightCount; ++i)
+	{
+		glm::vec3 position(
+			m_sceneBoundsMin.x + (i % columns + 0.5f) * spacing.x,
+			height,
+			m_sceneBoundsMin.z + (i / columns + 0.5f) * spacing.y);
+		m_lightManager->SetPointLight(firstIndex + i, position, glm::vec3(0.0f),
+			g_GeneratedLightDiffuse, g_GeneratedLightSpecular, range);
+	}
+	std::cout << "INFO: Added " << lightCount << " ceiling point lights in a " << columns << "x" << rows
+		<< " grid, range " << range << std::endl;
+}
+
+/***********************************************************
+ *  PrebuildShaderVariants()
+ *
+ *  This method is used for building every texture and
+ *  lighting permutation of the passes in use for the lights
+ *  of the loaded scene, so the first frame - and the first
+ *  draw of each feature combination - does not stall on a
+ *  shader compile.  The point lights must be packed by
+ *  UploadLights() first.  The generated ceiling lights are
+ *  only added during the first frame, so the light counts
+ *  with and without them are both built.
+ ***********************************************************/
+void SceneManager::PrebuildShaderVariants()
+{
+	if (NULL == m_pShaderManager)
+	{
+		return;
+	}
+
+	// transparent objects are always drawn forward, the deferred
+	// pipeline adds the G-buffer and light passes
+	std::vector<ShaderManager::SHADER_PASS> passes(1, ShaderManager::PASS_FORWARD);
+	if (NULL != m_pDeferredRenderer)
+	{
+		passes.push_back(ShaderManager::PASS_GBUFFER);
+		passes.push_back(ShaderManager::PASS_DEFERRED_LIGHTING);
+	}
+
+	// clustered point lights are looped over at runtime, whatever the count
+	std::vector<int> pointLightCounts(1, 0);
+	if (NULL == m_pLightClusters)
+	{
+		pointLightCounts[0] = m_lightManager->GetActivePointLightCount();
+		if (m_generatedLightCount > 0)
+		{
+			pointLightCounts.push_back(std::min(pointLightCounts[0] + m_generatedLightCount,
+				LightManager::TOTAL_POINT_LIGHTS));
+		}
+	}
+
+	auto startTime = std::chrono::steady_clock::now();
+	for (int pointLightCount : pointLightCounts)
+	{
+		m_pShaderManager->PrebuildVariants(
+			m_lightManager->IsDirectionalLightActive(),
+			pointLightCount,
+			m_lightManager->IsSpotLightActive(),
+			passes);
+	}
+	double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	std::cout << "INFO: Shader permutations of the scene prebuilt in " << elapsedMs << " ms" << std::endl;
+}
+
+/***********************************************************
+ *  UploadMaterials()
+ *
+ *  This method is used for writing the defined materials into
+ *  the material table of the fragment shader after the scene
+ *  file was loaded.  The whole table is one std430 storage
+ *  buffer that every draw reads by the material index of its
+ *  instance, so nothing is uploaded per frame or per draw.
+ *  Without storage buffers the table is a uniform array, set
+ *  through the shader manager.
+ ***********************************************************/
+void SceneManager::UploadMaterials()
+{
+	if (!m_bMaterialsDirty || NULL == m_pShaderManager)
+	{
+		return;
+	}
+	m_bMaterialsDirty = false;
+
+	if (m_pShaderManager->GetStorageBuffersSupported())
+	{
+		if (m_materialBuffer == 0)
+		{
+			glGenBuffers(1, &m_materialBuffer);
+		}
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_materialBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, m_objectMaterials.size() * sizeof(OBJECT_MATERIAL),
+			m_objectMaterials.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MATERIAL_BLOCK_BINDING, m_materialBuffer);
+		std::cout << "INFO: " << m_objectMaterials.size() << " materials in a "
+			<< m_objectMaterials.size() * sizeof(OBJECT_MATERIAL) << " byte storage buffer" << std::endl;
+		return;
+	}
+
+	for (size_t i = 0; i < m_objectMaterials.size(); ++i)
+	{
+		const OBJECT_MATERIAL& material = m_objectMaterials[i];
+		m_pShaderManager->setVec3Value(m_uniforms.materialDiffuseColors[i], material.diffuseColor);
+		m_pShaderManager->setVec3Value(m_uniforms.materialSpecularColors[i], material.specularColor);
+		m_pShaderManager->setFloatValue(m_uniforms.materialShininess[i], material.shininess);
+	}
+}
+
+/***********************************************************
+ *  BuildDrawBatches()
+ *
+ *  This method is used for splitting the sorted queue into
+ *  runs of objects that share the shader features, texture
+ *  and culling state.  Each run becomes one batch with one
+ *  indirect draw command per mesh it contains; all meshes
+ *  live in one vertex buffer, so the batch needs no state
+ *  change between its commands.  Batches never cross from
+ *  one pass into the next, so each pass is drawn apart.
+ ***********************************************************/
+void SceneManager::BuildDrawBatches()
+{
+	const SCENE_OBJECTS& objects = m_sceneObjects;
+	const std::vector<RenderQueue::RENDER_ITEM>& items = m_renderQueue.GetItems();
+	size_t opaqueBegin = m_renderQueue.FindPassBegin(RenderQueue::PASS_OPAQUE);
+	size_t transparentBegin = m_renderQueue.FindPassBegin(RenderQueue::PASS_TRANSPARENT);
+
+	// objects drawn without changing any state in between
+	auto bSameState = [&objects](size_t a, size_t b)
+	{
+		return objects.textured[a] == objects.textured[b] &&
+			objects.textureArrays[a] == objects.textureArrays[b] &&
+			objects.lit[a] == objects.lit[b] &&
+			objects.culled[a] == objects.culled[b] &&
+			objects.cullFaces[a] == objects.cullFaces[b];
+	};
+
+	m_drawBatches.clear();
+	m_drawCommands.clear();
+	size_t first = 0;
+	while (first < items.size())
+	{
+		size_t i = items[first].objectIndex;
+		size_t batchEnd = items.size();
+		if (first < opaqueBegin)
+		{
+			batchEnd = opaqueBegin;
+		}
+		else if (first < transparentBegin)
+		{
+			batchEnd = transparentBegin;
+		}
+
+		DRAW_BATCH batch;
+		batch.firstItem = first;
+		batch.firstCommand = m_drawCommands.size();
+
+		size_t last = first;
+		while (last < batchEnd && bSameState(items[last].objectIndex, i))
+		{
+			// one command per run of the same mesh
+			ShapeMeshes::MeshType mesh = objects.meshes[items[last].objectIndex];
+			size_t meshEnd = last + 1;
+			while (meshEnd < batchEnd &&
+				objects.meshes[items[meshEnd].objectIndex] == mesh &&
+				bSameState(items[meshEnd].objectIndex, i))
+			{
+				++meshEnd;
+			}
+			m_drawCommands.push_back(m_basicMeshes->GetDrawCommand(
+				mesh, static_cast<int>(last), static_cast<int>(meshEnd - last)));
+			last = meshEnd;
+		}
+
+		batch.endItem = last;
+		batch.commandCount = m_drawCommands.size() - batch.firstCommand;
+		m_drawBatches.push_back(batch);
+		first = last;
+	}
+}
+
+/***********************************************************
+ *  DrawQueuedObjects()
+ *
+ *  This method is used for drawing the batches of a range of
+ *  the sorted render queue.  Each batch sets its shader
+ *  features, texture and culling state once and draws all
+ *  of its meshes with a single multi-draw indirect call.
+ ***********************************************************/
+void SceneManager::DrawQueuedObjects(size_t begin, size_t end)
+{
+	const SCENE_OBJECTS& objects = m_sceneObjects;
+	const std::vector<RenderQueue::RENDER_ITEM>& items = m_renderQueue.GetItems();
+
+	for (const DRAW_BATCH& batch : m_drawBatches)
+	{
+		if (batch.firstItem < begin || batch.firstItem >= end)
+		{
+			continue;
+		}
+
+		size_t i = items[batch.firstItem].objectIndex;
+		m_pShaderManager->SetFeature(ShaderManager::FEATURE_LIGHTING, objects.lit[i] != 0);
+		m_pShaderManager->SetFeature(ShaderManager::FEATURE_TEXTURE, objects.textured[i] != 0);
+		m_pShaderManager->setSampler2DValue(m_uniforms.objectTexture, objects.textureArrays[i]);
+		m_pStateCache->SetEnabled(GL_CULL_FACE, objects.culled[i] != 0);
+		m_pStateCache->CullFace(objects.cullFaces[i]);
+
+		m_basicMeshes->DrawMeshesIndirect(batch.firstCommand, batch.commandCount);
+		m_drawCalls++;
+		m_drawCommandCount += static_cast<unsigned int>(batch.commandCount);
+		m_drawnInstances += static_cast<unsigned int>(batch.endItem - batch.firstItem);
+	}
+}
+
+/***********************************************************
+ *  ReportFrameStats()
+ *
+ *  This method is used for printing the per-frame averages
+ *  of the scene statistics collected since the last report.
+ ***********************************************************/
+void SceneManager::ReportFrameStats(int frameCount)
+{
+	if (frameCount <= 0)
+	{
+		return;
+	}
+
+	const LightManager::LIGHT_STATS& lightStats = m_lightManager->GetStats();
+	std::cout << "STATS: light block uploads: " << lightStats.uploads
+		<< " (" << lightStats.uploadedBytes << " bytes)" << std::endl;
+	m_lightManager->ResetStats();
+
+	if (m_queueSortCount > 0)
+	{
+		std::cout << "STATS: render queue: " << m_renderQueue.GetItems().size() << " items, sort "
+			<< (m_queueSortMs / m_queueSortCount) << " ms/frame" << std::endl;
+		std::cout << "STATS: multi-draw calls/frame: " << (m_drawCalls / m_queueSortCount)
+			<< " with " << (m_drawCommandCount / m_queueSortCount) << " draw commands"
+			<< " for " << (m_drawnInstances / m_queueSortCount) << " objects"
+			<< ", instance buffer uploads: " << m_instanceUploads << std::endl;
+	}
+	m_queueSortMs = 0.0;
+	m_queueSortCount = 0;
+	m_drawCalls = 0;
+	m_drawCommandCount = 0;
+	m_drawnInstances = 0;
+	m_instanceUploads = 0;
+
+	bool bBvhCulling = m_sceneObjects.names.size() >= BVH_CULL_MIN_OBJECTS;
+	std::cout << "STATS: frustum culling (" << (bBvhCulling ? "BVH" : FrustumCuller::GetInstructionSet())
+		<< ") objects/frame: visible " << m_visibleCount / frameCount << ", culled " << m_culledCount / frameCount << std::endl;
+	m_visibleCount = 0;
+	m_culledCount = 0;
+
+	if (m_wallPassTimer.GetSampleCount() > 0)
+	{
+		bool bPermutations = (NULL != m_pShaderManager) && m_pShaderManager->GetPermutationsEnabled();
+		std::cout << "STATS: room planes GPU time/frame: " << m_wallPassTimer.GetAverageMs() << " ms"
+			<< " (shader permutations " << (bPermutations ? "on" : "off") << ")" << std::endl;
+	}
+
+	if (m_opaquePassTimer.GetSampleCount() > 0)
+	{
+		std::cout << "STATS: opaque objects GPU time/frame (" << (GetDeferredShading() ? "deferred" : "forward")
+			<< " pipeline): " << GetOpaquePassMs() << " ms";
+		if (NULL != m_pDeferredRenderer)
+		{
+			std::cout << " into the G-buffer + " << GetLightPassMs() << " ms light pass, G-buffer "
+				<< m_pDeferredRenderer->GetMemoryBytes() / (1024.0 * 1024.0) << " MB";
+		}
+		std::cout << std::endl;
+	}
+	ResetPipelineStats();
+
+	if (NULL != m_pTextureLoader)
+	{
+		const TextureLoader::STREAM_STATS& streamStats = m_pTextureLoader->GetStats();
+		if (streamStats.uploadedBytes > 0)
+		{
+			std::cout << "STATS: texture streaming: " << streamStats.uploadedBytes / 1024.0 / frameCount
+				<< " KB/frame, " << streamStats.uploadedLevels << " mip levels completed, "
+				<< m_pTextureLoader->GetStreamingCount() << " of " << m_pTextureLoader->GetLayerCount()
+				<< " layers still streaming" << std::endl;
+		}
+		m_pTextureLoader->ResetStats();
+	}
+
+	if (!m_textureArrays.empty())
+	{
+		std::cout << "STATS: texture memory: " << m_textureResidency.GetMemoryBytes() / (1024.0 * 1024.0)
+			<< " MB of " << m_textureResidency.GetFullMemoryBytes() / (1024.0 * 1024.0)
+			<< " MB, peak " << m_textureResidency.GetPeakMemoryBytes() / (1024.0 * 1024.0) << " MB"
+			<< ", mip levels dropped " << m_textureResidency.GetDroppedLevels()
+			<< ", restored " << m_textureResidency.GetRestoredLevels() << std::endl;
+		m_textureResidency.ResetStats();
+	}
+
+	if (NULL != m_pLightClusters)
+	{
+		const LightClusters::CLUSTER_STATS& clusterStats = m_pLightClusters->GetStats();
+		std::cout << "STATS: light clusters: " << m_lightManager->GetActivePointLights().size() << " point lights";
+		if (clusterStats.assignments > 0)
+		{
+			std::cout << ", assigned " << clusterStats.assignments << " times in "
+				<< clusterStats.assignMs / clusterStats.assignments << " ms on "
+				<< std::max(m_pLightClusters->GetThreadCount(), 1) << " threads, "
+				<< static_cast<double>(clusterStats.listedLights) / clusterStats.assignments / LightClusters::CLUSTER_COUNT
+				<< " lights/cluster, max " << clusterStats.maxClusterLights
+				<< ", dropped " << clusterStats.droppedLights;
+		}
+		else
+		{
+			std::cout << ", assignment unchanged";
+		}
+		std::cout << std::endl;
+		m_pLightClusters->ResetStats();
+	}
+
+	if (NULL != m_pShadowManager)
+	{
+		const char* mapNames[ShadowManager::SHADOW_MAP_COUNT] = { "directional", "spot" };
+		std::cout << "STATS: shadow maps:";
+		for (int i = 0; i < ShadowManager::SHADOW_MAP_COUNT; ++i)
+		{
+			ShadowManager::SHADOW_MAP map = static_cast<ShadowManager::SHADOW_MAP>(i);
+			const ShadowManager::SHADOW_STATS& shadowStats = m_pShadowManager->GetStats(map);
+			std::cout << (i > 0 ? "," : "") << " " << mapNames[i];
+			if (!m_pShadowManager->IsMapActive(map))
+			{
+				std::cout << " off";
+				continue;
+			}
+			std::cout << " " << shadowStats.staticRenders << " static and "
+				<< shadowStats.movingRenders << " moving renders";
+			if (m_pShadowManager->GetSampleCount(map) > 0)
+			{
+				std::cout << " (" << m_pShadowManager->GetAverageMs(map) << " ms GPU each)";
+			}
+			std::cout << ", cached " << shadowStats.cachedFrames << " of " << frameCount << " frames";
+		}
+		std::cout << std::endl;
+		m_pShadowManager->ResetStats();
+	}
+}
+
+/***********************************************************
+ *  GetOpaquePassMs()
+ *
+ *  This method is used for getting the average GPU time of
+ *  drawing the opaque objects, the room planes included.
+ ***********************************************************/
+double SceneManager::GetOpaquePassMs() const
+{
+	return m_wallPassTimer.GetAverageMs() + m_opaquePassTimer.GetAverageMs();
+}
+
+/***********************************************************
+ *  GetLightPassMs()
+ *
+ *  This method is used for getting the average GPU time of
+ *  the deferred light pass, 0 in the forward pipeline.
+ ***********************************************************/
+double SceneManager::GetLightPassMs() const
+{
+	return (NULL != m_pDeferredRenderer) ? m_pDeferredRenderer->GetLightPassMs() : 0.0;
+}
+
+/***********************************************************
+ *  ResetPipelineStats()
+ *
+ *  This method is used for forgetting the GPU times of the
+ *  room planes, the other opaque objects and the light pass.
+ ***********************************************************/
+void SceneManager::ResetPipelineStats()
+{
+	m_wallPassTimer.Reset();
+	m_opaquePassTimer.Reset();
+	if (NULL != m_pDeferredRenderer)
+	{
+		m_pDeferredRenderer->ResetStats();
+	}
 }
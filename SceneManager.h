@@ -11,10 +11,41 @@
 
 #include "ShaderManager.h"
 #include "ShapeMeshes.h"
+#include "LightManager.h"
+#include "GpuTimer.h"
+#include "RenderQueue.h"
+#include "SceneGraph.h"
+#include "FrustumCuller.h"
+#include "BoundingVolumeHierarchy.h"
+#include "TextureLoader.h"
+#include "TextureResidency.h"
+#include "NameTable.h"
+#include "ShadowManager.h"
+#include "LightClusters.h"
+#include "DeferredRenderer.h"
 
+#include <chrono>
+#include <sstream>
 #include <string>
 #include <vector>
 
+// Handles of the textures and materials of the loaded scene. Tags are
+// resolved to handles once while the scene file is loaded; rendering only
+// ever indexes the texture and material tables with them.
+struct TextureHandle
+{
+	int index = -1;
+
+	bool IsValid() const { return index >= 0; }
+};
+
+struct MaterialHandle
+{
+	int index = -1;
+
+	bool IsValid() const { return index >= 0; }
+};
+
 /***********************************************************
  *  SceneManager
  *
@@ -29,18 +60,81 @@ public:
 	// destructor
 	~SceneManager();
 
+	// a loaded texture is one layer of a texture array
 	struct TEXTURE_INFO
 	{
 		std::string tag;
-		uint32_t ID;
+		std::string filename;
+		GLint wrapMode;
+		int width;
+		int height;
+		int colorChannels;
+		// -1 until the texture arrays are created
+		int arrayIndex;
+		int layer;
+		// layer index in the texture loader
+		int stream;
+	};
+
+	// textures of the same size, format and wrap mode share one
+	// GL_TEXTURE_2D_ARRAY, bound to the texture unit of its index
+	struct TEXTURE_ARRAY
+	{
+		GLuint ID;
+		int width;
+		int height;
+		int colorChannels;
+		GLint wrapMode;
+		int layers;
+		// BC1/BC3 format, GL_NONE for an uncompressed RGB8/RGBA8 array
+		GLenum compressedFormat;
+		// mip level of the images held as level 0, above 0 once the
+		// residency manager dropped the top levels
+		int baseLevel;
 	};
 
+	// laid out as the std430 Material struct of the fragment shader, so
+	// the material table is copied into the storage buffer as it is -
+	// the tags only live in the material name table
 	struct OBJECT_MATERIAL
 	{
 		glm::vec3 diffuseColor;
+		float padding;
 		glm::vec3 specularColor;
 		float shininess;
-		std::string tag;
+	};
+
+	// objects loaded from the scene file, kept in parallel arrays
+	// indexed by object so rendering walks them in order without
+	// any lookups by name
+	struct SCENE_OBJECTS
+	{
+		std::vector<std::string> names;
+		// scene graph node holding the transform of each object
+		std::vector<uint32_t> nodes;
+		std::vector<ShapeMeshes::MeshType> meshes;
+		std::vector<unsigned char> textured;
+		// texture, and the array and layer holding the texture
+		std::vector<TextureHandle> textures;
+		std::vector<int> textureArrays;
+		std::vector<int> textureLayers;
+		std::vector<glm::vec4> colors;
+		std::vector<glm::vec2> uvScales;
+		std::vector<MaterialHandle> materials;
+		std::vector<unsigned char> lit;
+		std::vector<unsigned char> culled;
+		std::vector<GLenum> cullFaces;
+		// color alpha below 1, drawn back to front after the opaque objects
+		std::vector<unsigned char> transparent;
+	};
+
+	// nearest object surface hit by a pick ray
+	struct PICK_RESULT
+	{
+		int objectIndex = -1;
+		std::string name;
+		glm::vec3 point = glm::vec3(0.0f);
+		float distance = 0.0f;
 	};
 
 private:
@@ -48,53 +142,249 @@ private:
 	ShaderManager* m_pShaderManager;
 	// pointer to basic shapes object
 	ShapeMeshes* m_basicMeshes;
-	// total number of loaded textures
-	int m_loadedTextures;
-	// loaded textures info
-	TEXTURE_INFO m_textureIDs[16];
-	// defined object materials
+	// OpenGL state cache shared with the shader manager
+	GLStateCache* m_pStateCache;
+	// state cache used when there is no shader manager
+	GLStateCache m_localStateCache;
+	// pointer to the scene light sources object
+	LightManager* m_lightManager;
+	// loaded textures info, indexed by texture handle
+	std::vector<TEXTURE_INFO> m_textureIDs;
+	// texture handles by tag and by image file name
+	NameTable m_textureTags;
+	NameTable m_textureFiles;
+	// texture arrays holding the loaded textures
+	std::vector<TEXTURE_ARRAY> m_textureArrays;
+	// worker threads decoding the texture images, 0 decodes them in turn
+	int m_textureThreads;
+	// load textures from the compressed texture cache when supported
+	bool m_bCompressedTextures;
+	// defined object materials, indexed by material handle
 	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	// material handles by tag
+	NameTable m_materialTags;
+	// storage buffer holding the material table, rewritten only when
+	// the scene file changes the materials
+	GLuint m_materialBuffer;
+	bool m_bMaterialsDirty;
+	// objects of the loaded scene
+	SCENE_OBJECTS m_sceneObjects;
+	// transforms of the scene objects and the groups they belong to
+	SceneGraph m_sceneGraph;
+	// range of scene objects measured by the GPU timer
+	size_t m_timedObjectsBegin;
+	size_t m_timedObjectsEnd;
+
+	// streams the texture images into their texture array layers
+	TextureLoader* m_pTextureLoader;
+	// bytes of texture data uploaded per frame, 0 loads all textures up front
+	size_t m_textureUploadBudget;
+	// when the textures started streaming in, reported once all are loaded
+	std::chrono::steady_clock::time_point m_textureStreamStart;
+	bool m_bTexturesStreaming;
+	// textures used by the objects in view this frame
+	std::vector<unsigned char> m_textureVisible;
+	// mip levels of the texture arrays kept in video memory
+	TextureResidency m_textureResidency;
+	bool m_bTextureResidency;
+	std::vector<int> m_resizedArrays;
+	// pixels across the viewport per unit of projected size, used to
+	// estimate the size of the objects on screen
+	float m_screenScale;
+	bool m_bOrthographic;
+
+	// must match MAX_MATERIALS in the fragment shader - the storage
+	// buffer holds any number of materials, the uniform array only these
+	static const int MAX_MATERIALS = 16;
+	// storage buffer binding point of the MaterialBlock
+	static const GLuint MATERIAL_BLOCK_BINDING = 0;
+	// storage buffer binding points of the clustered point lights
+	static const GLuint POINT_LIGHT_BLOCK_BINDING = 1;
+	static const GLuint CLUSTER_BLOCK_BINDING = 2;
+	static const GLuint CLUSTER_LIGHT_BLOCK_BINDING = 3;
 
-	// load texture images and convert to OpenGL texture data
-	bool CreateGLTexture(const char* filename, std::string tag);
-	// bind loaded OpenGL textures to slots in memory
+	// shader uniforms used while rendering, resolved once up front
+	// so that no uniform name strings are handled per frame
+	struct SHADER_UNIFORMS
+	{
+		UniformHandle objectTexture;
+		UniformHandle materialDiffuseColors[MAX_MATERIALS];
+		UniformHandle materialSpecularColors[MAX_MATERIALS];
+		UniformHandle materialShininess[MAX_MATERIALS];
+		UniformHandle directionalShadowMap;
+		UniformHandle directionalShadowMatrix;
+		UniformHandle bDirectionalShadow;
+		UniformHandle spotShadowMap;
+		UniformHandle spotShadowMatrix;
+		UniformHandle bSpotShadow;
+		UniformHandle clusterTileScale;
+		UniformHandle clusterViewDirection;
+		UniformHandle clusterDepthSlice;
+	};
+	SHADER_UNIFORMS m_uniforms;
+
+	// GPU time of the timed range of scene objects (the room planes), and
+	// of the other opaque objects
+	GpuTimer m_wallPassTimer;
+	GpuTimer m_opaquePassTimer;
+
+	// G-buffer and light pass of the deferred pipeline, NULL while the
+	// opaque objects are shaded forward
+	DeferredRenderer* m_pDeferredRenderer;
+	// world position of a pixel from its window depth, for the light pass
+	glm::mat4 m_inverseViewProjection;
+
+	// shadow maps of the directional and spot lights
+	ShadowManager* m_pShadowManager;
+	// objects that moved since the scene was loaded - they are drawn
+	// into the shadow maps apart from the cached static casters
+	std::vector<unsigned char> m_movingObjects;
+	// bounds of all the objects, covered by the directional shadow map
+	glm::vec3 m_sceneBoundsMin;
+	glm::vec3 m_sceneBoundsMax;
+	// draw commands of the static and the moving shadow casters, after
+	// the commands of the render queue
+	size_t m_staticCasterCommand;
+	size_t m_staticCasterCommandCount;
+	size_t m_movingCasterCommand;
+	size_t m_movingCasterCommandCount;
+	std::vector<uint32_t> m_casterOrder;
+
+	// point lights culled into clusters of the view frustum, when the
+	// driver has storage buffers - else the light block lights are used
+	LightClusters* m_pLightClusters;
+	// threads assigning the lights to the clusters, 0 assigns them in turn
+	int m_lightThreads;
+	// point lights spread over the ceiling of every loaded scene
+	int m_generatedLightCount;
+	// storage buffers of the active point lights, of the cluster light
+	// lists and of the light indices the lists point into
+	GLuint m_pointLightBuffer;
+	GLuint m_clusterBuffer;
+	GLuint m_clusterLightBuffer;
+	// point light version of the light buffer, and whether the camera
+	// moved since the lights were last assigned
+	unsigned int m_clusterLightVersion;
+	bool m_bClustersDirty;
+
+	// draw order of the scene objects, rebuilt every frame
+	RenderQueue m_renderQueue;
+	// camera position used for the depth part of the sort keys
+	glm::vec3 m_cameraPosition;
+	// world-space bounds of the objects tested against the camera frustum
+	FrustumCuller m_frustumCuller;
+	// the same world-space boxes in a hierarchy, built on load and refit
+	// when objects move - used for culling once a scene has enough objects
+	// for the tree to beat the linear test, and for ray queries
+	BoundingVolumeHierarchy m_bvh;
+	static const size_t BVH_CULL_MIN_OBJECTS = 256;
+	std::vector<glm::vec3> m_worldBoundsMins;
+	std::vector<glm::vec3> m_worldBoundsMaxs;
+	std::vector<uint32_t> m_bvhVisibleObjects;
+	// objects whose boxes the last pick ray entered, nearest first
+	std::vector<BoundingVolumeHierarchy::RAY_HIT> m_pickHits;
+	// scene graph version the culler bounds were computed for
+	uint32_t m_boundsVersion;
+	bool m_bBoundsValid;
+	// objects inside the frustum this frame
+	std::vector<unsigned char> m_visibleObjects;
+	// visible and culled objects since the last report
+	unsigned int m_visibleCount;
+	unsigned int m_culledCount;
+	// render queue sort time accumulated until the next report
+	double m_queueSortMs;
+	int m_queueSortCount;
+	// per-instance values of the queued objects, in queue order
+	std::vector<ShapeMeshes::INSTANCE_DATA> m_instances;
+	// queue order and transform version of the uploaded instances,
+	// the upload is skipped while neither changes
+	std::vector<uint32_t> m_instanceOrder;
+	uint32_t m_instanceTransformVersion;
+	bool m_bInstancesValid;
+	unsigned int m_instanceUploads;
+	// run of queue items sharing shader features, texture and culling
+	// state, drawn with one multi-draw call - one command per mesh
+	struct DRAW_BATCH
+	{
+		size_t firstItem;
+		size_t endItem;
+		size_t firstCommand;
+		size_t commandCount;
+	};
+	std::vector<DRAW_BATCH> m_drawBatches;
+	std::vector<ShapeMeshes::DRAW_COMMAND> m_drawCommands;
+	// multi-draw calls, draw commands and drawn objects since the last report
+	unsigned int m_drawCalls;
+	unsigned int m_drawCommandCount;
+	unsigned int m_drawnInstances;
+
+	// resolve the shader uniform handles used while rendering
+	void ResolveShaderUniforms();
+	// load the textures, materials, lights and objects of a scene file
+	bool LoadSceneFile(const std::string& filename);
+	// add one object line of the scene file to the scene objects,
+	// placed relative to a scene graph node
+	bool ParseSceneObject(std::istringstream& line, uint32_t parentNode);
+	// refresh the world bounds of moved objects and cull them
+	void CullSceneObjects();
+	// fill the render queue with the visible objects and sort it
+	void BuildRenderQueue();
+	// upload the instance values and draw commands of the sorted queue items
+	void UploadInstances();
+	// write the per-instance values of a scene object
+	void WriteInstance(size_t objectIndex, ShapeMeshes::INSTANCE_DATA& instance) const;
+	// append the instances and draw commands of the shadow casters,
+	// one command per mesh for the static and for the moving ones
+	void AppendShadowCasters();
+	// render the shadow maps that are out of date and set them into
+	// the shader
+	void RenderShadowMaps();
+	// assign the point lights to the clusters after the lights or the
+	// camera changed, and upload the light lists
+	void UpdateLightClusters();
+	// add the generated point lights in a grid below the top of the scene
+	void AddGeneratedLights();
+	// build the shader permutations of the loaded lights and the passes
+	// of the current pipeline before the first frame draws with them
+	void PrebuildShaderVariants();
+	// group the sorted queue items into draw batches and commands
+	void BuildDrawBatches();
+	// write the material table into the storage buffer, or into the
+	// uniform array of the fragment shader without storage buffers
+	void UploadMaterials();
+	// draw a range of the sorted render queue items, one multi-draw
+	// call per run of items that share texture and state
+	void DrawQueuedObjects(size_t begin, size_t end);
+
+	// register a texture image, loaded by the next CreateTextureArrays()
+	bool CreateGLTexture(const char* filename, const std::string& tag, GLint wrapMode = GL_REPEAT);
+	// load the registered images into texture arrays
+	void CreateTextureArrays();
+	// create the OpenGL texture of an array with the levels from its
+	// base level down, bound to the texture unit
+	void AllocateTextureArray(TEXTURE_ARRAY& textureArray, GLuint textureUnit);
+	// reallocate an array to hold the levels from baseLevel down,
+	// copying the levels it keeps
+	void ResizeTextureArray(int arrayIndex, int baseLevel);
+	// drop or restore the top mip levels of the arrays to match the
+	// size of the objects on screen and the memory budget
+	void UpdateTextureResidency();
+	// bind the texture arrays to their texture units
 	void BindGLTextures();
 	// free the loaded OpenGL textures
 	void DestroyGLTextures();
-	// find a loaded texture by tag
-	int FindTextureID(std::string tag);
-	int FindTextureSlot(std::string tag);
+	// upload texture mip levels within the budget of the frame
+	void UpdateTextureStreaming();
+	// print the time it took to stream all textures in
+	void ReportTextureStreaming();
+	// find a loaded texture by tag - the ID is that of its texture array
+	int FindTextureID(const std::string& tag) const;
+	TextureHandle FindTexture(const std::string& tag) const;
 	// find a defined material by tag
-	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
-
-	// set the transformation values 
-	// into the transform buffer
-	void SetTransformations(
-		glm::vec3 scaleXYZ,
-		float XrotationDegrees,
-		float YrotationDegrees,
-		float ZrotationDegrees,
-		glm::vec3 positionXYZ,
-		glm::vec3 offset = glm::vec3(0.0f, 0.0f, 0.0f));
-
-	// set the color values into the shader
-	void SetShaderColor(
-		float redColorValue,
-		float greenColorValue,
-		float blueColorValue,
-		float alphaValue);
+	MaterialHandle FindMaterial(const std::string& tag) const;
 
 	// set the texture data into the shader
-	void SetShaderTexture(
-		std::string textureTag);
-
-	// set the UV scale for the texture mapping
-	void SetTextureUVScale(
-		float u, float v);
-
-	// set the object material into the shader
-	void SetShaderMaterial(
-		std::string materialTag);
+	void SetShaderTexture(TextureHandle texture);
 
 public:
 
@@ -103,4 +393,52 @@ public:
 	void PrepareScene();
 	void RenderScene();
 
+	// number of threads decoding texture images, set before PrepareScene()
+	void SetTextureThreads(int threadCount) { m_textureThreads = threadCount; }
+	// load BC1/BC3 textures from the texture cache, set before PrepareScene()
+	void SetCompressedTextures(bool bEnabled) { m_bCompressedTextures = bEnabled; }
+	// texture bytes streamed in per frame, 0 loads every texture before
+	// the first frame - set before PrepareScene()
+	void SetTextureUploadBudget(size_t budgetBytes) { m_textureUploadBudget = budgetBytes; }
+	static const size_t DEFAULT_TEXTURE_UPLOAD_BUDGET = 8 * 1024 * 1024;
+	// video memory the texture arrays are kept under by dropping
+	// their top mip levels, 0 only drops the levels not needed
+	void SetTextureMemoryBudget(size_t budgetBytes) { m_textureResidency.SetBudget(budgetBytes); }
+	// number of threads assigning the point lights to the clusters,
+	// set before PrepareScene()
+	void SetLightThreads(int threadCount) { m_lightThreads = threadCount; }
+	// point lights added in a grid over the ceiling of the scene, on
+	// top of those of the scene file - set before PrepareScene(), or
+	// before ReloadScene()
+	void SetGeneratedLights(int lightCount) { m_generatedLightCount = lightCount; }
+	// shade the opaque objects in a deferred light pass over a G-buffer
+	// instead of while they are drawn - false when it is not supported
+	bool SetDeferredShading(bool bEnabled);
+	bool GetDeferredShading() const { return NULL != m_pDeferredRenderer; }
+	// active point lights of the scene
+	size_t GetPointLightCount() const { return m_lightManager->GetActivePointLights().size(); }
+
+	// reload the texture loaded from the given image file, if any
+	bool ReloadTexture(const std::string& filename);
+	// reload the scene file after it was edited
+	bool ReloadScene();
+	// rebuild the shadow map shader after its source was edited
+	void ReloadShadowShaders();
+
+	// camera of the frame, set before RenderScene()
+	void SetCamera(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPosition);
+
+	// find the nearest object surface along a world-space ray
+	bool PickObject(const glm::vec3& origin, const glm::vec3& direction, PICK_RESULT& result);
+
+	// print the per-frame averages of the scene statistics
+	// collected since the last report and start over
+	void ReportFrameStats(int frameCount);
+	// average GPU time per frame of drawing the opaque objects - into
+	// the G-buffer in the deferred pipeline - and of the light pass,
+	// in milliseconds since the last reset
+	double GetOpaquePassMs() const;
+	double GetLightPassMs() const;
+	void ResetPipelineStats();
+
 };
\ No newline at end of file
@@ -1,11 +1,68 @@
 #include "ShaderManager.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
 namespace
 {
+	// header written in front of every cached program binary
+	struct PROGRAM_BINARY_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t binaryFormat;
+		uint32_t binaryLength;
+		uint64_t sourceHash;
+	};
+
+	const uint32_t PROGRAM_BINARY_MAGIC = 0x43505347; // "GSPC"
+	const uint32_t PROGRAM_BINARY_VERSION = 2;
+	// program binaries are kept out of the watched shader directory
+	const char* const CACHE_PARENT_DIRECTORY = "cache";
+	const char* const CACHE_DIRECTORY = "cache/shaders/";
+
+	// variant key layout: feature bits, then the light counts of lit variants
+	const uint32_t VARIANT_DIRECTIONAL_LIGHT = 1u << 8;
+	const uint32_t VARIANT_SPOT_LIGHT = 1u << 9;
+	const int VARIANT_POINT_LIGHT_SHIFT = 10;
+	const uint32_t VARIANT_POINT_LIGHT_MASK = 0xfu;
+	// the pass, 0 for the forward pass so its keys are unchanged
+	const int VARIANT_PASS_SHIFT = 14;
+	const uint32_t VARIANT_PASS_MASK = 0x3u;
+	// the single program that branches on the feature uniforms at runtime
+	const uint32_t VARIANT_BRANCHING = 1u << 31;
+
+	// light sources of the lit permutations as variant key bits
+	uint32_t GetLightKey(bool bDirectionalLight, int pointLightCount, bool bSpotLight)
+	{
+		uint32_t pointLights = static_cast<uint32_t>(pointLightCount < 0 ? 0 : pointLightCount);
+		if (pointLights > VARIANT_POINT_LIGHT_MASK)
+		{
+			pointLights = VARIANT_POINT_LIGHT_MASK;
+		}
+
+		uint32_t lightKey = (pointLights << VARIANT_POINT_LIGHT_SHIFT);
+		if (bDirectionalLight)
+		{
+			lightKey |= VARIANT_DIRECTIONAL_LIGHT;
+		}
+		if (bSpotLight)
+		{
+			lightKey |= VARIANT_SPOT_LIGHT;
+		}
+		return lightKey;
+	}
+
 	std::string ReadTextFile(const std::string& filePath)
 	{
 		std::ifstream fileStream(filePath, std::ios::in);
@@ -20,6 +77,77 @@ namespace
 		return buffer.str();
 	}
 
+	// 64-bit FNV-1a, chained over several inputs
+	uint64_t HashString(uint64_t hash, const std::string& data)
+	{
+		for (unsigned char c : data)
+		{
+			hash ^= c;
+			hash *= 1099511628211ull;
+		}
+		// separate consecutive inputs so "ab"+"c" differs from "a"+"bc"
+		hash ^= 0xff;
+		hash *= 1099511628211ull;
+		return hash;
+	}
+
+	std::string GetGLString(GLenum name)
+	{
+		const GLubyte* value = glGetString(name);
+		return value ? reinterpret_cast<const char*>(value) : std::string();
+	}
+
+	// place the permutation defines right after the #version line,
+	// which has to stay the first statement of the shader
+	std::string InjectDefines(const std::string& source, const std::string& defines)
+	{
+		if (defines.empty())
+		{
+			return source;
+		}
+
+		size_t insertAt = 0;
+		size_t versionPos = source.find("#version");
+		if (versionPos != std::string::npos)
+		{
+			size_t lineEnd = source.find('\n', versionPos);
+			insertAt = (lineEnd == std::string::npos) ? source.size() : lineEnd + 1;
+		}
+
+		std::string result = source.substr(0, insertAt);
+		if (!result.empty() && result.back() != '\n')
+		{
+			result += '\n';
+		}
+		result += defines;
+		result += source.substr(insertAt);
+		return result;
+	}
+
+	// create a directory, an existing one is not an error
+	void MakeDirectory(const std::string& directoryPath)
+	{
+#ifdef _WIN32
+		_mkdir(directoryPath.c_str());
+#else
+		mkdir(directoryPath.c_str(), 0755);
+#endif
+	}
+
+	// set the binding point of a block, adding the block when it is new
+	void SetBlockBinding(std::vector<std::pair<std::string, GLuint>>& bindings, const std::string& blockName, GLuint bindingPoint)
+	{
+		for (auto& binding : bindings)
+		{
+			if (binding.first == blockName)
+			{
+				binding.second = bindingPoint;
+				return;
+			}
+		}
+		bindings.push_back(std::make_pair(blockName, bindingPoint));
+	}
+
 	GLuint CompileShader(GLenum shaderType, const std::string& source, const std::string& label)
 	{
 		if (source.empty())
@@ -45,131 +173,843 @@ namespace
 
 		return shaderId;
 	}
+
+	GLuint LinkProgram(const std::string& vertexSource, const std::string& fragmentSource, bool bRetrievable)
+	{
+		GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, vertexSource, "vertex");
+		GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentSource, "fragment");
+		if (vertexShader == 0 || fragmentShader == 0)
+		{
+			glDeleteShader(vertexShader);
+			glDeleteShader(fragmentShader);
+			return 0;
+		}
+
+		GLuint programId = glCreateProgram();
+		if (bRetrievable)
+		{
+			glProgramParameteri(programId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		}
+		glAttachShader(programId, vertexShader);
+		glAttachShader(programId, fragmentShader);
+		glLinkProgram(programId);
+
+		GLint success = 0;
+		glGetProgramiv(programId, GL_LINK_STATUS, &success);
+		if (success == GL_FALSE)
+		{
+			GLchar infoLog[1024];
+			glGetProgramInfoLog(programId, sizeof(infoLog), nullptr, infoLog);
+			std::cerr << "ERROR: Shader program link failed\n" << infoLog << std::endl;
+			glDeleteProgram(programId);
+			programId = 0;
+		}
+
+		glDeleteShader(vertexShader);
+		glDeleteShader(fragmentShader);
+
+		return programId;
+	}
+
+	// returns 0 when there is no usable binary - the caller then compiles from source
+	GLuint LoadProgramBinary(const std::string& cachePath, uint64_t sourceHash)
+	{
+		std::ifstream fileStream(cachePath, std::ios::in | std::ios::binary);
+		if (!fileStream.is_open())
+		{
+			return 0;
+		}
+
+		PROGRAM_BINARY_HEADER header;
+		if (!fileStream.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+			header.magic != PROGRAM_BINARY_MAGIC ||
+			header.version != PROGRAM_BINARY_VERSION ||
+			header.sourceHash != sourceHash ||
+			header.binaryLength == 0)
+		{
+			return 0;
+		}
+
+		std::string binary(header.binaryLength, '\0');
+		if (!fileStream.read(&binary[0], header.binaryLength))
+		{
+			return 0;
+		}
+
+		GLuint programId = glCreateProgram();
+		glProgramBinary(programId, header.binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+
+		// the driver may reject binaries from another driver build
+		GLint success = 0;
+		glGetProgramiv(programId, GL_LINK_STATUS, &success);
+		if (success == GL_FALSE)
+		{
+			std::cout << "INFO: Cached shader program binary rejected, recompiling: " << cachePath << std::endl;
+			glDeleteProgram(programId);
+			return 0;
+		}
+
+		return programId;
+	}
+
+	// overwrites the binary of the previous sources of the permutation
+	void SaveProgramBinary(GLuint programId, const std::string& cachePath, uint64_t sourceHash)
+	{
+		GLint binaryLength = 0;
+		glGetProgramiv(programId, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+		if (binaryLength <= 0)
+		{
+			return;
+		}
+
+		std::string binary(static_cast<size_t>(binaryLength), '\0');
+		GLenum binaryFormat = GL_NONE;
+		GLsizei writtenLength = 0;
+		glGetProgramBinary(programId, binaryLength, &writtenLength, &binaryFormat, &binary[0]);
+		if (writtenLength <= 0)
+		{
+			return;
+		}
+
+		PROGRAM_BINARY_HEADER header;
+		header.magic = PROGRAM_BINARY_MAGIC;
+		header.version = PROGRAM_BINARY_VERSION;
+		header.binaryFormat = binaryFormat;
+		header.binaryLength = static_cast<uint32_t>(writtenLength);
+		header.sourceHash = sourceHash;
+
+		MakeDirectory(CACHE_PARENT_DIRECTORY);
+		MakeDirectory(CACHE_DIRECTORY);
+
+		std::ofstream fileStream(cachePath, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!fileStream.is_open())
+		{
+			std::cerr << "ERROR: Failed to write shader program cache: " << cachePath << std::endl;
+			return;
+		}
+		fileStream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		fileStream.write(binary.data(), writtenLength);
+	}
 }
 
-ShaderManager::ShaderManager() = default;
+ShaderManager::ShaderManager(GLStateCache* pStateCache)
+{
+	m_bOwnsStateCache = (pStateCache == nullptr);
+	m_pStateCache = m_bOwnsStateCache ? new GLStateCache() : pStateCache;
+
+	m_useTextureUniform = GetUniformHandle("bUseTexture");
+	m_useLightingUniform = GetUniformHandle("bUseLighting");
+}
 
 ShaderManager::~ShaderManager()
 {
-	if (m_programId != 0)
+	DeletePrograms();
+	if (m_bOwnsStateCache)
 	{
-		glDeleteProgram(m_programId);
-		m_programId = 0;
+		delete m_pStateCache;
 	}
+	m_pStateCache = nullptr;
 }
 
 bool ShaderManager::LoadShaders(const std::string& vertexShaderPath, const std::string& fragmentShaderPath)
 {
+	m_vertexShaderPath = vertexShaderPath;
+	m_fragmentShaderPath = fragmentShaderPath;
+	// known once GLEW is initialized, which is after construction
+	m_bStorageBuffers = GLEW_VERSION_4_3 || GLEW_ARB_shader_storage_buffer_object;
+	// program binaries need GL 4.1 or the extension, and at least one format
+	m_bProgramBinaries = false;
+	if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary)
+	{
+		GLint binaryFormatCount = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormatCount);
+		m_bProgramBinaries = (binaryFormatCount > 0);
+	}
+
 	std::string vertexSource = ReadTextFile(vertexShaderPath);
 	std::string fragmentSource = ReadTextFile(fragmentShaderPath);
-
-	GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, vertexSource, "vertex");
-	GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentSource, "fragment");
-	if (vertexShader == 0 || fragmentShader == 0)
+	if (vertexSource.empty() || fragmentSource.empty())
 	{
 		return false;
 	}
 
-	GLuint programId = glCreateProgram();
-	glAttachShader(programId, vertexShader);
-	glAttachShader(programId, fragmentShader);
-	glLinkProgram(programId);
+	// rebuild every permutation that was in use (a reload) plus the current
+	// one; the new set only replaces the old one once all of them linked
+	std::vector<uint32_t> variantKeys;
+	for (const auto& program : m_programs)
+	{
+		if (program.second.id != 0)
+		{
+			variantKeys.push_back(program.first);
+		}
+	}
+	uint32_t currentKey = GetVariantKey();
+	if (std::find(variantKeys.begin(), variantKeys.end(), currentKey) == variantKeys.end())
+	{
+		variantKeys.push_back(currentKey);
+	}
 
-	GLint success = 0;
-	glGetProgramiv(programId, GL_LINK_STATUS, &success);
-	if (success == GL_FALSE)
+	std::unordered_map<uint32_t, SHADER_PROGRAM> programs;
+	for (uint32_t variantKey : variantKeys)
 	{
-		GLchar infoLog[1024];
-		glGetProgramInfoLog(programId, sizeof(infoLog), nullptr, infoLog);
-		std::cerr << "ERROR: Shader program link failed\n" << infoLog << std::endl;
-		glDeleteProgram(programId);
-		programId = 0;
+		GLuint programId = BuildProgram(variantKey, vertexSource, fragmentSource);
+		if (programId == 0)
+		{
+			for (const auto& program : programs)
+			{
+				glDeleteProgram(program.second.id);
+			}
+			return false;
+		}
+
+		SHADER_PROGRAM& program = programs[variantKey];
+		program.id = programId;
+		ReflectUniforms(program);
+		ApplyBlockBindings(program);
 	}
 
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
+	DeletePrograms();
+	m_programs.swap(programs);
 
-	if (programId == 0)
+	m_vertexSource = vertexSource;
+	m_fragmentSource = fragmentSource;
+	return true;
+}
+
+bool ShaderManager::ReloadShaders()
+{
+	if (m_vertexShaderPath.empty() || m_fragmentShaderPath.empty())
 	{
 		return false;
 	}
 
-	if (m_programId != 0)
+	// copies, since LoadShaders stores the paths again
+	std::string vertexShaderPath = m_vertexShaderPath;
+	std::string fragmentShaderPath = m_fragmentShaderPath;
+	if (!LoadShaders(vertexShaderPath, fragmentShaderPath))
 	{
-		glDeleteProgram(m_programId);
+		std::cerr << "ERROR: Shader reload failed, keeping the previous program" << std::endl;
+		return false;
 	}
-	
-	m_programId = programId;
+
+	use();
 	return true;
 }
 
 void ShaderManager::use()
 {
-	if (m_programId != 0)
+	SelectVariant();
+}
+
+void ShaderManager::SetPermutationsEnabled(bool bEnabled)
+{
+	if (m_bPermutationsEnabled == bEnabled)
+	{
+		return;
+	}
+
+	m_bPermutationsEnabled = bEnabled;
+	if (!bEnabled)
+	{
+		setIntValue(m_useTextureUniform, (m_features & FEATURE_TEXTURE) != 0);
+		setIntValue(m_useLightingUniform, (m_features & FEATURE_LIGHTING) != 0);
+	}
+	if (m_pCurrentProgram != nullptr)
 	{
-		glUseProgram(m_programId);
+		SelectVariant();
 	}
 }
 
-void ShaderManager::setMat4Value(const std::string& name, const glm::mat4& value)
+void ShaderManager::SetFeature(SHADER_FEATURE feature, bool bEnabled)
 {
-	GLint location = glGetUniformLocation(m_programId, name.c_str());
-	if (location >= 0)
+	uint32_t features = bEnabled ? (m_features | feature) : (m_features & ~static_cast<uint32_t>(feature));
+	if (features == m_features)
+	{
+		return;
+	}
+	m_features = features;
+
+	if (m_bPermutationsEnabled)
+	{
+		SelectVariant();
+	}
+	else if (feature == FEATURE_TEXTURE)
+	{
+		setIntValue(m_useTextureUniform, bEnabled);
+	}
+	else if (feature == FEATURE_LIGHTING)
 	{
-		glUniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]);
+		setIntValue(m_useLightingUniform, bEnabled);
 	}
 }
 
-void ShaderManager::setVec4Value(const std::string& name, const glm::vec4& value)
+void ShaderManager::SetActiveLights(bool bDirectionalLight, int pointLightCount, bool bSpotLight)
 {
-	GLint location = glGetUniformLocation(m_programId, name.c_str());
-	if (location >= 0)
+	uint32_t lightKey = GetLightKey(bDirectionalLight, pointLightCount, bSpotLight);
+	if (lightKey == m_lightKey)
+	{
+		return;
+	}
+
+	m_lightKey = lightKey;
+	if (m_bPermutationsEnabled && m_pCurrentProgram != nullptr)
 	{
-		glUniform4fv(location, 1, &value[0]);
+		SelectVariant();
 	}
 }
 
-void ShaderManager::setVec3Value(const std::string& name, const glm::vec3& value)
+void ShaderManager::SetPass(SHADER_PASS pass)
 {
-	GLint location = glGetUniformLocation(m_programId, name.c_str());
-	if (location >= 0)
+	if (pass == m_pass)
 	{
-		glUniform3fv(location, 1, &value[0]);
+		return;
+	}
+
+	m_pass = pass;
+	if (m_pCurrentProgram != nullptr)
+	{
+		SelectVariant();
 	}
 }
 
-void ShaderManager::setVec2Value(const std::string& name, const glm::vec2& value)
+void ShaderManager::PrebuildVariants(
+	bool bDirectionalLight,
+	int pointLightCount,
+	bool bSpotLight,
+	const std::vector<SHADER_PASS>& passes)
 {
-	GLint location = glGetUniformLocation(m_programId, name.c_str());
-	if (location >= 0)
+	if (m_fragmentSource.empty())
+	{
+		return;
+	}
+
+	// every combination of the SHADER_FEATURE bits
+	const uint32_t FEATURE_COMBINATIONS = (FEATURE_TEXTURE | FEATURE_LIGHTING) + 1;
+
+	uint32_t lightKey = GetLightKey(bDirectionalLight, pointLightCount, bSpotLight);
+	for (SHADER_PASS pass : passes)
 	{
-		glUniform2fv(location, 1, &value[0]);
+		for (uint32_t features = 0; features < FEATURE_COMBINATIONS; ++features)
+		{
+			uint32_t variantKey = GetVariantKey(features, lightKey, pass);
+			if (m_programs.find(variantKey) == m_programs.end())
+			{
+				BuildVariant(variantKey);
+			}
+		}
 	}
 }
 
-void ShaderManager::setFloatValue(const std::string& name, float value)
+uint32_t ShaderManager::GetVariantKey() const
 {
-	GLint location = glGetUniformLocation(m_programId, name.c_str());
-	if (location >= 0)
+	return GetVariantKey(m_features, m_lightKey, m_pass);
+}
+
+uint32_t ShaderManager::GetVariantKey(uint32_t features, uint32_t lightKey, SHADER_PASS pass) const
+{
+	uint32_t passKey = static_cast<uint32_t>(pass) << VARIANT_PASS_SHIFT;
+	if (!m_bPermutationsEnabled)
+	{
+		return VARIANT_BRANCHING | passKey;
+	}
+
+	// the light pass shades every lit pixel of the G-buffer, whatever
+	// object it came from, so only the lights select its permutation
+	if (pass == PASS_DEFERRED_LIGHTING)
 	{
-		glUniform1f(location, value);
+		return passKey | FEATURE_LIGHTING | lightKey;
 	}
+
+	// unlit permutations and the G-buffer pass do not depend on the lights
+	uint32_t variantKey = features | passKey;
+	if ((features & FEATURE_LIGHTING) && pass == PASS_FORWARD)
+	{
+		variantKey |= lightKey;
+	}
+	return variantKey;
 }
 
-void ShaderManager::setIntValue(const std::string& name, int value)
+std::string ShaderManager::GetVariantDefines(uint32_t variantKey) const
 {
-	GLint location = glGetUniformLocation(m_programId, name.c_str());
-	if (location >= 0)
+	// every program reads the materials from a storage buffer when the
+	// driver has them, whether it is a permutation or not
+	std::ostringstream defines;
+	if (m_bStorageBuffers)
+	{
+		defines << "#define USE_STORAGE_BUFFERS\n";
+	}
+	uint32_t pass = (variantKey >> VARIANT_PASS_SHIFT) & VARIANT_PASS_MASK;
+	if (pass == PASS_GBUFFER)
 	{
-		glUniform1i(location, value);
+		defines << "#define GBUFFER_PASS\n";
 	}
+	else if (pass == PASS_DEFERRED_LIGHTING)
+	{
+		defines << "#define LIGHTING_PASS\n";
+	}
+	if (variantKey & VARIANT_BRANCHING)
+	{
+		return defines.str();
+	}
+
+	defines << "#define SHADER_PERMUTATION\n"
+		<< "#define USE_TEXTURE " << ((variantKey & FEATURE_TEXTURE) ? 1 : 0) << "\n"
+		<< "#define USE_LIGHTING " << ((variantKey & FEATURE_LIGHTING) ? 1 : 0) << "\n"
+		<< "#define USE_DIRECTIONAL_LIGHT " << ((variantKey & VARIANT_DIRECTIONAL_LIGHT) ? 1 : 0) << "\n"
+		<< "#define POINT_LIGHT_COUNT " << ((variantKey >> VARIANT_POINT_LIGHT_SHIFT) & VARIANT_POINT_LIGHT_MASK) << "\n"
+		<< "#define USE_SPOT_LIGHT " << ((variantKey & VARIANT_SPOT_LIGHT) ? 1 : 0) << "\n";
+	return defines.str();
 }
 
-void ShaderManager::setSampler2DValue(const std::string& name, int value)
+GLuint ShaderManager::BuildProgram(uint32_t variantKey, const std::string& vertexSource, const std::string& fragmentSource)
 {
-	GLint location = glGetUniformLocation(m_programId, name.c_str());
-	if (location >= 0)
+	auto startTime = std::chrono::steady_clock::now();
+
+	std::string defines = GetVariantDefines(variantKey);
+	std::string variantVertexSource = InjectDefines(vertexSource, defines);
+	std::string variantFragmentSource = InjectDefines(fragmentSource, defines);
+
+	// try the binary cache first, and fall back to a full compile
+	// when there is no cached binary or the driver rejects it
+	std::string cachePath = GetProgramCachePath(variantKey);
+	uint64_t sourceHash = 0;
+	bool bFromCache = false;
+	GLuint programId = 0;
+	if (!cachePath.empty())
 	{
-		glUniform1i(location, value);
+		sourceHash = GetProgramSourceHash(vertexSource, fragmentSource, defines);
+		programId = LoadProgramBinary(cachePath, sourceHash);
+		bFromCache = (programId != 0);
 	}
+	if (programId == 0)
+	{
+		programId = LinkProgram(variantVertexSource, variantFragmentSource, !cachePath.empty());
+		if (programId != 0 && !cachePath.empty())
+		{
+			SaveProgramBinary(programId, cachePath, sourceHash);
+		}
+	}
+
+	if (programId == 0)
+	{
+		std::cerr << "ERROR: Shader permutation 0x" << std::hex << variantKey << std::dec << " failed to build" << std::endl;
+		return 0;
+	}
+
+	double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	std::cout << "INFO: Shader permutation 0x" << std::hex << variantKey << std::dec << " "
+		<< (bFromCache ? "loaded from binary cache (warm)" : "compiled from source (cold)")
+		<< " in " << elapsedMs << " ms" << std::endl;
+	return programId;
+}
+
+std::string ShaderManager::GetProgramCachePath(uint32_t variantKey) const
+{
+	if (!m_bProgramBinaries)
+	{
+		return std::string();
+	}
+
+	// named after the shader files and the permutation but not the sources,
+	// so an edited shader overwrites the stale binary instead of adding one
+	uint64_t hash = 14695981039346656037ull;
+	hash = HashString(hash, m_vertexShaderPath);
+	hash = HashString(hash, m_fragmentShaderPath);
+
+	std::ostringstream cachePath;
+	cachePath << CACHE_DIRECTORY << "program_" << std::hex << hash << "_" << variantKey << ".glbin";
+	return cachePath.str();
+}
+
+uint64_t ShaderManager::GetProgramSourceHash(
+	const std::string& vertexSource,
+	const std::string& fragmentSource,
+	const std::string& defines) const
+{
+	// a binary is only valid for the exact sources, defines and driver build
+	uint64_t hash = 14695981039346656037ull;
+	hash = HashString(hash, vertexSource);
+	hash = HashString(hash, fragmentSource);
+	hash = HashString(hash, defines);
+	hash = HashString(hash, GetGLString(GL_VENDOR));
+	hash = HashString(hash, GetGLString(GL_RENDERER));
+	hash = HashString(hash, GetGLString(GL_VERSION));
+	return hash;
+}
+
+void ShaderManager::SelectVariant()
+{
+	uint32_t variantKey = GetVariantKey();
+	if (m_pCurrentProgram == nullptr || variantKey != m_currentVariant)
+	{
+		auto it = m_programs.find(variantKey);
+		if (it == m_programs.end())
+		{
+			if (m_fragmentSource.empty())
+			{
+				return;
+			}
+
+			// a permutation the scene did not prebuild, e.g. after the light
+			// count changed - built here on first use as a fallback
+			it = BuildVariant(variantKey);
+		}
+
+		// without a program for the permutation keep drawing with the current one
+		if (it->second.id != 0)
+		{
+			m_pCurrentProgram = &it->second;
+			m_currentVariant = variantKey;
+		}
+	}
+	if (m_pCurrentProgram == nullptr || m_pStateCache->GetProgram() == m_pCurrentProgram->id)
+	{
+		return;
+	}
+
+	m_pStateCache->UseProgram(m_pCurrentProgram->id);
+	m_stats.programSwitches++;
+
+	// bring the program up to date with the values set while it was not bound
+	for (size_t i = 0; i < m_uniformValues.size(); ++i)
+	{
+		if (m_uniformValues[i].version != m_pCurrentProgram->uploadedVersions[i])
+		{
+			UploadUniform(*m_pCurrentProgram, static_cast<int>(i));
+		}
+	}
+}
+
+std::unordered_map<uint32_t, ShaderManager::SHADER_PROGRAM>::iterator ShaderManager::BuildVariant(uint32_t variantKey)
+{
+	// later runs load the permutation from the binary cache
+	auto it = m_programs.emplace(variantKey, SHADER_PROGRAM()).first;
+	it->second.id = BuildProgram(variantKey, m_vertexSource, m_fragmentSource);
+	if (it->second.id != 0)
+	{
+		ReflectUniforms(it->second);
+		ApplyBlockBindings(it->second);
+	}
+	return it;
+}
+
+void ShaderManager::DeletePrograms()
+{
+	for (const auto& program : m_programs)
+	{
+		if (program.second.id == 0)
+		{
+			continue;
+		}
+		// a new program may reuse the name, so it must not look bound
+		if (m_pStateCache->GetProgram() == program.second.id)
+		{
+			m_pStateCache->UseProgram(0);
+		}
+		glDeleteProgram(program.second.id);
+	}
+	m_programs.clear();
+	m_pCurrentProgram = nullptr;
+}
+
+UniformHandle ShaderManager::GetUniformHandle(const std::string& name)
+{
+	UniformHandle handle;
+	auto it = m_handleIndices.find(name);
+	if (it != m_handleIndices.end())
+	{
+		handle.index = it->second;
+		return handle;
+	}
+
+	handle.index = static_cast<int>(m_handleNames.size());
+	m_handleNames.push_back(name);
+	m_handleIndices[name] = handle.index;
+	m_uniformValues.push_back(UNIFORM_VALUE());
+
+	for (auto& program : m_programs)
+	{
+		auto location = program.second.uniformLocations.find(name);
+		program.second.handleLocations.push_back(
+			location == program.second.uniformLocations.end() ? -1 : location->second);
+		program.second.uploadedVersions.push_back(0);
+	}
+	return handle;
+}
+
+void ShaderManager::BindUniformBlock(const std::string& blockName, GLuint bindingPoint)
+{
+	SetBlockBinding(m_uniformBlockBindings, blockName, bindingPoint);
+	for (const auto& program : m_programs)
+	{
+		ApplyBlockBindings(program.second);
+	}
+}
+
+void ShaderManager::BindStorageBlock(const std::string& blockName, GLuint bindingPoint)
+{
+	SetBlockBinding(m_storageBlockBindings, blockName, bindingPoint);
+	for (const auto& program : m_programs)
+	{
+		ApplyBlockBindings(program.second);
+	}
+}
+
+void ShaderManager::ApplyBlockBindings(const SHADER_PROGRAM& program)
+{
+	if (program.id == 0)
+	{
+		return;
+	}
+
+	for (const auto& binding : m_uniformBlockBindings)
+	{
+		GLuint blockIndex = glGetUniformBlockIndex(program.id, binding.first.c_str());
+		if (blockIndex != GL_INVALID_INDEX)
+		{
+			glUniformBlockBinding(program.id, blockIndex, binding.second);
+		}
+	}
+
+	if (!m_bStorageBuffers)
+	{
+		return;
+	}
+	for (const auto& binding : m_storageBlockBindings)
+	{
+		GLuint blockIndex = glGetProgramResourceIndex(program.id, GL_SHADER_STORAGE_BLOCK, binding.first.c_str());
+		if (blockIndex != GL_INVALID_INDEX)
+		{
+			glShaderStorageBlockBinding(program.id, blockIndex, binding.second);
+		}
+	}
+}
+
+void ShaderManager::ReflectUniforms(SHADER_PROGRAM& program)
+{
+	program.uniformLocations.clear();
+
+	GLint uniformCount = 0;
+	glGetProgramiv(program.id, GL_ACTIVE_UNIFORMS, &uniformCount);
+
+	for (GLint i = 0; i < uniformCount; ++i)
+	{
+		GLchar nameBuffer[256];
+		GLsizei nameLength = 0;
+		GLint arraySize = 0;
+		GLenum type = GL_NONE;
+		glGetActiveUniform(program.id, static_cast<GLuint>(i), sizeof(nameBuffer), &nameLength, &arraySize, &type, nameBuffer);
+
+		std::string name(nameBuffer, nameLength);
+		GLint location = glGetUniformLocation(program.id, name.c_str());
+		if (location < 0)
+		{
+			// members of uniform blocks have no location
+			continue;
+		}
+		program.uniformLocations[name] = location;
+
+		// arrays of basic types are reported as "name[0]" - expose every element
+		// as well as the bare name so both spellings resolve without the driver
+		const std::string arraySuffix = "[0]";
+		if (name.size() > arraySuffix.size() &&
+			name.compare(name.size() - arraySuffix.size(), arraySuffix.size(), arraySuffix) == 0)
+		{
+			std::string baseName = name.substr(0, name.size() - arraySuffix.size());
+			program.uniformLocations[baseName] = location;
+			for (GLint element = 1; element < arraySize; ++element)
+			{
+				std::string elementName = baseName + "[" + std::to_string(element) + "]";
+				program.uniformLocations[elementName] = glGetUniformLocation(program.id, elementName.c_str());
+			}
+		}
+	}
+
+	program.handleLocations.assign(m_handleNames.size(), -1);
+	program.uploadedVersions.assign(m_handleNames.size(), 0);
+	for (size_t i = 0; i < m_handleNames.size(); ++i)
+	{
+		auto location = program.uniformLocations.find(m_handleNames[i]);
+		if (location != program.uniformLocations.end())
+		{
+			program.handleLocations[i] = location->second;
+		}
+	}
+}
+
+UniformHandle ShaderManager::FindUniformHandle(const std::string& name)
+{
+	m_stats.nameUploads++;
+	m_stats.lookupsAvoided++;
+	return GetUniformHandle(name);
+}
+
+void ShaderManager::SetUniformValue(UniformHandle handle, GLenum type, const float* floats, int intValue)
+{
+	if (handle.index < 0 || handle.index >= static_cast<int>(m_uniformValues.size()))
+	{
+		return;
+	}
+
+	int count = 0;
+	switch (type)
+	{
+	case GL_FLOAT_MAT4: count = 16; break;
+	case GL_FLOAT_VEC4: count = 4; break;
+	case GL_FLOAT_VEC3: count = 3; break;
+	case GL_FLOAT_VEC2: count = 2; break;
+	case GL_FLOAT: count = 1; break;
+	default: break;
+	}
+
+	// a new version is only started when the value really changes
+	UNIFORM_VALUE& value = m_uniformValues[handle.index];
+	bool bChanged = value.version == 0 ||
+		value.type != type ||
+		value.intValue != intValue ||
+		!std::equal(floats, floats + count, value.floats);
+	if (bChanged)
+	{
+		value.type = type;
+		value.intValue = intValue;
+		std::copy(floats, floats + count, value.floats);
+		// version 0 is reserved for "never set"
+		if (++value.version == 0)
+		{
+			value.version = 1;
+		}
+	}
+
+	// programs that are not bound pick the value up when they are bound
+	if (m_pCurrentProgram == nullptr || m_pStateCache->GetProgram() != m_pCurrentProgram->id)
+	{
+		return;
+	}
+	if (m_pCurrentProgram->uploadedVersions[handle.index] == value.version)
+	{
+		m_pStateCache->CountSkipped();
+		return;
+	}
+	UploadUniform(*m_pCurrentProgram, handle.index);
+}
+
+void ShaderManager::UploadUniform(SHADER_PROGRAM& program, int index)
+{
+	const UNIFORM_VALUE& value = m_uniformValues[index];
+	program.uploadedVersions[index] = value.version;
+
+	GLint location = program.handleLocations[index];
+	if (location < 0)
+	{
+		return;
+	}
+	m_pStateCache->CountIssued();
+
+	switch (value.type)
+	{
+	case GL_FLOAT_MAT4:
+		glUniformMatrix4fv(location, 1, GL_FALSE, value.floats);
+		break;
+	case GL_FLOAT_VEC4:
+		glUniform4fv(location, 1, value.floats);
+		break;
+	case GL_FLOAT_VEC3:
+		glUniform3fv(location, 1, value.floats);
+		break;
+	case GL_FLOAT_VEC2:
+		glUniform2fv(location, 1, value.floats);
+		break;
+	case GL_FLOAT:
+		glUniform1f(location, value.floats[0]);
+		break;
+	case GL_INT:
+		glUniform1i(location, value.intValue);
+		break;
+	default:
+		break;
+	}
+}
+
+void ShaderManager::setMat4Value(const std::string& name, const glm::mat4& value)
+{
+	SetUniformValue(FindUniformHandle(name), GL_FLOAT_MAT4, &value[0][0], 0);
+}
+
+void ShaderManager::setVec4Value(const std::string& name, const glm::vec4& value)
+{
+	SetUniformValue(FindUniformHandle(name), GL_FLOAT_VEC4, &value[0], 0);
+}
+
+void ShaderManager::setVec3Value(const std::string& name, const glm::vec3& value)
+{
+	SetUniformValue(FindUniformHandle(name), GL_FLOAT_VEC3, &value[0], 0);
+}
+
+void ShaderManager::setVec2Value(const std::string& name, const glm::vec2& value)
+{
+	SetUniformValue(FindUniformHandle(name), GL_FLOAT_VEC2, &value[0], 0);
+}
+
+void ShaderManager::setFloatValue(const std::string& name, float value)
+{
+	SetUniformValue(FindUniformHandle(name), GL_FLOAT, &value, 0);
+}
+
+void ShaderManager::setIntValue(const std::string& name, int value)
+{
+	SetUniformValue(FindUniformHandle(name), GL_INT, nullptr, value);
+}
+
+void ShaderManager::setSampler2DValue(const std::string& name, int value)
+{
+	SetUniformValue(FindUniformHandle(name), GL_INT, nullptr, value);
+}
+
+void ShaderManager::setMat4Value(UniformHandle handle, const glm::mat4& value)
+{
+	m_stats.handleUploads++;
+	m_stats.lookupsAvoided++;
+	SetUniformValue(handle, GL_FLOAT_MAT4, &value[0][0], 0);
+}
+
+void ShaderManager::setVec4Value(UniformHandle handle, const glm::vec4& value)
+{
+	m_stats.handleUploads++;
+	m_stats.lookupsAvoided++;
+	SetUniformValue(handle, GL_FLOAT_VEC4, &value[0], 0);
+}
+
+void ShaderManager::setVec3Value(UniformHandle handle, const glm::vec3& value)
+{
+	m_stats.handleUploads++;
+	m_stats.lookupsAvoided++;
+	SetUniformValue(handle, GL_FLOAT_VEC3, &value[0], 0);
+}
+
+void ShaderManager::setVec2Value(UniformHandle handle, const glm::vec2& value)
+{
+	m_stats.handleUploads++;
+	m_stats.lookupsAvoided++;
+	SetUniformValue(handle, GL_FLOAT_VEC2, &value[0], 0);
+}
+
+void ShaderManager::setFloatValue(UniformHandle handle, float value)
+{
+	m_stats.handleUploads++;
+	m_stats.lookupsAvoided++;
+	SetUniformValue(handle, GL_FLOAT, &value, 0);
+}
+
+void ShaderManager::setIntValue(UniformHandle handle, int value)
+{
+	m_stats.handleUploads++;
+	m_stats.lookupsAvoided++;
+	SetUniformValue(handle, GL_INT, nullptr, value);
+}
+
+void ShaderManager::setSampler2DValue(UniformHandle handle, int value)
+{
+	m_stats.handleUploads++;
+	m_stats.lookupsAvoided++;
+	SetUniformValue(handle, GL_INT, nullptr, value);
 }
@@ -1,19 +1,107 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 
+#include "GLStateCache.h"
+
+// Pre-resolved reference to a shader uniform. Handles are requested once by
+// name and stay valid across shader reloads; the location behind each handle
+// is re-resolved whenever a program is linked.
+struct UniformHandle
+{
+	int index = -1;
+
+	bool IsValid() const { return index >= 0; }
+};
+
 class ShaderManager
 {
 public:
-	ShaderManager();
+	// features that select a specialized shader permutation; each one is
+	// compiled in as a #define instead of being branched on per fragment
+	enum SHADER_FEATURE : uint32_t
+	{
+		FEATURE_TEXTURE = 1u << 0,
+		FEATURE_LIGHTING = 1u << 1,
+	};
+
+	// what the following draw calls write - the shaded color, the surface
+	// attributes of the G-buffer, or the shading of the G-buffer pixels
+	// by the deferred light pass
+	enum SHADER_PASS : uint32_t
+	{
+		PASS_FORWARD = 0,
+		PASS_GBUFFER = 1,
+		PASS_DEFERRED_LIGHTING = 2,
+	};
+
+	// uniform upload counters, accumulated until ResetStats() is called
+	struct UNIFORM_STATS
+	{
+		// uploads issued through a pre-resolved handle (no string work at all)
+		unsigned int handleUploads = 0;
+		// uploads issued by name, resolved through the reflected uniform table
+		unsigned int nameUploads = 0;
+		// glGetUniformLocation calls avoided compared to querying per upload
+		unsigned int lookupsAvoided = 0;
+		// glUseProgram calls caused by switching shader permutations
+		unsigned int programSwitches = 0;
+	};
+
+	// shader managers drawing into the same context share one state cache;
+	// without one the shader manager creates its own
+	explicit ShaderManager(GLStateCache* pStateCache = nullptr);
 	~ShaderManager();
 
+	// OpenGL state shadowing shared by everything that draws
+	GLStateCache* GetStateCache() { return m_pStateCache; }
+
 	bool LoadShaders(const std::string& vertexShaderPath, const std::string& fragmentShaderPath);
+	// rebuild every permutation from the last loaded shader files; on failure
+	// the previous programs stay active
+	bool ReloadShaders();
 	void use();
 
+	// use specialized permutations (default) or the single program that
+	// branches on bUseTexture/bUseLighting at runtime - set before loading
+	void SetPermutationsEnabled(bool bEnabled);
+	bool GetPermutationsEnabled() const { return m_bPermutationsEnabled; }
+	// turn a feature on or off for the following draw calls
+	void SetFeature(SHADER_FEATURE feature, bool bEnabled);
+	// light sources compiled into the lit permutations - point lights must be
+	// packed at the front of the light block
+	void SetActiveLights(bool bDirectionalLight, int pointLightCount, bool bSpotLight);
+	// select the pass of the following draw calls, each pass is compiled
+	// with its own GBUFFER_PASS / LIGHTING_PASS define
+	void SetPass(SHADER_PASS pass);
+	SHADER_PASS GetPass() const { return m_pass; }
+	// build every feature permutation of the passes for the lights ahead of
+	// the first draw, so the draw path does not stall on a cold compile;
+	// permutations not built here are still built on first use
+	void PrebuildVariants(
+		bool bDirectionalLight,
+		int pointLightCount,
+		bool bSpotLight,
+		const std::vector<SHADER_PASS>& passes);
+
+	// register a uniform name once and get a handle for the hot path
+	UniformHandle GetUniformHandle(const std::string& name);
+	// attach a uniform block to a buffer binding point, kept across reloads
+	void BindUniformBlock(const std::string& blockName, GLuint bindingPoint);
+	// attach a shader storage block to a buffer binding point, kept across
+	// reloads - only used when storage buffers are supported
+	void BindStorageBlock(const std::string& blockName, GLuint bindingPoint);
+	// true once shaders were loaded on a driver with shader storage buffers;
+	// the shaders are then compiled with USE_STORAGE_BUFFERS defined
+	bool GetStorageBuffersSupported() const { return m_bStorageBuffers; }
+
 	void setMat4Value(const std::string& name, const glm::mat4& value);
 	void setVec4Value(const std::string& name, const glm::vec4& value);
 	void setVec3Value(const std::string& name, const glm::vec3& value);
@@ -22,6 +110,95 @@ public:
 	void setIntValue(const std::string& name, int value);
 	void setSampler2DValue(const std::string& name, int value);
 
+	void setMat4Value(UniformHandle handle, const glm::mat4& value);
+	void setVec4Value(UniformHandle handle, const glm::vec4& value);
+	void setVec3Value(UniformHandle handle, const glm::vec3& value);
+	void setVec2Value(UniformHandle handle, const glm::vec2& value);
+	void setFloatValue(UniformHandle handle, float value);
+	void setIntValue(UniformHandle handle, int value);
+	void setSampler2DValue(UniformHandle handle, int value);
+
+	const UNIFORM_STATS& GetStats() const { return m_stats; }
+	void ResetStats() { m_stats = UNIFORM_STATS(); }
+
 private:
-	GLuint m_programId = 0;
+	GLStateCache* m_pStateCache;
+	bool m_bOwnsStateCache;
+
+	// one linked permutation and the uniform state it has received
+	struct SHADER_PROGRAM
+	{
+		GLuint id = 0;
+		// every active uniform of the program, reflected once after linking
+		std::unordered_map<std::string, GLint> uniformLocations;
+		// location of each registered uniform handle in this program
+		std::vector<GLint> handleLocations;
+		// value version of each handle last uploaded to this program
+		std::vector<uint32_t> uploadedVersions;
+	};
+
+	// last value set through a uniform handle, re-applied to permutations
+	// that were not bound when the value was set
+	struct UNIFORM_VALUE
+	{
+		GLenum type = GL_NONE;
+		float floats[16];
+		int intValue = 0;
+		// 0 while the uniform was never set
+		uint32_t version = 0;
+	};
+
+	std::string m_vertexShaderPath;
+	std::string m_fragmentShaderPath;
+	std::string m_vertexSource;
+	std::string m_fragmentSource;
+
+	bool m_bPermutationsEnabled = true;
+	bool m_bStorageBuffers = false;
+	// the driver can save and restore linked program binaries
+	bool m_bProgramBinaries = false;
+	// SHADER_FEATURE bits plus the light counts of the next draw call
+	uint32_t m_features = 0;
+	uint32_t m_lightKey = 0;
+	SHADER_PASS m_pass = PASS_FORWARD;
+	// linked permutations by variant key, prebuilt or built on first use
+	std::unordered_map<uint32_t, SHADER_PROGRAM> m_programs;
+	SHADER_PROGRAM* m_pCurrentProgram = nullptr;
+	uint32_t m_currentVariant = 0;
+
+	// names, lookup table and last values of the registered uniform handles
+	std::vector<std::string> m_handleNames;
+	std::unordered_map<std::string, int> m_handleIndices;
+	std::vector<UNIFORM_VALUE> m_uniformValues;
+	// uniform and storage block names and the binding points they are attached to
+	std::vector<std::pair<std::string, GLuint>> m_uniformBlockBindings;
+	std::vector<std::pair<std::string, GLuint>> m_storageBlockBindings;
+	// feature uniforms of the branching program
+	UniformHandle m_useTextureUniform;
+	UniformHandle m_useLightingUniform;
+
+	UNIFORM_STATS m_stats;
+
+	// file used to cache the linked binary of a permutation, empty when
+	// unsupported - one file per permutation, so a rebuild replaces it
+	std::string GetProgramCachePath(uint32_t variantKey) const;
+	// hash a cached binary must carry to match the current sources
+	uint64_t GetProgramSourceHash(
+		const std::string& vertexSource,
+		const std::string& fragmentSource,
+		const std::string& defines) const;
+	uint32_t GetVariantKey() const;
+	uint32_t GetVariantKey(uint32_t features, uint32_t lightKey, SHADER_PASS pass) const;
+	std::string GetVariantDefines(uint32_t variantKey) const;
+	GLuint BuildProgram(uint32_t variantKey, const std::string& vertexSource, const std::string& fragmentSource);
+	// link a permutation from the loaded sources and remember it, even
+	// when it failed so it is not retried every draw
+	std::unordered_map<uint32_t, SHADER_PROGRAM>::iterator BuildVariant(uint32_t variantKey);
+	void SelectVariant();
+	void ReflectUniforms(SHADER_PROGRAM& program);
+	void ApplyBlockBindings(const SHADER_PROGRAM& program);
+	void DeletePrograms();
+	UniformHandle FindUniformHandle(const std::string& name);
+	void SetUniformValue(UniformHandle handle, GLenum type, const float* floats, int intValue);
+	void UploadUniform(SHADER_PROGRAM& program, int index);
 };
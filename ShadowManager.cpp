@@ -0,0 +1,490 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadowmanager.cpp
+// ============
+// render and cache the shadow maps of the directional and spot lights
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShadowManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace
+{
+	const char* g_LightMatrixName = "lightMatrix";
+	// near plane of the spot light camera
+	const float SPOT_NEAR_PLANE = 0.25f;
+	// widest spot cone the perspective projection is fitted to
+	const float MAX_SPOT_FIELD_OF_VIEW = glm::radians(170.0f);
+	// slope scaled depth offset of the casters, against shadow acne
+	const float POLYGON_OFFSET_FACTOR = 2.0f;
+	const float POLYGON_OFFSET_UNITS = 4.0f;
+
+	// any up vector that is not parallel to the light direction
+	glm::vec3 GetLightUp(const glm::vec3& direction)
+	{
+		return (std::fabs(direction.y) > 0.99f) ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	}
+}
+
+/***********************************************************
+ *  ShadowManager()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShadowManager::ShadowManager(GLStateCache* pStateCache)
+{
+	m_pStateCache = pStateCache;
+	m_pShaderManager = NULL;
+	m_bMovingCasters = false;
+	m_passMap = -1;
+	for (int i = 0; i < 4; ++i)
+	{
+		m_savedViewport[i] = 0;
+	}
+
+	for (SHADOW_MAP_DATA& map : m_maps)
+	{
+		map.bActive = false;
+		map.lightMatrix = glm::mat4(1.0f);
+		map.staticTexture = 0;
+		map.staticFramebuffer = 0;
+		map.movingTexture = 0;
+		map.movingFramebuffer = 0;
+		map.bStaticValid = false;
+		map.bMovingValid = false;
+		map.bRendered = false;
+	}
+}
+
+/***********************************************************
+ *  ~ShadowManager()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShadowManager::~ShadowManager()
+{
+	Destroy();
+	delete m_pShaderManager;
+	m_pShaderManager = NULL;
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the depth textures of
+ *  both maps and loading the depth-only shader program,
+ *  which shares the state cache of the scene shaders.
+ ***********************************************************/
+bool ShadowManager::Create(const std::string& vertexShaderPath, const std::string& fragmentShaderPath)
+{
+	if (NULL == m_pShaderManager)
+	{
+		m_pShaderManager = new ShaderManager(m_pStateCache);
+		// one program, the depth pass has no features to specialize on
+		m_pShaderManager->SetPermutationsEnabled(false);
+		m_lightMatrixUniform = m_pShaderManager->GetUniformHandle(g_LightMatrixName);
+	}
+	if (m_pShaderManager->LoadShaders(vertexShaderPath, fragmentShaderPath) == false)
+	{
+		std::cerr << "ERROR: Could not load the shadow map shaders" << std::endl;
+		return false;
+	}
+
+	for (SHADOW_MAP_DATA& map : m_maps)
+	{
+		if (!CreateDepthTarget(map.staticTexture, map.staticFramebuffer) ||
+			!CreateDepthTarget(map.movingTexture, map.movingFramebuffer))
+		{
+			Destroy();
+			return false;
+		}
+	}
+
+	std::cout << "INFO: " << SHADOW_MAP_COUNT << " shadow maps of " << MAP_SIZE << "x" << MAP_SIZE
+		<< " texels, static and moving depth cached separately" << std::endl;
+	InvalidateAll();
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the depth textures and
+ *  their frame buffers.
+ ***********************************************************/
+void ShadowManager::Destroy()
+{
+	for (int i = 0; i < SHADOW_MAP_COUNT; ++i)
+	{
+		SHADOW_MAP_DATA& map = m_maps[i];
+		m_pStateCache->BindTexture(FIRST_TEXTURE_UNIT + i, GL_TEXTURE_2D, 0);
+		GLuint textures[2] = { map.staticTexture, map.movingTexture };
+		GLuint framebuffers[2] = { map.staticFramebuffer, map.movingFramebuffer };
+		glDeleteTextures(2, textures);
+		glDeleteFramebuffers(2, framebuffers);
+		map.staticTexture = 0;
+		map.staticFramebuffer = 0;
+		map.movingTexture = 0;
+		map.movingFramebuffer = 0;
+		map.bStaticValid = false;
+		map.bMovingValid = false;
+	}
+}
+
+/***********************************************************
+ *  ReloadShaders()
+ *
+ *  This method is used for rebuilding the depth-only shader
+ *  program after its source files changed on disk.
+ ***********************************************************/
+bool ShadowManager::ReloadShaders()
+{
+	if (NULL == m_pShaderManager)
+	{
+		return false;
+	}
+	// a changed shader may place the casters differently
+	InvalidateAll();
+	return m_pShaderManager->ReloadShaders();
+}
+
+/***********************************************************
+ *  CreateDepthTarget()
+ *
+ *  This method is used for creating a depth texture set up
+ *  for hardware depth comparison, and a frame buffer with it
+ *  as the only attachment.  Linear filtering makes every
+ *  comparison a 2x2 percentage closer filter, and the white
+ *  border leaves everything outside the map lit.
+ ***********************************************************/
+bool ShadowManager::CreateDepthTarget(GLuint& texture, GLuint& framebuffer)
+{
+	glGenTextures(1, &texture);
+	m_pStateCache->BindTexture(FIRST_TEXTURE_UNIT, GL_TEXTURE_2D, texture);
+	m_pStateCache->ActiveTexture(FIRST_TEXTURE_UNIT);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, MAP_SIZE, MAP_SIZE, 0,
+		GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+	const GLfloat border[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, texture, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cerr << "ERROR: Shadow map frame buffer is incomplete (0x" << std::hex << status << std::dec << ")" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+/***********************************************************
+ *  SetDirectionalLight()
+ *
+ *  This method is used for placing the directional light
+ *  camera.  The orthographic projection is fitted to the
+ *  sphere around the scene bounds, so the map covers every
+ *  caster whatever the light direction.
+ ***********************************************************/
+void ShadowManager::SetDirectionalLight(const glm::vec3& direction, const glm::vec3& sceneMin, const glm::vec3& sceneMax, bool bActive)
+{
+	glm::vec3 center = (sceneMin + sceneMax) * 0.5f;
+	float radius = std::max(glm::length(sceneMax - sceneMin) * 0.5f, 0.01f);
+	glm::vec3 lightDirection = glm::normalize(direction);
+
+	glm::mat4 view = glm::lookAt(center - lightDirection * radius, center, GetLightUp(lightDirection));
+	glm::mat4 projection = glm::ortho(-radius, radius, -radius, radius, 0.0f, radius * 2.0f);
+	SetLightMatrix(SHADOW_DIRECTIONAL, projection * view, bActive);
+}
+
+/***********************************************************
+ *  SetSpotLight()
+ *
+ *  This method is used for placing the spot light camera.
+ *  The perspective projection spans the outer cone, given
+ *  as the cosine of its half angle, out to the range where
+ *  the light has faded.
+ ***********************************************************/
+void ShadowManager::SetSpotLight(const glm::vec3& position, const glm::vec3& direction, float outerCutOff, float range, bool bActive)
+{
+	glm::vec3 lightDirection = glm::normalize(direction);
+	float fieldOfView = std::min(2.0f * std::acos(glm::clamp(outerCutOff, -1.0f, 1.0f)), MAX_SPOT_FIELD_OF_VIEW);
+	float farPlane = std::max(range, SPOT_NEAR_PLANE * 2.0f);
+
+	glm::mat4 view = glm::lookAt(position, position + lightDirection, GetLightUp(lightDirection));
+	glm::mat4 projection = glm::perspective(fieldOfView, 1.0f, SPOT_NEAR_PLANE, farPlane);
+	SetLightMatrix(SHADOW_SPOT, projection * view, bActive);
+}
+
+/***********************************************************
+ *  SetLightMatrix()
+ *
+ *  This method is used for setting the light matrix of a
+ *  map.  The cached depth stays valid for as long as the
+ *  matrix and the light stay the same.
+ ***********************************************************/
+void ShadowManager::SetLightMatrix(SHADOW_MAP map, const glm::mat4& lightMatrix, bool bActive)
+{
+	SHADOW_MAP_DATA& data = m_maps[map];
+	if (data.bActive != bActive || data.lightMatrix != lightMatrix)
+	{
+		data.bStaticValid = false;
+		data.bMovingValid = false;
+	}
+	data.bActive = bActive;
+	data.lightMatrix = lightMatrix;
+}
+
+/***********************************************************
+ *  ObjectMoved()
+ *
+ *  This method is used for invalidating the maps that see a
+ *  caster before or after it moved.  A caster moving for the
+ *  first time is taken out of the static depth, which then
+ *  has to be rendered once more; after that only the moving
+ *  casters are drawn again.
+ ***********************************************************/
+void ShadowManager::ObjectMoved(const glm::vec3& oldMin, const glm::vec3& oldMax,
+	const glm::vec3& newMin, const glm::vec3& newMax, bool bLeftStatic)
+{
+	for (int i = 0; i < SHADOW_MAP_COUNT; ++i)
+	{
+		SHADOW_MAP map = static_cast<SHADOW_MAP>(i);
+		if (!IsBoxInView(map, oldMin, oldMax) && !IsBoxInView(map, newMin, newMax))
+		{
+			continue;
+		}
+		if (bLeftStatic)
+		{
+			m_maps[i].bStaticValid = false;
+		}
+		m_maps[i].bMovingValid = false;
+	}
+}
+
+/***********************************************************
+ *  InvalidateAll()
+ *
+ *  This method is used for rendering every map again.
+ ***********************************************************/
+void ShadowManager::InvalidateAll()
+{
+	for (SHADOW_MAP_DATA& map : m_maps)
+	{
+		map.bStaticValid = false;
+		map.bMovingValid = false;
+	}
+}
+
+/***********************************************************
+ *  SetMovingCasters()
+ *
+ *  This method is used for telling whether any caster moved
+ *  since the scene was loaded.  Without moving casters the
+ *  static depth is sampled directly and never copied.
+ ***********************************************************/
+void ShadowManager::SetMovingCasters(bool bMovingCasters)
+{
+	if (m_bMovingCasters != bMovingCasters)
+	{
+		for (SHADOW_MAP_DATA& map : m_maps)
+		{
+			map.bMovingValid = false;
+		}
+	}
+	m_bMovingCasters = bMovingCasters;
+}
+
+/***********************************************************
+ *  IsBoxInView()
+ *
+ *  This method is used for testing a world box against the
+ *  clip volume of a light.  The box is outside when all of
+ *  its corners are beyond the same clip plane.
+ ***********************************************************/
+bool ShadowManager::IsBoxInView(SHADOW_MAP map, const glm::vec3& boxMin, const glm::vec3& boxMax) const
+{
+	const SHADOW_MAP_DATA& data = m_maps[map];
+	if (!data.bActive)
+	{
+		return false;
+	}
+
+	// bit per clip plane that every corner so far is beyond
+	int outside = 0x3F;
+	for (int corner = 0; corner < 8 && outside != 0; ++corner)
+	{
+		glm::vec4 point(
+			(corner & 1) ? boxMax.x : boxMin.x,
+			(corner & 2) ? boxMax.y : boxMin.y,
+			(corner & 4) ? boxMax.z : boxMin.z,
+			1.0f);
+		glm::vec4 clip = data.lightMatrix * point;
+		int cornerOutside =
+			(clip.x < -clip.w ? 0x01 : 0) | (clip.x > clip.w ? 0x02 : 0) |
+			(clip.y < -clip.w ? 0x04 : 0) | (clip.y > clip.w ? 0x08 : 0) |
+			(clip.z < -clip.w ? 0x10 : 0) | (clip.z > clip.w ? 0x20 : 0);
+		outside &= cornerOutside;
+	}
+	return outside == 0;
+}
+
+/***********************************************************
+ *  BeginPass()
+ *
+ *  This method is used for binding the frame buffer of a
+ *  pass with the map viewport and the depth-only program.
+ *  The casters are drawn from both sides, pushed back by a
+ *  slope scaled offset.
+ ***********************************************************/
+void ShadowManager::BeginPass(SHADOW_MAP map, GLuint framebuffer)
+{
+	m_passMap = map;
+	m_maps[map].bRendered = true;
+	m_maps[map].timer.Begin();
+
+	glGetIntegerv(GL_VIEWPORT, m_savedViewport);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, MAP_SIZE, MAP_SIZE);
+	m_pStateCache->SetEnabled(GL_CULL_FACE, false);
+	m_pStateCache->Enable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(POLYGON_OFFSET_FACTOR, POLYGON_OFFSET_UNITS);
+
+	m_pShaderManager->setMat4Value(m_lightMatrixUniform, m_maps[map].lightMatrix);
+	m_pShaderManager->use();
+}
+
+/***********************************************************
+ *  BeginStaticPass()
+ *
+ *  This method is used for starting to draw the static
+ *  casters into a map whose cached depth is out of date.
+ ***********************************************************/
+bool ShadowManager::BeginStaticPass(SHADOW_MAP map)
+{
+	SHADOW_MAP_DATA& data = m_maps[map];
+	if (!data.bActive || data.bStaticValid || data.staticFramebuffer == 0)
+	{
+		return false;
+	}
+
+	BeginPass(map, data.staticFramebuffer);
+	glClear(GL_DEPTH_BUFFER_BIT);
+	data.bStaticValid = true;
+	// the moving casters are drawn over the new static depth
+	data.bMovingValid = false;
+	data.stats.staticRenders++;
+	return true;
+}
+
+/***********************************************************
+ *  BeginMovingPass()
+ *
+ *  This method is used for starting to draw the moving
+ *  casters of a map.  The cached static depth is copied in
+ *  first, so the static casters are never drawn again for
+ *  a caster that moves.
+ ***********************************************************/
+bool ShadowManager::BeginMovingPass(SHADOW_MAP map)
+{
+	SHADOW_MAP_DATA& data = m_maps[map];
+	if (!data.bActive || !m_bMovingCasters || data.bMovingValid || data.movingFramebuffer == 0)
+	{
+		return false;
+	}
+
+	BeginPass(map, data.movingFramebuffer);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, data.staticFramebuffer);
+	glBlitFramebuffer(0, 0, MAP_SIZE, MAP_SIZE, 0, 0, MAP_SIZE, MAP_SIZE, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, data.movingFramebuffer);
+	data.bMovingValid = true;
+	data.stats.movingRenders++;
+	return true;
+}
+
+/***********************************************************
+ *  EndPass()
+ *
+ *  This method is used for finishing a pass and going back
+ *  to the default frame buffer and the saved viewport.
+ ***********************************************************/
+void ShadowManager::EndPass()
+{
+	if (m_passMap < 0)
+	{
+		return;
+	}
+
+	m_pStateCache->Disable(GL_POLYGON_OFFSET_FILL);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(m_savedViewport[0], m_savedViewport[1], m_savedViewport[2], m_savedViewport[3]);
+	m_maps[m_passMap].timer.End();
+	m_passMap = -1;
+}
+
+/***********************************************************
+ *  BindShadowMaps()
+ *
+ *  This method is used for binding the depth each map is
+ *  sampled from - the static depth while no caster moved,
+ *  else the copy with the moving casters drawn over it.
+ ***********************************************************/
+void ShadowManager::BindShadowMaps()
+{
+	for (int i = 0; i < SHADOW_MAP_COUNT; ++i)
+	{
+		GLuint texture = m_bMovingCasters ? m_maps[i].movingTexture : m_maps[i].staticTexture;
+		m_pStateCache->BindTexture(FIRST_TEXTURE_UNIT + i, GL_TEXTURE_2D, texture);
+	}
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for counting the frames in which an
+ *  active map was reused without drawing anything.
+ ***********************************************************/
+void ShadowManager::EndFrame()
+{
+	for (SHADOW_MAP_DATA& map : m_maps)
+	{
+		if (map.bActive && !map.bRendered)
+		{
+			map.stats.cachedFrames++;
+		}
+		map.bRendered = false;
+	}
+}
+
+/***********************************************************
+ *  ResetStats()
+ *
+ *  This method is used for clearing the render counters and
+ *  the GPU timings.
+ ***********************************************************/
+void ShadowManager::ResetStats()
+{
+	for (SHADOW_MAP_DATA& map : m_maps)
+	{
+		map.stats = SHADOW_STATS();
+		map.timer.Reset();
+	}
+}
@@ -0,0 +1,149 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadowmanager.h
+// ============
+// render and cache the shadow maps of the directional and spot lights
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "GLStateCache.h"
+#include "GpuTimer.h"
+
+#include <string>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  ShadowManager
+ *
+ *  This class owns one shadow map for the directional light
+ *  and one for the spot light.  Each map keeps the depth of
+ *  the casters that never moved in a texture of its own,
+ *  which is only rendered again when the light moves, the
+ *  scene is loaded, or a caster in the light's view starts
+ *  moving.  The casters that moved since the scene was
+ *  loaded are drawn over a copy of that depth, and only in
+ *  the frames they move in view of the light.  The caller
+ *  draws the casters between a Begin...Pass() call that
+ *  returned true and EndPass().
+ ***********************************************************/
+class ShadowManager
+{
+public:
+	enum SHADOW_MAP
+	{
+		SHADOW_DIRECTIONAL = 0,
+		SHADOW_SPOT,
+		SHADOW_MAP_COUNT
+	};
+
+	// texture units the fragment shader samples the maps from - the
+	// texture arrays take the units below them
+	static const GLuint FIRST_TEXTURE_UNIT = 14;
+	// width and height of every shadow map in texels
+	static const int MAP_SIZE = 2048;
+
+	// map render counters, accumulated until ResetStats()
+	struct SHADOW_STATS
+	{
+		unsigned int staticRenders = 0;
+		unsigned int movingRenders = 0;
+		unsigned int cachedFrames = 0;
+	};
+
+	// constructor
+	ShadowManager(GLStateCache* pStateCache);
+	// destructor
+	~ShadowManager();
+
+	// create the depth textures and load the depth-only shader program
+	bool Create(const std::string& vertexShaderPath, const std::string& fragmentShaderPath);
+	// free the depth textures
+	void Destroy();
+	// rebuild the depth-only shader program after its source changed
+	bool ReloadShaders();
+
+	// place the light cameras - a map is rendered again once its light
+	// moves.  The directional map covers the bounds of the whole scene,
+	// the spot map the cone of the spot light up to its range.
+	void SetDirectionalLight(const glm::vec3& direction, const glm::vec3& sceneMin, const glm::vec3& sceneMax, bool bActive);
+	void SetSpotLight(const glm::vec3& position, const glm::vec3& direction, float outerCutOff, float range, bool bActive);
+
+	// a caster moved from one world box to another - bLeftStatic when it
+	// was part of the cached static depth until now
+	void ObjectMoved(const glm::vec3& oldMin, const glm::vec3& oldMax,
+		const glm::vec3& newMin, const glm::vec3& newMax, bool bLeftStatic);
+	// render every map again, after the scene was loaded
+	void InvalidateAll();
+	// the scene has casters that moved since it was loaded
+	void SetMovingCasters(bool bMovingCasters);
+
+	// start drawing the static casters into a map - false while the
+	// cached depth of the map is still valid
+	bool BeginStaticPass(SHADOW_MAP map);
+	// start drawing the moving casters over the static depth of a map -
+	// false while the map is still valid
+	bool BeginMovingPass(SHADOW_MAP map);
+	// finish the pass and restore the frame buffer and viewport
+	void EndPass();
+
+	// bind the finished maps to their texture units
+	void BindShadowMaps();
+
+	bool IsMapActive(SHADOW_MAP map) const { return m_maps[map].bActive; }
+	// world space to shadow map clip space
+	const glm::mat4& GetLightMatrix(SHADOW_MAP map) const { return m_maps[map].lightMatrix; }
+
+	// average GPU time of one render of a map in milliseconds
+	double GetAverageMs(SHADOW_MAP map) const { return m_maps[map].timer.GetAverageMs(); }
+	int GetSampleCount(SHADOW_MAP map) const { return m_maps[map].timer.GetSampleCount(); }
+	const SHADOW_STATS& GetStats(SHADOW_MAP map) const { return m_maps[map].stats; }
+	// count the frames the maps were reused and start the next frame
+	void EndFrame();
+	void ResetStats();
+
+private:
+	// one light and its depth textures
+	struct SHADOW_MAP_DATA
+	{
+		bool bActive;
+		glm::mat4 lightMatrix;
+		// depth of the static casters, and the static depth with the
+		// moving casters drawn over it
+		GLuint staticTexture;
+		GLuint staticFramebuffer;
+		GLuint movingTexture;
+		GLuint movingFramebuffer;
+		bool bStaticValid;
+		bool bMovingValid;
+		// a pass drew into the map this frame
+		bool bRendered;
+		GpuTimer timer;
+		SHADOW_STATS stats;
+	};
+
+	// OpenGL state cache shared with the scene shader manager
+	GLStateCache* m_pStateCache;
+	// depth-only program, sharing the state cache
+	ShaderManager* m_pShaderManager;
+	UniformHandle m_lightMatrixUniform;
+	SHADOW_MAP_DATA m_maps[SHADOW_MAP_COUNT];
+	bool m_bMovingCasters;
+	// map of the pass in progress, and the viewport it replaced
+	int m_passMap;
+	GLint m_savedViewport[4];
+
+	// create a depth texture and a frame buffer drawing into it
+	bool CreateDepthTarget(GLuint& texture, GLuint& framebuffer);
+	// bind a frame buffer and the depth-only program for a pass
+	void BeginPass(SHADOW_MAP map, GLuint framebuffer);
+	// set the light matrix of a map, invalidating it when it changed
+	void SetLightMatrix(SHADOW_MAP map, const glm::mat4& lightMatrix, bool bActive);
+	// true when part of the box is in view of the light of the map
+	bool IsBoxInView(SHADOW_MAP map, const glm::vec3& boxMin, const glm::vec3& boxMax) const;
+};
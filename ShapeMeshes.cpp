@@ -8,6 +8,8 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #include "ShapeMeshes.h"
+#include <algorithm>
+#include <cstddef>
 #include <vector>
 #include <cmath>
 
@@ -17,7 +19,254 @@ namespace
 }
 
 ShapeMeshes::ShapeMeshes() {}
-ShapeMeshes::~ShapeMeshes() {}
+ShapeMeshes::~ShapeMeshes() {
+    if (m_instanceVBO != 0) {
+        glDeleteBuffers(1, &m_instanceVBO);
+    }
+    if (m_indirectBuffer != 0) {
+        glDeleteBuffers(1, &m_indirectBuffer);
+    }
+    if (m_vertexBuffer != 0) {
+        glDeleteBuffers(1, &m_vertexBuffer);
+    }
+    if (m_vertexArray != 0) {
+        glDeleteVertexArrays(1, &m_vertexArray);
+    }
+}
+
+const char* const ShapeMeshes::kMeshNames[MESH_COUNT] = {
+    "plane",
+    "hollow_cylinder",
+    "torus",
+    "flat_sphere",
+    "wedge",
+    "box",
+    "cylinder",
+    "hemisphere",
+    "pentagonal_prism",
+};
+
+int ShapeMeshes::FindMeshType(const std::string& name) {
+    for (int i = 0; i < MESH_COUNT; ++i) {
+        if (name == kMeshNames[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void ShapeMeshes::DrawMesh(MeshType mesh) {
+    const MESH_RANGE& range = m_ranges[mesh];
+    BindVertexArray(m_vertexArray);
+    glDrawArrays(GL_TRIANGLES, range.first, range.count);
+}
+
+void ShapeMeshes::DrawMeshInstanced(MeshType mesh, int firstInstance, int instanceCount) {
+    const MESH_RANGE& range = m_ranges[mesh];
+    BindVertexArray(m_vertexArray);
+    if (GLEW_ARB_base_instance) {
+        glDrawArraysInstancedBaseInstance(GL_TRIANGLES, range.first, range.count,
+            instanceCount, static_cast<GLuint>(firstInstance));
+        return;
+    }
+
+    // Without base instance support the attributes are re-pointed instead.
+    if (m_instanceOffset != static_cast<size_t>(firstInstance)) {
+        SetInstanceAttributes(firstInstance);
+        m_instanceOffset = firstInstance;
+    }
+    glDrawArraysInstanced(GL_TRIANGLES, range.first, range.count, instanceCount);
+}
+
+ShapeMeshes::DRAW_COMMAND ShapeMeshes::GetDrawCommand(MeshType mesh, int firstInstance, int instanceCount) const {
+    DRAW_COMMAND command;
+    command.count = static_cast<GLuint>(m_ranges[mesh].count);
+    command.instanceCount = static_cast<GLuint>(instanceCount);
+    command.first = static_cast<GLuint>(m_ranges[mesh].first);
+    command.baseInstance = static_cast<GLuint>(firstInstance);
+    return command;
+}
+
+void ShapeMeshes::UploadDrawCommands(const DRAW_COMMAND* commands, size_t commandCount) {
+    m_drawCommands.assign(commands, commands + commandCount);
+    if (!GLEW_ARB_multi_draw_indirect || commandCount == 0) {
+        return;
+    }
+
+    if (m_indirectBuffer == 0) {
+        glGenBuffers(1, &m_indirectBuffer);
+    }
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+    if (commandCount > m_indirectCapacity) {
+        m_indirectCapacity = commandCount;
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, commandCount * sizeof(DRAW_COMMAND), commands, GL_STREAM_DRAW);
+    } else {
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, m_indirectCapacity * sizeof(DRAW_COMMAND), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, commandCount * sizeof(DRAW_COMMAND), commands);
+    }
+}
+
+// Every command picks its mesh range in the shared vertex buffer and its
+// instances through baseInstance, so meshes mix freely within one call.
+void ShapeMeshes::DrawMeshesIndirect(size_t firstCommand, size_t commandCount) {
+    if (commandCount == 0) {
+        return;
+    }
+
+    BindVertexArray(m_vertexArray);
+    if (GLEW_ARB_multi_draw_indirect) {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+        glMultiDrawArraysIndirect(GL_TRIANGLES, (const void*)(firstCommand * sizeof(DRAW_COMMAND)),
+            static_cast<GLsizei>(commandCount), 0);
+        return;
+    }
+
+    // Without multi-draw indirect the commands are issued one by one.
+    for (size_t i = firstCommand; i < firstCommand + commandCount; ++i) {
+        const DRAW_COMMAND& command = m_drawCommands[i];
+        if (GLEW_ARB_base_instance) {
+            glDrawArraysInstancedBaseInstance(GL_TRIANGLES, command.first, command.count,
+                command.instanceCount, command.baseInstance);
+            continue;
+        }
+        if (m_instanceOffset != command.baseInstance) {
+            SetInstanceAttributes(command.baseInstance);
+            m_instanceOffset = command.baseInstance;
+        }
+        glDrawArraysInstanced(GL_TRIANGLES, command.first, command.count, command.instanceCount);
+    }
+}
+
+void ShapeMeshes::UploadInstances(const INSTANCE_DATA* instances, size_t instanceCount) {
+    if (m_instanceVBO == 0 || instanceCount == 0) {
+        return;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+    if (instanceCount > m_instanceCapacity) {
+        m_instanceCapacity = instanceCount;
+        glBufferData(GL_ARRAY_BUFFER, instanceCount * sizeof(INSTANCE_DATA), instances, GL_STREAM_DRAW);
+    } else {
+        // Orphan the old storage so the upload does not wait for the GPU.
+        glBufferData(GL_ARRAY_BUFFER, m_instanceCapacity * sizeof(INSTANCE_DATA), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, instanceCount * sizeof(INSTANCE_DATA), instances);
+    }
+}
+
+const ShapeMeshes::MESH_BOUNDS& ShapeMeshes::GetMeshBounds(MeshType mesh) const {
+    return m_bounds[mesh];
+}
+
+const std::vector<glm::vec3>& ShapeMeshes::GetMeshPositions(MeshType mesh) const {
+    return m_positions[mesh];
+}
+
+void ShapeMeshes::SetStateCache(GLStateCache* pStateCache) {
+    m_pStateCache = pStateCache;
+}
+
+// Draw calls leave the shared VAO bound; the state cache skips the
+// rebind on every following draw.
+void ShapeMeshes::BindVertexArray(GLuint vertexArray) {
+    if (m_pStateCache) {
+        m_pStateCache->BindVertexArray(vertexArray);
+    } else {
+        glBindVertexArray(vertexArray);
+    }
+}
+
+// Local AABB, bounding sphere and CPU positions of a mesh from its
+// interleaved vertices (position, normal, UV). The sphere is centered on
+// the box, which is tight enough for the generated shapes.
+void ShapeMeshes::StoreMeshGeometry(MeshType mesh, const float* vertices, int vertexCount) {
+    MESH_BOUNDS& bounds = m_bounds[mesh];
+    std::vector<glm::vec3>& positions = m_positions[mesh];
+    positions.clear();
+    if (vertexCount <= 0) {
+        bounds = MESH_BOUNDS();
+        return;
+    }
+
+    positions.reserve(vertexCount);
+    for (int i = 0; i < vertexCount; ++i) {
+        positions.push_back(glm::vec3(vertices[i * 8], vertices[i * 8 + 1], vertices[i * 8 + 2]));
+    }
+
+    bounds.min = positions[0];
+    bounds.max = bounds.min;
+    for (const glm::vec3& position : positions) {
+        bounds.min = glm::min(bounds.min, position);
+        bounds.max = glm::max(bounds.max, position);
+    }
+
+    bounds.sphereCenter = (bounds.min + bounds.max) * 0.5f;
+    float radiusSquared = 0.0f;
+    for (const glm::vec3& position : positions) {
+        glm::vec3 offset = position - bounds.sphereCenter;
+        radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+    }
+    bounds.sphereRadius = std::sqrt(radiusSquared);
+}
+
+// Append a mesh to the shared vertex buffer and record its range. The
+// buffer is re-created with every mesh added, which only happens while
+// the meshes are generated at startup.
+void ShapeMeshes::AddMeshVertices(MeshType mesh, const float* vertices, int vertexCount) {
+    StoreMeshGeometry(mesh, vertices, vertexCount);
+
+    m_ranges[mesh].first = static_cast<GLint>(m_vertexData.size() / 8);
+    m_ranges[mesh].count = vertexCount;
+    m_vertexData.insert(m_vertexData.end(), vertices, vertices + vertexCount * 8);
+
+    bool bCreated = (m_vertexArray == 0);
+    if (bCreated) {
+        glGenVertexArrays(1, &m_vertexArray);
+        glGenBuffers(1, &m_vertexBuffer);
+    }
+    BindVertexArray(m_vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, m_vertexData.size() * sizeof(float), m_vertexData.data(), GL_STATIC_DRAW);
+    if (bCreated) {
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+        SetInstanceAttributes(0);
+    }
+    BindVertexArray(0);
+}
+
+// The VAO reads the model matrix (4 columns), color, UV scale, material
+// index and texture array layer of the instances from the instance buffer.
+void ShapeMeshes::SetInstanceAttributes(size_t firstInstance) {
+    if (m_instanceVBO == 0) {
+        glGenBuffers(1, &m_instanceVBO);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+
+    const GLsizei stride = sizeof(INSTANCE_DATA);
+    const size_t base = firstInstance * sizeof(INSTANCE_DATA);
+    for (int column = 0; column < 4; ++column) {
+        glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, stride,
+            (void*)(base + offsetof(INSTANCE_DATA, model) + column * sizeof(glm::vec4)));
+        glEnableVertexAttribArray(3 + column);
+        glVertexAttribDivisor(3 + column, 1);
+    }
+    glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(INSTANCE_DATA, color)));
+    glEnableVertexAttribArray(7);
+    glVertexAttribDivisor(7, 1);
+    glVertexAttribPointer(8, 2, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(INSTANCE_DATA, uvScale)));
+    glEnableVertexAttribArray(8);
+    glVertexAttribDivisor(8, 1);
+    glVertexAttribIPointer(9, 1, GL_UNSIGNED_INT, stride, (void*)(base + offsetof(INSTANCE_DATA, materialIndex)));
+    glEnableVertexAttribArray(9);
+    glVertexAttribDivisor(9, 1);
+    glVertexAttribIPointer(10, 1, GL_UNSIGNED_INT, stride, (void*)(base + offsetof(INSTANCE_DATA, textureLayer)));
+    glEnableVertexAttribArray(10);
+    glVertexAttribDivisor(10, 1);
+}
 
 void ShapeMeshes::LoadPlaneMesh() {
     // Simple quad for table top with normals and UVs
@@ -30,24 +279,11 @@ void ShapeMeshes::LoadPlaneMesh() {
          0.5f, 0.0f,  0.5f,    0.0f, 1.0f, 0.0f,  1.0f, 1.0f,
         -0.5f, 0.0f,  0.5f,    0.0f, 1.0f, 0.0f,  0.0f, 1.0f
     };
-    m_planeVertexCount = 6;
-    glGenVertexArrays(1, &m_planeVAO);
-    glGenBuffers(1, &m_planeVBO);
-    glBindVertexArray(m_planeVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_planeVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glBindVertexArray(0);
+    const int vertexCount = 6;
+    AddMeshVertices(MESH_PLANE, vertices, vertexCount);
 }
 void ShapeMeshes::DrawPlaneMesh() {
-    glBindVertexArray(m_planeVAO);
-    glDrawArrays(GL_TRIANGLES, 0, m_planeVertexCount);
-    glBindVertexArray(0);
+    DrawMesh(MESH_PLANE);
 }
 
 void ShapeMeshes::LoadHollowCylinderMesh() {
@@ -106,26 +342,12 @@ void ShapeMeshes::LoadHollowCylinderMesh() {
         vertices.insert(vertices.end(), { ip1x,  halfHeight, ip1z, in1.x, in1.y, in1.z, u1, 1.0f });
     }
 
-    m_hollowCylinderVertexCount = static_cast<int>(vertices.size() / 8);
-
-    glGenVertexArrays(1, &m_hollowCylinderVAO);
-    glGenBuffers(1, &m_hollowCylinderVBO);
-    glBindVertexArray(m_hollowCylinderVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_hollowCylinderVBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glBindVertexArray(0);
+    const int vertexCount = static_cast<int>(vertices.size() / 8);
+    AddMeshVertices(MESH_HOLLOW_CYLINDER, vertices.data(), vertexCount);
 }
 
 void ShapeMeshes::DrawHollowCylinderMesh() {
-    glBindVertexArray(m_hollowCylinderVAO);
-    glDrawArrays(GL_TRIANGLES, 0, m_hollowCylinderVertexCount);
-    glBindVertexArray(0);
+    DrawMesh(MESH_HOLLOW_CYLINDER);
 }
 
 void ShapeMeshes::LoadTorusMesh() {
@@ -179,26 +401,12 @@ void ShapeMeshes::LoadTorusMesh() {
         }
     }
 
-    m_torusVertexCount = static_cast<int>(vertices.size() / 8);
-
-    glGenVertexArrays(1, &m_torusVAO);
-    glGenBuffers(1, &m_torusVBO);
-    glBindVertexArray(m_torusVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_torusVBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glBindVertexArray(0);
+    const int vertexCount = static_cast<int>(vertices.size() / 8);
+    AddMeshVertices(MESH_TORUS, vertices.data(), vertexCount);
 }
 
 void ShapeMeshes::DrawTorusMesh() {
-    glBindVertexArray(m_torusVAO);
-    glDrawArrays(GL_TRIANGLES, 0, m_torusVertexCount);
-    glBindVertexArray(0);
+    DrawMesh(MESH_TORUS);
 }
 
 void ShapeMeshes::LoadFlatSphereMesh() {
@@ -246,26 +454,12 @@ void ShapeMeshes::LoadFlatSphereMesh() {
         }
     }
 
-    m_flatSphereVertexCount = static_cast<int>(vertices.size() / 8);
-
-    glGenVertexArrays(1, &m_flatSphereVAO);
-    glGenBuffers(1, &m_flatSphereVBO);
-    glBindVertexArray(m_flatSphereVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_flatSphereVBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glBindVertexArray(0);
+    const int vertexCount = static_cast<int>(vertices.size() / 8);
+    AddMeshVertices(MESH_FLAT_SPHERE, vertices.data(), vertexCount);
 }
 
 void ShapeMeshes::DrawFlatSphereMesh() {
-    glBindVertexArray(m_flatSphereVAO);
-    glDrawArrays(GL_TRIANGLES, 0, m_flatSphereVertexCount);
-    glBindVertexArray(0);
+    DrawMesh(MESH_FLAT_SPHERE);
 }
 
 void ShapeMeshes::LoadWedgeMesh() {
@@ -308,26 +502,12 @@ void ShapeMeshes::LoadWedgeMesh() {
          0.5f, 0.0f,  0.5f,   1.0f, 0.0f, 0.0f,  1.0f, 0.0f
     };
 
-    m_wedgeVertexCount = static_cast<int>(sizeof(vertices) / (8 * sizeof(float)));
-
-    glGenVertexArrays(1, &m_wedgeVAO);
-    glGenBuffers(1, &m_wedgeVBO);
-    glBindVertexArray(m_wedgeVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_wedgeVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glBindVertexArray(0);
+    const int vertexCount = static_cast<int>(sizeof(vertices) / (8 * sizeof(float)));
+    AddMeshVertices(MESH_WEDGE, vertices, vertexCount);
 }
 
 void ShapeMeshes::DrawWedgeMesh() {
-    glBindVertexArray(m_wedgeVAO);
-    glDrawArrays(GL_TRIANGLES, 0, m_wedgeVertexCount);
-    glBindVertexArray(0);
+    DrawMesh(MESH_WEDGE);
 }
 
 void ShapeMeshes::LoadBoxMesh() {
@@ -382,26 +562,12 @@ void ShapeMeshes::LoadBoxMesh() {
         -0.5f, -0.5f,  0.5f,   0.0f, -1.0f, 0.0f,  0.0f, 1.0f
     };
 
-    m_boxVertexCount = static_cast<int>(sizeof(vertices) / (8 * sizeof(float)));
-
-    glGenVertexArrays(1, &m_boxVAO);
-    glGenBuffers(1, &m_boxVBO);
-    glBindVertexArray(m_boxVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_boxVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glBindVertexArray(0);
+    const int vertexCount = static_cast<int>(sizeof(vertices) / (8 * sizeof(float)));
+    AddMeshVertices(MESH_BOX, vertices, vertexCount);
 }
 
 void ShapeMeshes::DrawBoxMesh() {
-    glBindVertexArray(m_boxVAO);
-    glDrawArrays(GL_TRIANGLES, 0, m_boxVertexCount);
-    glBindVertexArray(0);
+    DrawMesh(MESH_BOX);
 }
 
 void ShapeMeshes::LoadCylinderMesh() {
@@ -436,26 +602,12 @@ void ShapeMeshes::LoadCylinderMesh() {
         vertices.insert(vertices.end(), { -halfLength, y1, z1, n1.x, n1.y, n1.z, u1, 0.0f });
     }
 
-    m_cylinderVertexCount = static_cast<int>(vertices.size() / 8);
-
-    glGenVertexArrays(1, &m_cylinderVAO);
-    glGenBuffers(1, &m_cylinderVBO);
-    glBindVertexArray(m_cylinderVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_cylinderVBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glBindVertexArray(0);
+    const int vertexCount = static_cast<int>(vertices.size() / 8);
+    AddMeshVertices(MESH_CYLINDER, vertices.data(), vertexCount);
 }
 
 void ShapeMeshes::DrawCylinderMesh() {
-    glBindVertexArray(m_cylinderVAO);
-    glDrawArrays(GL_TRIANGLES, 0, m_cylinderVertexCount);
-    glBindVertexArray(0);
+    DrawMesh(MESH_CYLINDER);
 }
 
 void ShapeMeshes::LoadHemisphereMesh() {
@@ -503,26 +655,12 @@ void ShapeMeshes::LoadHemisphereMesh() {
         }
     }
 
-    m_hemisphereVertexCount = static_cast<int>(vertices.size() / 8);
-
-    glGenVertexArrays(1, &m_hemisphereVAO);
-    glGenBuffers(1, &m_hemisphereVBO);
-    glBindVertexArray(m_hemisphereVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_hemisphereVBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glBindVertexArray(0);
+    const int vertexCount = static_cast<int>(vertices.size() / 8);
+    AddMeshVertices(MESH_HEMISPHERE, vertices.data(), vertexCount);
 }
 
 void ShapeMeshes::DrawHemisphereMesh() {
-    glBindVertexArray(m_hemisphereVAO);
-    glDrawArrays(GL_TRIANGLES, 0, m_hemisphereVertexCount);
-    glBindVertexArray(0);
+    DrawMesh(MESH_HEMISPHERE);
 }
 
 void ShapeMeshes::LoadPentagonalPrismMesh() {
@@ -606,24 +744,10 @@ void ShapeMeshes::LoadPentagonalPrismMesh() {
         vertices.insert(vertices.end(), { p0.x, -halfHeight, p0.z, bottomNormal.x, bottomNormal.y, bottomNormal.z, u0, v0 });
     }
 
-    m_pentagonPrismVertexCount = static_cast<int>(vertices.size() / 8);
-
-    glGenVertexArrays(1, &m_pentagonPrismVAO);
-    glGenBuffers(1, &m_pentagonPrismVBO);
-    glBindVertexArray(m_pentagonPrismVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_pentagonPrismVBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glBindVertexArray(0);
+    const int vertexCount = static_cast<int>(vertices.size() / 8);
+    AddMeshVertices(MESH_PENTAGONAL_PRISM, vertices.data(), vertexCount);
 }
 
 void ShapeMeshes::DrawPentagonalPrismMesh() {
-    glBindVertexArray(m_pentagonPrismVAO);
-    glDrawArrays(GL_TRIANGLES, 0, m_pentagonPrismVertexCount);
-    glBindVertexArray(0);
+    DrawMesh(MESH_PENTAGONAL_PRISM);
 }
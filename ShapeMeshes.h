@@ -10,12 +10,84 @@
 #pragma once
 #include <GL/glew.h>
 #include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+#include "GLStateCache.h"
 
 class ShapeMeshes {
 public:
+    // Mesh identifiers for drawing meshes chosen at runtime (scene files).
+    enum MeshType {
+        MESH_PLANE,
+        MESH_HOLLOW_CYLINDER,
+        MESH_TORUS,
+        MESH_FLAT_SPHERE,
+        MESH_WEDGE,
+        MESH_BOX,
+        MESH_CYLINDER,
+        MESH_HEMISPHERE,
+        MESH_PENTAGONAL_PRISM,
+        MESH_COUNT
+    };
+
+    // Per-instance values read by the vertex shader (attributes 3-10).
+    struct INSTANCE_DATA {
+        glm::mat4 model;
+        glm::vec4 color;
+        glm::vec2 uvScale;
+        GLuint materialIndex;
+        // texture array layer, with the finest mip level streamed in
+        // so far in the high 16 bits
+        GLuint textureLayer;
+    };
+
+    // Arguments of one glMultiDrawArraysIndirect command, in the layout
+    // OpenGL reads from the indirect buffer.
+    struct DRAW_COMMAND {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint first;
+        GLuint baseInstance;
+    };
+
+    // Local bounds of a generated mesh, filled in by its Load*Mesh().
+    struct MESH_BOUNDS {
+        glm::vec3 min = glm::vec3(0.0f);
+        glm::vec3 max = glm::vec3(0.0f);
+        glm::vec3 sphereCenter = glm::vec3(0.0f);
+        float sphereRadius = 0.0f;
+    };
+
     ShapeMeshes();
     ~ShapeMeshes();
 
+    // Mesh type for a scene file name such as "box", or -1 when unknown.
+    static int FindMeshType(const std::string& name);
+    // Draw a loaded mesh by identifier, same as the matching Draw*Mesh().
+    void DrawMesh(MeshType mesh);
+    // Draw instanceCount copies of a mesh using the uploaded instances
+    // starting at firstInstance.
+    void DrawMeshInstanced(MeshType mesh, int firstInstance, int instanceCount);
+    // Replace the contents of the instance buffer shared by all meshes.
+    void UploadInstances(const INSTANCE_DATA* instances, size_t instanceCount);
+
+    // Command drawing instanceCount copies of a mesh from firstInstance.
+    DRAW_COMMAND GetDrawCommand(MeshType mesh, int firstInstance, int instanceCount) const;
+    // Replace the contents of the indirect command buffer.
+    void UploadDrawCommands(const DRAW_COMMAND* commands, size_t commandCount);
+    // Draw a range of the uploaded commands with one multi-draw call, or
+    // one call per command where multi-draw indirect is not supported.
+    void DrawMeshesIndirect(size_t firstCommand, size_t commandCount);
+
+    const MESH_BOUNDS& GetMeshBounds(MeshType mesh) const;
+    // CPU copy of the local vertex positions of a mesh, three per
+    // triangle in draw order - used for ray casts.
+    const std::vector<glm::vec3>& GetMeshPositions(MeshType mesh) const;
+
+    // route vertex array binds through the shared OpenGL state cache
+    void SetStateCache(GLStateCache* pStateCache);
+
     void LoadPlaneMesh();
     void DrawPlaneMesh();
 
@@ -44,36 +116,40 @@ public:
     void DrawPentagonalPrismMesh();
 
 private:
-    GLuint m_planeVAO = 0;
-    GLuint m_planeVBO = 0;
-    int m_planeVertexCount = 0;
-    GLuint m_hollowCylinderVAO = 0;
-    GLuint m_hollowCylinderVBO = 0;
-    GLuint m_torusVAO = 0;
-    GLuint m_torusVBO = 0;
-    GLuint m_flatSphereVAO = 0;
-    GLuint m_flatSphereVBO = 0;
-    int m_hollowCylinderVertexCount = 0;
-    int m_torusVertexCount = 0;
-    int m_flatSphereVertexCount = 0;
-
-    GLuint m_wedgeVAO = 0;
-    GLuint m_wedgeVBO = 0;
-    int m_wedgeVertexCount = 0;
-
-    GLuint m_boxVAO = 0;
-    GLuint m_boxVBO = 0;
-    int m_boxVertexCount = 0;
-
-    GLuint m_cylinderVAO = 0;
-    GLuint m_cylinderVBO = 0;
-    int m_cylinderVertexCount = 0;
-
-    GLuint m_hemisphereVAO = 0;
-    GLuint m_hemisphereVBO = 0;
-    int m_hemisphereVertexCount = 0;
-
-    GLuint m_pentagonPrismVAO = 0;
-    GLuint m_pentagonPrismVBO = 0;
-    int m_pentagonPrismVertexCount = 0;
+    void BindVertexArray(GLuint vertexArray);
+    void StoreMeshGeometry(MeshType mesh, const float* vertices, int vertexCount);
+    void AddMeshVertices(MeshType mesh, const float* vertices, int vertexCount);
+    // Point the instance attributes of the bound VAO at an instance.
+    void SetInstanceAttributes(size_t firstInstance);
+
+    // Scene file name of each MeshType.
+    static const char* const kMeshNames[MESH_COUNT];
+
+    // Vertices of a mesh within the shared vertex buffer.
+    struct MESH_RANGE {
+        GLint first = 0;
+        GLsizei count = 0;
+    };
+
+    GLStateCache* m_pStateCache = nullptr;
+
+    MESH_BOUNDS m_bounds[MESH_COUNT];
+    std::vector<glm::vec3> m_positions[MESH_COUNT];
+
+    // All meshes share one vertex buffer and one VAO.
+    GLuint m_vertexArray = 0;
+    GLuint m_vertexBuffer = 0;
+    std::vector<float> m_vertexData;
+    MESH_RANGE m_ranges[MESH_COUNT];
+
+    GLuint m_instanceVBO = 0;
+    size_t m_instanceCapacity = 0;
+    // First instance the instance attributes point at, only used without
+    // ARB_base_instance.
+    size_t m_instanceOffset = 0;
+
+    GLuint m_indirectBuffer = 0;
+    size_t m_indirectCapacity = 0;
+    // CPU copy of the commands for drivers without multi-draw indirect.
+    std::vector<DRAW_COMMAND> m_drawCommands;
 };
@@ -0,0 +1,688 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecache.cpp
+// ============
+// block compressed texture images with precomputed mipmaps, cached on disk
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureCache.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "stb_image.h"
+
+namespace
+{
+	// bump when the encoder output changes, so old cache files are rebuilt
+	const uint32_t CACHE_VERSION = 1;
+	// cache files are kept out of the watched asset directories
+	const char* const CACHE_PARENT_DIRECTORY = "cache";
+	const char* const CACHE_DIRECTORY = "cache/textures/";
+
+	// start of every cache file, followed by the mip levels from largest to smallest
+	struct CACHE_HEADER
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t sourceHash;
+		uint32_t format;
+		int32_t width;
+		int32_t height;
+		int32_t levels;
+	};
+
+	uint64_t HashBytes(uint64_t hash, const unsigned char* data, size_t size)
+	{
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= data[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	// create a directory, an existing one is not an error
+	void MakeDirectory(const std::string& directoryPath)
+	{
+#ifdef _WIN32
+		CreateDirectoryA(directoryPath.c_str(), NULL);
+#else
+		mkdir(directoryPath.c_str(), 0755);
+#endif
+	}
+
+	// 8 bit RGB to a 5:6:5 color
+	uint16_t To565(const float color[3])
+	{
+		int r = static_cast<int>(std::min(std::max(color[0], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+		int g = static_cast<int>(std::min(std::max(color[1], 0.0f), 255.0f) * 63.0f / 255.0f + 0.5f);
+		int b = static_cast<int>(std::min(std::max(color[2], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	// 5:6:5 color back to 8 bit RGB, the way the hardware expands it
+	void From565(uint16_t color, int rgb[3])
+	{
+		int r = (color >> 11) & 31;
+		int g = (color >> 5) & 63;
+		int b = color & 31;
+		rgb[0] = (r << 3) | (r >> 2);
+		rgb[1] = (g << 2) | (g >> 4);
+		rgb[2] = (b << 3) | (b >> 2);
+	}
+
+	/***********************************************************
+	 *  EncodeColorBlock()
+	 *
+	 *  Encode the colors of a 4x4 block as BC1.  The endpoints
+	 *  are the block colors furthest apart along the principal
+	 *  axis of the colors, moved slightly inwards, and every
+	 *  pixel gets the nearest of the four palette colors.
+	 ***********************************************************/
+	void EncodeColorBlock(const unsigned char pixels[16][4], unsigned char* pBlock)
+	{
+		float mean[3] = { 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < 16; ++i)
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				mean[c] += pixels[i][c] / 16.0f;
+			}
+		}
+
+		float covariance[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < 16; ++i)
+		{
+			float r = pixels[i][0] - mean[0];
+			float g = pixels[i][1] - mean[1];
+			float b = pixels[i][2] - mean[2];
+			covariance[0] += r * r;
+			covariance[1] += r * g;
+			covariance[2] += r * b;
+			covariance[3] += g * g;
+			covariance[4] += g * b;
+			covariance[5] += b * b;
+		}
+
+		// a few power iterations find the principal axis well enough
+		float axis[3] = { 1.0f, 1.0f, 1.0f };
+		for (int iteration = 0; iteration < 4; ++iteration)
+		{
+			float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+			float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+			float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+			float length = std::max(std::max(std::fabs(x), std::fabs(y)), std::fabs(z));
+			if (length <= 0.0f)
+			{
+				break;
+			}
+			axis[0] = x / length;
+			axis[1] = y / length;
+			axis[2] = z / length;
+		}
+
+		int minIndex = 0;
+		int maxIndex = 0;
+		float minProjection = FLT_MAX;
+		float maxProjection = -FLT_MAX;
+		for (int i = 0; i < 16; ++i)
+		{
+			float projection = pixels[i][0] * axis[0] + pixels[i][1] * axis[1] + pixels[i][2] * axis[2];
+			if (projection < minProjection)
+			{
+				minProjection = projection;
+				minIndex = i;
+			}
+			if (projection > maxProjection)
+			{
+				maxProjection = projection;
+				maxIndex = i;
+			}
+		}
+
+		float endpoints[2][3];
+		for (int c = 0; c < 3; ++c)
+		{
+			float inset = (pixels[maxIndex][c] - pixels[minIndex][c]) / 16.0f;
+			endpoints[0][c] = pixels[maxIndex][c] - inset;
+			endpoints[1][c] = pixels[minIndex][c] + inset;
+		}
+
+		uint16_t color0 = To565(endpoints[0]);
+		uint16_t color1 = To565(endpoints[1]);
+		// color0 above color1 selects the four color mode
+		if (color0 < color1)
+		{
+			std::swap(color0, color1);
+		}
+
+		uint32_t indices = 0;
+		if (color0 != color1)
+		{
+			int palette[4][3];
+			From565(color0, palette[0]);
+			From565(color1, palette[1]);
+			for (int c = 0; c < 3; ++c)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+
+			for (int i = 0; i < 16; ++i)
+			{
+				int bestIndex = 0;
+				int bestDistance = INT_MAX;
+				for (int p = 0; p < 4; ++p)
+				{
+					int dr = pixels[i][0] - palette[p][0];
+					int dg = pixels[i][1] - palette[p][1];
+					int db = pixels[i][2] - palette[p][2];
+					int distance = dr * dr + dg * dg + db * db;
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestIndex = p;
+					}
+				}
+				indices |= static_cast<uint32_t>(bestIndex) << (2 * i);
+			}
+		}
+
+		pBlock[0] = static_cast<unsigned char>(color0 & 0xff);
+		pBlock[1] = static_cast<unsigned char>(color0 >> 8);
+		pBlock[2] = static_cast<unsigned char>(color1 & 0xff);
+		pBlock[3] = static_cast<unsigned char>(color1 >> 8);
+		for (int i = 0; i < 4; ++i)
+		{
+			pBlock[4 + i] = static_cast<unsigned char>(indices >> (8 * i));
+		}
+	}
+
+	/***********************************************************
+	 *  EncodeAlphaBlock()
+	 *
+	 *  Encode the alpha values of a 4x4 block as the alpha half
+	 *  of a BC3 block, interpolating 8 values between the
+	 *  smallest and the largest alpha of the block.
+	 ***********************************************************/
+	void EncodeAlphaBlock(const unsigned char pixels[16][4], unsigned char* pBlock)
+	{
+		int alpha0 = 0;
+		int alpha1 = 255;
+		for (int i = 0; i < 16; ++i)
+		{
+			alpha0 = std::max(alpha0, static_cast<int>(pixels[i][3]));
+			alpha1 = std::min(alpha1, static_cast<int>(pixels[i][3]));
+		}
+
+		uint64_t indices = 0;
+		if (alpha0 != alpha1)
+		{
+			int palette[8];
+			palette[0] = alpha0;
+			palette[1] = alpha1;
+			for (int p = 2; p < 8; ++p)
+			{
+				palette[p] = ((8 - p) * alpha0 + (p - 1) * alpha1) / 7;
+			}
+
+			for (int i = 0; i < 16; ++i)
+			{
+				int bestIndex = 0;
+				int bestDistance = INT_MAX;
+				for (int p = 0; p < 8; ++p)
+				{
+					int distance = std::abs(pixels[i][3] - palette[p]);
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestIndex = p;
+					}
+				}
+				indices |= static_cast<uint64_t>(bestIndex) << (3 * i);
+			}
+		}
+
+		pBlock[0] = static_cast<unsigned char>(alpha0);
+		pBlock[1] = static_cast<unsigned char>(alpha1);
+		for (int i = 0; i < 6; ++i)
+		{
+			pBlock[2 + i] = static_cast<unsigned char>(indices >> (8 * i));
+		}
+	}
+
+	/***********************************************************
+	 *  EncodeLevel()
+	 *
+	 *  Encode one mip level, 4x4 pixels at a time.  Blocks that
+	 *  reach past the edge of the image repeat its last row and
+	 *  column.
+	 ***********************************************************/
+	void EncodeLevel(const unsigned char* image, int width, int height, int channels, GLenum format, unsigned char* pOutput)
+	{
+		size_t blockSize = (format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) ? 16 : 8;
+		unsigned char pixels[16][4];
+
+		for (int blockY = 0; blockY < height; blockY += 4)
+		{
+			for (int blockX = 0; blockX < width; blockX += 4)
+			{
+				for (int i = 0; i < 16; ++i)
+				{
+					int x = std::min(blockX + (i & 3), width - 1);
+					int y = std::min(blockY + (i >> 2), height - 1);
+					const unsigned char* pixel = image + (static_cast<size_t>(y) * width + x) * channels;
+					pixels[i][0] = pixel[0];
+					pixels[i][1] = pixel[1];
+					pixels[i][2] = pixel[2];
+					pixels[i][3] = (channels == 4) ? pixel[3] : 255;
+				}
+
+				if (blockSize == 16)
+				{
+					EncodeAlphaBlock(pixels, pOutput);
+					EncodeColorBlock(pixels, pOutput + 8);
+				}
+				else
+				{
+					EncodeColorBlock(pixels, pOutput);
+				}
+				pOutput += blockSize;
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  TextureCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureCache::TextureCache()
+{
+	m_pMapping = NULL;
+	m_mappingSize = 0;
+#ifdef _WIN32
+	m_fileHandle = INVALID_HANDLE_VALUE;
+	m_mappingHandle = NULL;
+#endif
+	m_format = GL_NONE;
+	m_width = 0;
+	m_height = 0;
+	m_bEncoded = false;
+}
+
+/***********************************************************
+ *  ~TextureCache()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureCache::~TextureCache()
+{
+	Close();
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  This method is used for checking that the driver can
+ *  sample BC1 and BC3 textures.
+ ***********************************************************/
+bool TextureCache::IsSupported()
+{
+	return GLEW_EXT_texture_compression_s3tc;
+}
+
+/***********************************************************
+ *  GetCompressedFormat()
+ *
+ *  This method is used for getting the compressed format of
+ *  images with the given number of color channels.
+ ***********************************************************/
+GLenum TextureCache::GetCompressedFormat(int colorChannels)
+{
+	return (colorChannels == 4) ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+}
+
+/***********************************************************
+ *  GetMipLevelCount()
+ *
+ *  This method is used for getting the number of levels of
+ *  a full mip chain.
+ ***********************************************************/
+int TextureCache::GetMipLevelCount(int width, int height)
+{
+	int levels = 1;
+	int size = std::max(width, height);
+	while (size > 1)
+	{
+		size /= 2;
+		++levels;
+	}
+	return levels;
+}
+
+/***********************************************************
+ *  GetLevelSize()
+ *
+ *  This method is used for getting the size of a compressed
+ *  level - 8 bytes (BC1) or 16 bytes (BC3) per 4x4 block.
+ ***********************************************************/
+size_t TextureCache::GetLevelSize(GLenum format, int width, int height)
+{
+	size_t blockSize = (format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) ? 16 : 8;
+	return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+}
+
+/***********************************************************
+ *  DownsampleImage()
+ *
+ *  This method is used for averaging each 2x2 pixel square
+ *  of an image into one pixel of the next smaller mip level.
+ ***********************************************************/
+void TextureCache::DownsampleImage(
+	const std::vector<unsigned char>& source, int width, int height, int channels,
+	std::vector<unsigned char>& destination, int& nextWidth, int& nextHeight)
+{
+	nextWidth = std::max(1, width / 2);
+	nextHeight = std::max(1, height / 2);
+	destination.resize(static_cast<size_t>(nextWidth) * nextHeight * channels);
+
+	for (int y = 0; y < nextHeight; ++y)
+	{
+		int y0 = std::min(2 * y, height - 1);
+		int y1 = std::min(2 * y + 1, height - 1);
+		for (int x = 0; x < nextWidth; ++x)
+		{
+			int x0 = std::min(2 * x, width - 1);
+			int x1 = std::min(2 * x + 1, width - 1);
+			for (int c = 0; c < channels; ++c)
+			{
+				int sum =
+					source[(static_cast<size_t>(y0) * width + x0) * channels + c] +
+					source[(static_cast<size_t>(y0) * width + x1) * channels + c] +
+					source[(static_cast<size_t>(y1) * width + x0) * channels + c] +
+					source[(static_cast<size_t>(y1) * width + x1) * channels + c];
+				destination[(static_cast<size_t>(y) * nextWidth + x) * channels + c] =
+					static_cast<unsigned char>((sum + 2) / 4);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used for opening the compressed form of an
+ *  image file.  The cache file is named after a hash of the
+ *  image file, so an edited image never matches the cache of
+ *  its previous version.  The cache directory is not watched
+ *  for changes, so encoding does not trigger a reload.
+ ***********************************************************/
+bool TextureCache::Open(const std::string& filename, int colorChannels)
+{
+	Close();
+	m_bEncoded = false;
+
+	std::ifstream file(filename, std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+	std::vector<unsigned char> source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	file.close();
+
+	GLenum format = GetCompressedFormat(colorChannels);
+	uint64_t sourceHash = HashBytes(14695981039346656037ull, source.data(), source.size());
+	uint32_t key[2] = { CACHE_VERSION, format };
+	sourceHash = HashBytes(sourceHash, reinterpret_cast<const unsigned char*>(key), sizeof(key));
+
+	std::ostringstream cachePath;
+	cachePath << CACHE_DIRECTORY << "texture_" << std::hex << sourceHash << ".bctex";
+
+	if (MapCacheFile(cachePath.str(), sourceHash, format))
+	{
+		return true;
+	}
+
+	if (!EncodeCacheFile(source, cachePath.str(), sourceHash, format))
+	{
+		return false;
+	}
+	m_bEncoded = true;
+	return MapCacheFile(cachePath.str(), sourceHash, format);
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used for unmapping the cache file.
+ ***********************************************************/
+void TextureCache::Close()
+{
+#ifdef _WIN32
+	if (m_pMapping != NULL)
+	{
+		UnmapViewOfFile(m_pMapping);
+	}
+	if (m_mappingHandle != NULL)
+	{
+		CloseHandle(m_mappingHandle);
+		m_mappingHandle = NULL;
+	}
+	if (m_fileHandle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_fileHandle);
+		m_fileHandle = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (m_pMapping != NULL)
+	{
+		munmap(const_cast<unsigned char*>(m_pMapping), m_mappingSize);
+	}
+#endif
+	m_pMapping = NULL;
+	m_mappingSize = 0;
+	m_levels.clear();
+}
+
+/***********************************************************
+ *  MapCacheFile()
+ *
+ *  This method is used for memory mapping a cache file and
+ *  finding its mip levels.  A file that is cut short or was
+ *  written for another image or encoder version is rejected.
+ ***********************************************************/
+bool TextureCache::MapCacheFile(const std::string& cachePath, uint64_t sourceHash, GLenum format)
+{
+#ifdef _WIN32
+	m_fileHandle = CreateFileA(cachePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (m_fileHandle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(m_fileHandle, &fileSize) || fileSize.QuadPart < static_cast<LONGLONG>(sizeof(CACHE_HEADER)))
+	{
+		Close();
+		return false;
+	}
+	m_mappingHandle = CreateFileMappingA(m_fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (m_mappingHandle == NULL)
+	{
+		Close();
+		return false;
+	}
+	m_pMapping = static_cast<const unsigned char*>(MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	m_mappingSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+	int fileDescriptor = open(cachePath.c_str(), O_RDONLY);
+	if (fileDescriptor < 0)
+	{
+		return false;
+	}
+	struct stat fileStat;
+	if (fstat(fileDescriptor, &fileStat) != 0 || fileStat.st_size < static_cast<off_t>(sizeof(CACHE_HEADER)))
+	{
+		close(fileDescriptor);
+		return false;
+	}
+	void* pMapping = mmap(NULL, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	// the mapping stays valid after the file is closed
+	close(fileDescriptor);
+	m_pMapping = (pMapping == MAP_FAILED) ? NULL : static_cast<const unsigned char*>(pMapping);
+	m_mappingSize = static_cast<size_t>(fileStat.st_size);
+#endif
+	if (m_pMapping == NULL)
+	{
+		Close();
+		return false;
+	}
+
+	CACHE_HEADER header;
+	memcpy(&header, m_pMapping, sizeof(header));
+	if (memcmp(header.magic, "BCTX", 4) != 0 ||
+		header.version != CACHE_VERSION ||
+		header.sourceHash != sourceHash ||
+		header.format != format ||
+		header.width <= 0 || header.height <= 0 ||
+		header.levels != GetMipLevelCount(header.width, header.height))
+	{
+		Close();
+		return false;
+	}
+
+	size_t offset = sizeof(CACHE_HEADER);
+	int width = header.width;
+	int height = header.height;
+	for (int level = 0; level < header.levels; ++level)
+	{
+		MIP_LEVEL mipLevel;
+		mipLevel.width = width;
+		mipLevel.height = height;
+		mipLevel.size = GetLevelSize(format, width, height);
+		mipLevel.pData = m_pMapping + offset;
+		offset += mipLevel.size;
+		if (offset > m_mappingSize)
+		{
+			Close();
+			return false;
+		}
+		m_levels.push_back(mipLevel);
+
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+	}
+
+	m_format = format;
+	m_width = header.width;
+	m_height = header.height;
+	return true;
+}
+
+/***********************************************************
+ *  EncodeCacheFile()
+ *
+ *  This method is used for decoding an image, building its
+ *  mip chain with a box filter and writing every level in
+ *  compressed form to the cache file.  The file is written
+ *  under a temporary name first, so an interrupted run never
+ *  leaves a partial cache file behind.
+ ***********************************************************/
+bool TextureCache::EncodeCacheFile(
+	const std::vector<unsigned char>& source,
+	const std::string& cachePath,
+	uint64_t sourceHash,
+	GLenum format)
+{
+	int channels = (format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) ? 4 : 3;
+	int width = 0;
+	int height = 0;
+	int fileChannels = 0;
+	unsigned char* image = stbi_load_from_memory(source.data(), static_cast<int>(source.size()),
+		&width, &height, &fileChannels, channels);
+	if (image == NULL)
+	{
+		return false;
+	}
+
+	CACHE_HEADER header;
+	memcpy(header.magic, "BCTX", 4);
+	header.version = CACHE_VERSION;
+	header.sourceHash = sourceHash;
+	header.format = format;
+	header.width = width;
+	header.height = height;
+	header.levels = GetMipLevelCount(width, height);
+
+	size_t fileSize = sizeof(CACHE_HEADER);
+	for (int level = 0, w = width, h = height; level < header.levels; ++level)
+	{
+		fileSize += GetLevelSize(format, w, h);
+		w = std::max(1, w / 2);
+		h = std::max(1, h / 2);
+	}
+
+	std::vector<unsigned char> output(fileSize);
+	memcpy(output.data(), &header, sizeof(header));
+
+	std::vector<unsigned char> levelImage(image, image + static_cast<size_t>(width) * height * channels);
+	stbi_image_free(image);
+	std::vector<unsigned char> nextImage;
+
+	size_t offset = sizeof(CACHE_HEADER);
+	for (int level = 0; level < header.levels; ++level)
+	{
+		EncodeLevel(levelImage.data(), width, height, channels, format, output.data() + offset);
+		offset += GetLevelSize(format, width, height);
+
+		if (level + 1 < header.levels)
+		{
+			DownsampleImage(levelImage, width, height, channels, nextImage, width, height);
+			levelImage.swap(nextImage);
+		}
+	}
+
+	MakeDirectory(CACHE_PARENT_DIRECTORY);
+	MakeDirectory(CACHE_DIRECTORY);
+
+	std::string temporaryPath = cachePath + ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!file.write(reinterpret_cast<const char*>(output.data()), output.size()))
+		{
+			std::cerr << "ERROR: Could not write texture cache file: " << cachePath << std::endl;
+			return false;
+		}
+	}
+	std::remove(cachePath.c_str());
+	if (std::rename(temporaryPath.c_str(), cachePath.c_str()) != 0)
+	{
+		std::cerr << "ERROR: Could not write texture cache file: " << cachePath << std::endl;
+		std::remove(temporaryPath.c_str());
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,97 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecache.h
+// ============
+// block compressed texture images with precomputed mipmaps, cached on disk
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  TextureCache
+ *
+ *  This class opens the compressed form of an image file.
+ *  The first time an image is opened it is decoded, its mip
+ *  chain is built on the CPU and every level is encoded to
+ *  BC1 (RGB) or BC3 (RGBA) and written to a cache file in
+ *  cache/textures/ named after the hash of the image file.
+ *  Later runs memory-map the cache file, so the image is
+ *  neither decoded nor compressed again.  The cache can be
+ *  opened on any thread; it makes no OpenGL calls.
+ ***********************************************************/
+class TextureCache
+{
+public:
+	// one mip level inside the mapped cache file
+	struct MIP_LEVEL
+	{
+		int width;
+		int height;
+		const unsigned char* pData;
+		size_t size;
+	};
+
+	// constructor
+	TextureCache();
+	// destructor
+	~TextureCache();
+
+	// open the cached image, encoding it first when the cache file is
+	// missing or was made from a different version of the image
+	bool Open(const std::string& filename, int colorChannels);
+	// unmap the cache file
+	void Close();
+
+	GLenum GetFormat() const { return m_format; }
+	int GetWidth() const { return m_width; }
+	int GetHeight() const { return m_height; }
+	const std::vector<MIP_LEVEL>& GetLevels() const { return m_levels; }
+	// true when the last Open() had to encode the image
+	bool WasEncoded() const { return m_bEncoded; }
+
+	// true when the driver can sample the compressed formats
+	static bool IsSupported();
+	// compressed format used for images with the channel count
+	static GLenum GetCompressedFormat(int colorChannels);
+	// number of levels in a full mip chain down to 1x1
+	static int GetMipLevelCount(int width, int height);
+	// size of one level of a compressed image in bytes
+	static size_t GetLevelSize(GLenum format, int width, int height);
+	// box filter an image down to the next mip level
+	static void DownsampleImage(
+		const std::vector<unsigned char>& source, int width, int height, int channels,
+		std::vector<unsigned char>& destination, int& nextWidth, int& nextHeight);
+
+private:
+	// the mapped cache file
+	const unsigned char* m_pMapping;
+	size_t m_mappingSize;
+#ifdef _WIN32
+	void* m_fileHandle;
+	void* m_mappingHandle;
+#endif
+
+	GLenum m_format;
+	int m_width;
+	int m_height;
+	std::vector<MIP_LEVEL> m_levels;
+	bool m_bEncoded;
+
+	// map the cache file and check it belongs to the image
+	bool MapCacheFile(const std::string& cachePath, uint64_t sourceHash, GLenum format);
+	// decode, mipmap and compress the image into a new cache file
+	static bool EncodeCacheFile(
+		const std::vector<unsigned char>& source,
+		const std::string& cachePath,
+		uint64_t sourceHash,
+		GLenum format);
+};
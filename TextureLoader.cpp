@@ -0,0 +1,725 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.cpp
+// ============
+// decode texture images on worker threads and stream their mip levels in
+// through pixel buffer objects
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureLoader.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <iostream>
+
+#include "stb_image.h"
+
+namespace
+{
+	// levels up to this size are uploaded as soon as they are decoded,
+	// outside the budget, so a layer never stays on its placeholder
+	const int TAIL_SIZE = 64;
+}
+
+/***********************************************************
+ *  TextureLoader()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureLoader::TextureLoader(int threadCount)
+{
+	m_decodedCount = 0;
+	// one decoded image more than there are workers keeps every
+	// worker busy while the oldest image is being uploaded
+	m_maxDecodedCount = static_cast<size_t>(std::max(threadCount, 0)) + 1;
+	m_encodedCount = 0;
+	m_bStopping = false;
+	m_stagingBuffer = 0;
+
+	for (int i = 0; i < threadCount; ++i)
+	{
+		m_workers.push_back(std::thread(&TextureLoader::WorkerLoop, this));
+	}
+}
+
+/***********************************************************
+ *  ~TextureLoader()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureLoader::~TextureLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStopping = true;
+	}
+	m_jobReady.notify_all();
+
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+
+	if (m_stagingBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_stagingBuffer);
+		m_stagingBuffer = 0;
+	}
+}
+
+/***********************************************************
+ *  GetDefaultThreadCount()
+ *
+ *  This method is used for getting the number of decoding
+ *  threads to use on this machine.
+ ***********************************************************/
+int TextureLoader::GetDefaultThreadCount()
+{
+	int threadCount = static_cast<int>(std::thread::hardware_concurrency()) - 1;
+	return (threadCount > 1) ? threadCount : 1;
+}
+
+/***********************************************************
+ *  AddLayer()
+ *
+ *  This method is used for adding a layer to be streamed in.
+ *  Its smallest mip level gets a grey placeholder texel, so
+ *  the layer can be sampled before its image is decoded.
+ ***********************************************************/
+int TextureLoader::AddLayer(const LAYER_REQUEST& request, GLStateCache* pStateCache)
+{
+	LAYER_STREAM layer;
+	layer.request = request;
+	layer.levelCount = TextureCache::GetMipLevelCount(request.width, request.height);
+	layer.residentLevel = layer.levelCount - 1;
+	layer.uploadLevel = layer.levelCount - 1;
+
+	pStateCache->BindTexture(request.textureUnit, GL_TEXTURE_2D_ARRAY, request.textureArray);
+	pStateCache->ActiveTexture(request.textureUnit);
+	if (request.compressedFormat != GL_NONE)
+	{
+		// BC3 alpha block of opaque texels, then a BC1 block of grey 0x8410
+		const unsigned char placeholder[16] = {
+			255, 255, 0, 0, 0, 0, 0, 0,
+			0x10, 0x84, 0x10, 0x84, 0, 0, 0, 0 };
+		bool bAlpha = (request.compressedFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT);
+		glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, layer.residentLevel, 0, 0, request.layer, 1, 1, 1,
+			request.compressedFormat, bAlpha ? 16 : 8, bAlpha ? placeholder : placeholder + 8);
+	}
+	else
+	{
+		const unsigned char placeholder[4] = { 128, 128, 128, 255 };
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, layer.residentLevel, 0, 0, request.layer, 1, 1, 1,
+			(request.colorChannels == 4) ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE, placeholder);
+	}
+
+	int index = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		index = static_cast<int>(m_layers.size());
+		m_layers.push_back(layer);
+	}
+	m_jobReady.notify_one();
+	return index;
+}
+
+/***********************************************************
+ *  ReloadLayer()
+ *
+ *  This method is used for queuing a layer to be decoded and
+ *  streamed again.  The current levels stay in use and are
+ *  replaced one by one as the new image streams in.
+ ***********************************************************/
+void TextureLoader::ReloadLayer(int layer)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		LAYER_STREAM& stream = m_layers[layer];
+		stream.bKeepLevels = false;
+		if (stream.state == LAYER_DECODING)
+		{
+			// the image being decoded may be the old one
+			stream.bReloadPending = true;
+		}
+		else if (stream.state == LAYER_STREAMING)
+		{
+			FinishLayer(stream);
+			stream.state = LAYER_QUEUED;
+		}
+		else
+		{
+			stream.state = LAYER_QUEUED;
+		}
+	}
+	m_jobReady.notify_all();
+}
+
+/***********************************************************
+ *  SetLayerVisible()
+ *
+ *  This method is used for flagging a layer that is used by
+ *  an object in view of the camera.
+ ***********************************************************/
+void TextureLoader::SetLayerVisible(int layer, bool bVisible)
+{
+	if (m_layers[layer].bVisible != bVisible)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_layers[layer].bVisible = bVisible;
+	}
+}
+
+/***********************************************************
+ *  SetLayerTexture()
+ *
+ *  This method is used for moving a layer to the array it
+ *  was copied into after the array was reallocated with a
+ *  different finest level.  Levels that were dropped are no
+ *  longer uploaded.  A layer that gained levels streams just
+ *  those in, decoding its image again if it was freed.
+ ***********************************************************/
+void TextureLoader::SetLayerTexture(int layer, GLuint textureArray, int baseLevel)
+{
+	bool bNotify = false;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		LAYER_STREAM& stream = m_layers[layer];
+		int oldBaseLevel = stream.baseLevel;
+		stream.request.textureArray = textureArray;
+		stream.baseLevel = baseLevel;
+		stream.residentLevel = std::max(stream.residentLevel, baseLevel);
+
+		if (baseLevel > oldBaseLevel)
+		{
+			// stop uploading a level that was dropped
+			if (stream.state == LAYER_STREAMING && stream.uploadLevel < baseLevel)
+			{
+				FinishLayer(stream);
+				bNotify = true;
+			}
+		}
+		else if (baseLevel < oldBaseLevel && stream.state == LAYER_DONE)
+		{
+			stream.bKeepLevels = true;
+			stream.state = LAYER_QUEUED;
+			bNotify = true;
+		}
+	}
+	if (bNotify)
+	{
+		m_jobReady.notify_all();
+	}
+}
+
+/***********************************************************
+ *  GetStreamingCount()
+ *
+ *  This method is used for counting the layers that are
+ *  still being decoded or streamed in.
+ ***********************************************************/
+size_t TextureLoader::GetStreamingCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	size_t streamingCount = 0;
+	for (const LAYER_STREAM& layer : m_layers)
+	{
+		if (layer.state != LAYER_DONE && layer.state != LAYER_FAILED)
+		{
+			++streamingCount;
+		}
+	}
+	return streamingCount;
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is used for decoding the queued layers on a
+ *  worker thread until the loader is destroyed.  A worker
+ *  waits while the limit of decoded images is reached.
+ ***********************************************************/
+void TextureLoader::WorkerLoop()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for (;;)
+	{
+		m_jobReady.wait(lock, [this]()
+			{
+				return m_bStopping || (m_decodedCount < m_maxDecodedCount && FindQueuedLayer() >= 0);
+			});
+		if (m_bStopping)
+		{
+			return;
+		}
+
+		DecodeQueuedLayer(lock);
+		m_layerDecoded.notify_all();
+		// a failed or requeued layer gave its slot back
+		m_jobReady.notify_one();
+	}
+}
+
+/***********************************************************
+ *  FindQueuedLayer()
+ *
+ *  This method is used for picking the next layer to decode,
+ *  the first queued layer in view or else the first queued.
+ ***********************************************************/
+int TextureLoader::FindQueuedLayer() const
+{
+	int queuedLayer = -1;
+	for (size_t i = 0; i < m_layers.size(); ++i)
+	{
+		if (m_layers[i].state != LAYER_QUEUED)
+		{
+			continue;
+		}
+		if (m_layers[i].bVisible)
+		{
+			return static_cast<int>(i);
+		}
+		if (queuedLayer < 0)
+		{
+			queuedLayer = static_cast<int>(i);
+		}
+	}
+	return queuedLayer;
+}
+
+/***********************************************************
+ *  DecodeQueuedLayer()
+ *
+ *  This method is used for decoding the next queued layer.
+ *  The mutex is released while the image is decoded.
+ ***********************************************************/
+void TextureLoader::DecodeQueuedLayer(std::unique_lock<std::mutex>& lock)
+{
+	int index = FindQueuedLayer();
+	m_layers[index].state = LAYER_DECODING;
+	LAYER_REQUEST request = m_layers[index].request;
+	++m_decodedCount;
+	lock.unlock();
+
+	std::shared_ptr<TextureCache> pCache;
+	std::vector<std::vector<unsigned char>> mipLevels;
+	bool bEncoded = false;
+	bool bSuccess = DecodeLayer(request, pCache, mipLevels, bEncoded);
+
+	lock.lock();
+	LAYER_STREAM& layer = m_layers[index];
+	if (layer.bReloadPending)
+	{
+		layer.bReloadPending = false;
+		layer.state = LAYER_QUEUED;
+		--m_decodedCount;
+	}
+	else if (!bSuccess)
+	{
+		layer.state = LAYER_FAILED;
+		layer.bReportPending = true;
+		--m_decodedCount;
+	}
+	else
+	{
+		layer.pCache = pCache;
+		layer.mipLevels.swap(mipLevels);
+		layer.bEncoded = bEncoded;
+		// a restored layer keeps the levels it already holds
+		layer.bReportPending = !layer.bKeepLevels;
+		layer.uploadLevel = layer.bKeepLevels ? layer.residentLevel - 1 : layer.levelCount - 1;
+		layer.uploadRow = 0;
+		layer.bKeepLevels = false;
+		layer.state = LAYER_STREAMING;
+		m_encodedCount += bEncoded ? 1 : 0;
+		if (layer.uploadLevel < layer.baseLevel)
+		{
+			// the levels were dropped again while it was decoded
+			FinishLayer(layer);
+		}
+	}
+}
+
+/***********************************************************
+ *  FinishLayer()
+ *
+ *  This method is used for freeing the decoded image of a
+ *  layer once there is nothing left of it to upload.
+ ***********************************************************/
+void TextureLoader::FinishLayer(LAYER_STREAM& layer)
+{
+	layer.pCache.reset();
+	layer.mipLevels.clear();
+	layer.state = LAYER_DONE;
+	--m_decodedCount;
+}
+
+/***********************************************************
+ *  DecodeLayer()
+ *
+ *  This method is used for decoding the image of a layer
+ *  with all of its mip levels.  Compressed layers map their
+ *  levels from the texture cache; uncompressed layers are
+ *  decoded and box filtered down to 1x1.
+ ***********************************************************/
+bool TextureLoader::DecodeLayer(
+	const LAYER_REQUEST& request,
+	std::shared_ptr<TextureCache>& pCache,
+	std::vector<std::vector<unsigned char>>& mipLevels,
+	bool& bEncoded)
+{
+	if (request.compressedFormat != GL_NONE)
+	{
+		pCache = std::make_shared<TextureCache>();
+		if (!pCache->Open(request.filename, request.colorChannels) ||
+			pCache->GetWidth() != request.width ||
+			pCache->GetHeight() != request.height ||
+			pCache->GetFormat() != request.compressedFormat)
+		{
+			pCache.reset();
+			return false;
+		}
+		bEncoded = pCache->WasEncoded();
+		return true;
+	}
+
+	int width = 0;
+	int height = 0;
+	int colorChannels = 0;
+	unsigned char* image = stbi_load(request.filename.c_str(), &width, &height, &colorChannels, 0);
+	if (image == NULL || width != request.width || height != request.height || colorChannels != request.colorChannels)
+	{
+		stbi_image_free(image);
+		return false;
+	}
+
+	int levelCount = TextureCache::GetMipLevelCount(width, height);
+	mipLevels.resize(levelCount);
+	mipLevels[0].assign(image, image + static_cast<size_t>(width) * height * colorChannels);
+	stbi_image_free(image);
+	for (int level = 1; level < levelCount; ++level)
+	{
+		TextureCache::DownsampleImage(mipLevels[level - 1], width, height, colorChannels, mipLevels[level], width, height);
+	}
+	return true;
+}
+
+/***********************************************************
+ *  ReportDecodedLayers()
+ *
+ *  This method is used for printing the layers the workers
+ *  decoded or failed to decode since the last frame.
+ ***********************************************************/
+void TextureLoader::ReportDecodedLayers()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (LAYER_STREAM& layer : m_layers)
+	{
+		if (!layer.bReportPending)
+		{
+			continue;
+		}
+		layer.bReportPending = false;
+
+		const LAYER_REQUEST& request = layer.request;
+		if (layer.state == LAYER_FAILED)
+		{
+			std::cout << "Could not load image:" << request.filename << std::endl;
+			continue;
+		}
+
+		std::cout << "Successfully loaded image:" << request.filename << ", width:" << request.width << ", height:" << request.height
+			<< ", channels:" << request.colorChannels << ", layer " << request.layer;
+		if (request.compressedFormat != GL_NONE)
+		{
+			std::cout << (layer.bEncoded ? ", compressed into the texture cache" : ", from the texture cache");
+		}
+		std::cout << std::endl;
+	}
+}
+
+/***********************************************************
+ *  GetRowHeight()
+ *
+ *  This method is used for getting the number of pixel rows
+ *  uploaded as one row - a row of 4x4 blocks when compressed.
+ ***********************************************************/
+int TextureLoader::GetRowHeight(const LAYER_REQUEST& request)
+{
+	return (request.compressedFormat != GL_NONE) ? 4 : 1;
+}
+
+/***********************************************************
+ *  GetRowSize()
+ *
+ *  This method is used for getting the bytes in one upload
+ *  row of a level with the given width.
+ ***********************************************************/
+size_t TextureLoader::GetRowSize(const LAYER_REQUEST& request, int width)
+{
+	if (request.compressedFormat != GL_NONE)
+	{
+		return TextureCache::GetLevelSize(request.compressedFormat, width, 1);
+	}
+	return static_cast<size_t>(width) * request.colorChannels;
+}
+
+/***********************************************************
+ *  GetLevelData()
+ *
+ *  This method is used for getting the pixels of a decoded
+ *  mip level of a layer.
+ ***********************************************************/
+const unsigned char* TextureLoader::GetLevelData(const LAYER_STREAM& layer, int level) const
+{
+	if (layer.pCache)
+	{
+		return layer.pCache->GetLevels()[level].pData;
+	}
+	return layer.mipLevels[level].data();
+}
+
+/***********************************************************
+ *  UploadBand()
+ *
+ *  This method is used for copying rows of a decoded level
+ *  into its layer of the bound texture array, whose level 0
+ *  is baseLevel of the image.  The pixels are read from the
+ *  bound pixel unpack buffer when pPixels is an offset into
+ *  it.
+ ***********************************************************/
+void TextureLoader::UploadBand(const LAYER_REQUEST& request, int level, int baseLevel, int firstRow, int rowCount, const void* pPixels)
+{
+	int width = std::max(1, request.width >> level);
+	int height = std::max(1, request.height >> level);
+	int rowHeight = GetRowHeight(request);
+	int y = firstRow * rowHeight;
+	int bandHeight = std::min(rowCount * rowHeight, height - y);
+
+	if (request.compressedFormat != GL_NONE)
+	{
+		GLsizei size = static_cast<GLsizei>(GetRowSize(request, width) * rowCount);
+		glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level - baseLevel, 0, y, request.layer,
+			width, bandHeight, 1, request.compressedFormat, size, pPixels);
+	}
+	else
+	{
+		GLenum pixelFormat = (request.colorChannels == 4) ? GL_RGBA : GL_RGB;
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level - baseLevel, 0, y, request.layer,
+			width, bandHeight, 1, pixelFormat, GL_UNSIGNED_BYTE, pPixels);
+	}
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for streaming the decoded layers in.
+ *  Layers in view come first, then the blurriest ones.  Each
+ *  layer uploads its levels from the smallest up, and the
+ *  rows that fit in the budget are copied into one staging
+ *  pixel buffer, so the driver copies them to the textures
+ *  without stalling the frame.  A level becomes visible once
+ *  all of its rows are uploaded.
+ ***********************************************************/
+bool TextureLoader::Update(size_t budgetBytes, GLStateCache* pStateCache)
+{
+	if (m_workers.empty())
+	{
+		// without workers one image is decoded per frame
+		std::unique_lock<std::mutex> lock(m_mutex);
+		if (m_decodedCount < m_maxDecodedCount && FindQueuedLayer() >= 0)
+		{
+			DecodeQueuedLayer(lock);
+		}
+	}
+	ReportDecodedLayers();
+
+	m_streamingLayers.clear();
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (size_t i = 0; i < m_layers.size(); ++i)
+		{
+			if (m_layers[i].state == LAYER_STREAMING)
+			{
+				m_streamingLayers.push_back(static_cast<int>(i));
+			}
+		}
+	}
+	if (m_streamingLayers.empty())
+	{
+		return false;
+	}
+
+	std::sort(m_streamingLayers.begin(), m_streamingLayers.end(), [this](int a, int b)
+		{
+			const LAYER_STREAM& layerA = m_layers[a];
+			const LAYER_STREAM& layerB = m_layers[b];
+			if (layerA.bVisible != layerB.bVisible)
+			{
+				return layerA.bVisible;
+			}
+			if (layerA.residentLevel != layerB.residentLevel)
+			{
+				return layerA.residentLevel > layerB.residentLevel;
+			}
+			return a < b;
+		});
+
+	// pick the rows to upload this frame
+	m_uploads.clear();
+	size_t stagingSize = 0;
+	for (int index : m_streamingLayers)
+	{
+		LAYER_STREAM& layer = m_layers[index];
+		const LAYER_REQUEST& request = layer.request;
+		int rowHeight = GetRowHeight(request);
+		while (layer.uploadLevel >= layer.baseLevel)
+		{
+			int width = std::max(1, request.width >> layer.uploadLevel);
+			int height = std::max(1, request.height >> layer.uploadLevel);
+			size_t rowSize = GetRowSize(request, width);
+			int rowCount = (height + rowHeight - 1) / rowHeight - layer.uploadRow;
+			if (budgetBytes > 0 && std::max(width, height) > TAIL_SIZE)
+			{
+				size_t remaining = (stagingSize < budgetBytes) ? budgetBytes - stagingSize : 0;
+				int affordableRows = static_cast<int>(std::min<size_t>(remaining / rowSize, INT_MAX));
+				// a budget smaller than one row still uploads a row per frame
+				if (affordableRows == 0 && stagingSize == 0)
+				{
+					affordableRows = 1;
+				}
+				rowCount = std::min(rowCount, affordableRows);
+			}
+			if (rowCount <= 0)
+			{
+				break;
+			}
+
+			LEVEL_UPLOAD upload;
+			upload.layer = index;
+			upload.level = layer.uploadLevel;
+			upload.firstRow = layer.uploadRow;
+			upload.rowCount = rowCount;
+			upload.sourceOffset = layer.uploadRow * rowSize;
+			upload.offset = stagingSize;
+			upload.size = rowCount * rowSize;
+			m_uploads.push_back(upload);
+			stagingSize += upload.size;
+
+			layer.uploadRow += rowCount;
+			if (layer.uploadRow * rowHeight < height)
+			{
+				break;
+			}
+			layer.uploadLevel--;
+			layer.uploadRow = 0;
+		}
+	}
+	if (m_uploads.empty())
+	{
+		return false;
+	}
+
+	// copy the rows into the staging buffer, orphaning last frame's
+	if (m_stagingBuffer == 0)
+	{
+		glGenBuffers(1, &m_stagingBuffer);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_stagingBuffer);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(stagingSize), NULL, GL_STREAM_DRAW);
+	unsigned char* pStaging = static_cast<unsigned char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0,
+		static_cast<GLsizeiptr>(stagingSize), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+	bool bStaged = (pStaging != NULL);
+	if (bStaged)
+	{
+		for (const LEVEL_UPLOAD& upload : m_uploads)
+		{
+			memcpy(pStaging + upload.offset, GetLevelData(m_layers[upload.layer], upload.level) + upload.sourceOffset, upload.size);
+		}
+		bStaged = (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE);
+	}
+	if (!bStaged)
+	{
+		// the buffer could not be written, upload from memory instead
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	// RGB rows are not padded to 4 bytes
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (const LEVEL_UPLOAD& upload : m_uploads)
+	{
+		const LAYER_STREAM& layer = m_layers[upload.layer];
+		pStateCache->BindTexture(layer.request.textureUnit, GL_TEXTURE_2D_ARRAY, layer.request.textureArray);
+		pStateCache->ActiveTexture(layer.request.textureUnit);
+		const void* pPixels = bStaged ?
+			reinterpret_cast<const void*>(upload.offset) :
+			static_cast<const void*>(GetLevelData(layer, upload.level) + upload.sourceOffset);
+		UploadBand(layer.request, upload.level, layer.baseLevel, upload.firstRow, upload.rowCount, pPixels);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	m_stats.uploadedBytes += stagingSize;
+
+	// sharpen the layers whose next level is complete, and free the
+	// images of the layers that are fully uploaded
+	bool bSharper = false;
+	bool bFreed = false;
+	for (int index : m_streamingLayers)
+	{
+		LAYER_STREAM& layer = m_layers[index];
+		int completeLevel = layer.uploadLevel + 1;
+		if (completeLevel < layer.residentLevel)
+		{
+			m_stats.uploadedLevels += layer.residentLevel - completeLevel;
+			layer.residentLevel = completeLevel;
+			bSharper = true;
+		}
+
+		if (layer.uploadLevel < layer.baseLevel)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			FinishLayer(layer);
+			bFreed = true;
+		}
+	}
+	if (bFreed)
+	{
+		m_jobReady.notify_all();
+	}
+	return bSharper;
+}
+
+/***********************************************************
+ *  Finish()
+ *
+ *  This method is used for loading every layer completely
+ *  before returning, without a budget.
+ ***********************************************************/
+void TextureLoader::Finish(GLStateCache* pStateCache)
+{
+	for (;;)
+	{
+		Update(0, pStateCache);
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		bool bStreaming = false;
+		bool bPending = false;
+		for (const LAYER_STREAM& layer : m_layers)
+		{
+			bStreaming = bStreaming || (layer.state == LAYER_STREAMING);
+			bPending = bPending || (layer.state == LAYER_QUEUED || layer.state == LAYER_DECODING);
+		}
+		if (!bStreaming && !bPending)
+		{
+			break;
+		}
+		if (!bStreaming && !m_workers.empty())
+		{
+			// wait for a worker to finish decoding an image
+			m_layerDecoded.wait(lock);
+		}
+	}
+	ReportDecodedLayers();
+}
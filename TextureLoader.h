@@ -0,0 +1,195 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.h
+// ============
+// decode texture images on worker threads and stream their mip levels in
+// through pixel buffer objects
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "GLStateCache.h"
+#include "TextureCache.h"
+
+/***********************************************************
+ *  TextureLoader
+ *
+ *  This class streams image files into texture array layers.
+ *  A new layer gets a placeholder texel right away and is
+ *  decoded by a pool of worker threads.  Every frame the
+ *  thread owning the OpenGL context uploads decoded mip
+ *  levels from the smallest up, through a pixel buffer and
+ *  within a byte budget, so the layers sharpen over a few
+ *  frames instead of stalling the first one.  Layers seen by
+ *  the camera go first.  Only a bounded number of decoded
+ *  images exist at a time - a layer frees its image once all
+ *  of its levels are uploaded.
+ ***********************************************************/
+class TextureLoader
+{
+public:
+	// one image file and the texture array layer it is loaded into
+	struct LAYER_REQUEST
+	{
+		std::string filename;
+		// the image must have this size and channel count
+		int width;
+		int height;
+		int colorChannels;
+		GLuint textureArray;
+		// unit the array is bound to while rendering
+		GLuint textureUnit;
+		int layer;
+		// BC1/BC3 format of a compressed array, GL_NONE for RGB8/RGBA8
+		GLenum compressedFormat;
+	};
+
+	// streaming counters, accumulated until ResetStats()
+	struct STREAM_STATS
+	{
+		size_t uploadedBytes = 0;
+		unsigned int uploadedLevels = 0;
+	};
+
+	// constructor - with no worker threads the images are decoded
+	// on the calling thread, one per Update()
+	explicit TextureLoader(int threadCount);
+	// destructor
+	~TextureLoader();
+
+	// one worker per core, leaving a core for the OpenGL thread
+	static int GetDefaultThreadCount();
+
+	// give a layer its placeholder and queue its image for decoding,
+	// returns the index the layer is referred to by afterwards
+	int AddLayer(const LAYER_REQUEST& request, GLStateCache* pStateCache);
+	// decode and stream the image of a layer again after it changed on disk
+	void ReloadLayer(int layer);
+	// layers seen by the camera are decoded and streamed first
+	void SetLayerVisible(int layer, bool bVisible);
+	// move a layer to a reallocated array whose level 0 is baseLevel of
+	// the image - levels it gained are decoded and streamed in again
+	void SetLayerTexture(int layer, GLuint textureArray, int baseLevel);
+
+	// upload decoded mip levels, about budgetBytes in total (0 is
+	// unlimited) - returns true when a layer gained a sharper level
+	bool Update(size_t budgetBytes, GLStateCache* pStateCache);
+	// wait for every layer to be decoded and fully uploaded
+	void Finish(GLStateCache* pStateCache);
+
+	// finest mip level of the image that can be sampled from the layer
+	int GetResidentLevel(int layer) const { return m_layers[layer].residentLevel; }
+	// layers still being decoded or streamed in
+	size_t GetStreamingCount() const;
+	size_t GetLayerCount() const { return m_layers.size(); }
+	// compressed layers that had to be encoded into the texture cache
+	size_t GetEncodedCount() const { return m_encodedCount; }
+
+	const STREAM_STATS& GetStats() const { return m_stats; }
+	void ResetStats() { m_stats = STREAM_STATS(); }
+
+private:
+	enum LAYER_STATE
+	{
+		// waiting for a worker
+		LAYER_QUEUED,
+		LAYER_DECODING,
+		// decoded, mip levels being uploaded
+		LAYER_STREAMING,
+		LAYER_DONE,
+		LAYER_FAILED
+	};
+
+	// one texture array layer and the progress of its upload
+	struct LAYER_STREAM
+	{
+		LAYER_REQUEST request;
+		LAYER_STATE state = LAYER_QUEUED;
+		bool bVisible = false;
+		// changed on disk again while it was being decoded
+		bool bReloadPending = false;
+		// decode result not yet reported on the console
+		bool bReportPending = false;
+		bool bEncoded = false;
+		// only stream the levels missing from the layer once decoded
+		bool bKeepLevels = false;
+		int levelCount = 1;
+		// finest level of the image the array holds, its level 0
+		int baseLevel = 0;
+		int residentLevel = 0;
+		// level being uploaded and the rows of it already uploaded
+		int uploadLevel = 0;
+		int uploadRow = 0;
+		// decoded mip levels - mapped from the texture cache when
+		// compressed, box filtered on the CPU otherwise
+		std::shared_ptr<TextureCache> pCache;
+		std::vector<std::vector<unsigned char>> mipLevels;
+	};
+
+	// one band of rows of a level staged for upload this frame
+	struct LEVEL_UPLOAD
+	{
+		int layer;
+		int level;
+		int firstRow;
+		int rowCount;
+		// offset of the band in the decoded level and in the staging buffer
+		size_t sourceOffset;
+		size_t offset;
+		size_t size;
+	};
+
+	std::vector<std::thread> m_workers;
+	mutable std::mutex m_mutex;
+	std::condition_variable m_jobReady;
+	std::condition_variable m_layerDecoded;
+	std::vector<LAYER_STREAM> m_layers;
+	// decoding and streaming layers, each holding a decoded image
+	size_t m_decodedCount;
+	size_t m_maxDecodedCount;
+	size_t m_encodedCount;
+	bool m_bStopping;
+
+	// pixel buffer the uploads of a frame are staged in
+	GLuint m_stagingBuffer;
+	std::vector<LEVEL_UPLOAD> m_uploads;
+	std::vector<int> m_streamingLayers;
+	STREAM_STATS m_stats;
+
+	// decode layers until the loader is destroyed
+	void WorkerLoop();
+	// next queued layer, visible ones first - called with the mutex held
+	int FindQueuedLayer() const;
+	// decode a queued layer and hand the result over to the layer
+	void DecodeQueuedLayer(std::unique_lock<std::mutex>& lock);
+	// decode the image of a layer, returns false when it fails
+	static bool DecodeLayer(
+		const LAYER_REQUEST& request,
+		std::shared_ptr<TextureCache>& pCache,
+		std::vector<std::vector<unsigned char>>& mipLevels,
+		bool& bEncoded);
+	// print the decode results the workers reported
+	void ReportDecodedLayers();
+	// pixel rows per upload row, 4 for the blocks of compressed levels
+	static int GetRowHeight(const LAYER_REQUEST& request);
+	static size_t GetRowSize(const LAYER_REQUEST& request, int width);
+	// pixels of a decoded level
+	const unsigned char* GetLevelData(const LAYER_STREAM& layer, int level) const;
+	// copy one band of rows of a level into the bound texture array,
+	// whose level 0 is baseLevel of the image
+	static void UploadBand(const LAYER_REQUEST& request, int level, int baseLevel, int firstRow, int rowCount, const void* pPixels);
+	// free the decoded image of a layer - called with the mutex held
+	void FinishLayer(LAYER_STREAM& layer);
+};
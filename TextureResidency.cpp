@@ -0,0 +1,277 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureresidency.cpp
+// ============
+// decide how many mip levels of each texture array stay in video memory
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureResidency.h"
+#include "TextureCache.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// arrays always keep their levels up to this size, so a texture
+	// never disappears and is sharp enough for the objects far away
+	const int EVICTED_SIZE = 64;
+	// frames an array has to need fewer levels before they are dropped,
+	// so turning the camera back and forth does not reallocate it
+	const int DROP_DELAY_FRAMES = 120;
+}
+
+/***********************************************************
+ *  TextureResidency()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureResidency::TextureResidency()
+{
+	m_budgetBytes = 0;
+	m_memoryBytes = 0;
+	m_peakMemoryBytes = 0;
+	m_droppedLevels = 0;
+	m_restoredLevels = 0;
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  This method is used for checking that texture levels can
+ *  be copied between arrays on the GPU (OpenGL 4.3).
+ ***********************************************************/
+bool TextureResidency::IsSupported()
+{
+	return GLEW_VERSION_4_3 || GLEW_ARB_copy_image;
+}
+
+/***********************************************************
+ *  AddArray()
+ *
+ *  This method is used for tracking a new texture array,
+ *  allocated with all of its mip levels.
+ ***********************************************************/
+int TextureResidency::AddArray(int width, int height, int layers, GLenum compressedFormat)
+{
+	ARRAY_RESIDENCY residency;
+	residency.width = width;
+	residency.height = height;
+	residency.layers = layers;
+	residency.compressedFormat = compressedFormat;
+	residency.evictedLevel = 0;
+	while (std::max(width >> residency.evictedLevel, height >> residency.evictedLevel) > EVICTED_SIZE)
+	{
+		residency.evictedLevel++;
+	}
+	residency.baseLevel = 0;
+	residency.neededLevel = residency.evictedLevel;
+	residency.targetLevel = 0;
+	residency.idleFrames = 0;
+
+	m_arrays.push_back(residency);
+	m_memoryBytes += GetArrayMemory(residency, 0);
+	m_peakMemoryBytes = std::max(m_peakMemoryBytes, m_memoryBytes);
+	return static_cast<int>(m_arrays.size()) - 1;
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for forgetting the tracked arrays
+ *  after they were deleted.
+ ***********************************************************/
+void TextureResidency::Clear()
+{
+	m_arrays.clear();
+	m_memoryBytes = 0;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for starting a new frame, in which
+ *  no array is needed until an object requests it.
+ ***********************************************************/
+void TextureResidency::BeginFrame()
+{
+	for (ARRAY_RESIDENCY& residency : m_arrays)
+	{
+		residency.neededLevel = residency.evictedLevel;
+	}
+}
+
+/***********************************************************
+ *  RequestLevel()
+ *
+ *  This method is used for estimating the mip level an
+ *  object in view samples its texture at.  Level 0 maps
+ *  one texel to a pixel; every level above halves the
+ *  texels, so the level is the log2 of the texels spread
+ *  over the object divided by the pixels it covers.  The
+ *  level is rounded down to stay on the sharp side.
+ ***********************************************************/
+void TextureResidency::RequestLevel(int arrayIndex, float screenPixels, float uvRepeats)
+{
+	ARRAY_RESIDENCY& residency = m_arrays[arrayIndex];
+	int level = 0;
+	if (screenPixels > 0.0f)
+	{
+		float texels = static_cast<float>(std::max(residency.width, residency.height)) * std::max(uvRepeats, 0.0f);
+		if (texels > screenPixels)
+		{
+			level = static_cast<int>(std::floor(std::log2(texels / screenPixels)));
+		}
+	}
+	residency.neededLevel = std::min(residency.neededLevel, std::min(level, residency.evictedLevel));
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for picking the finest level every
+ *  array should hold.  Missing levels are restored at once,
+ *  since the texture looks blurry until they are back, but
+ *  levels are only dropped once they went unused for a
+ *  while.  Over the budget, the arrays out of view drop to
+ *  their smallest levels first, then the array using the
+ *  most memory drops one level at a time until the arrays
+ *  fit or every array is at its smallest levels.
+ ***********************************************************/
+void TextureResidency::Update(std::vector<int>& changedArrays)
+{
+	changedArrays.clear();
+
+	size_t targetBytes = 0;
+	for (ARRAY_RESIDENCY& residency : m_arrays)
+	{
+		residency.targetLevel = residency.neededLevel;
+		if (residency.targetLevel > residency.baseLevel)
+		{
+			residency.idleFrames++;
+			if (residency.idleFrames < DROP_DELAY_FRAMES)
+			{
+				residency.targetLevel = residency.baseLevel;
+			}
+		}
+		else
+		{
+			residency.idleFrames = 0;
+		}
+		targetBytes += GetArrayMemory(residency, residency.targetLevel);
+	}
+
+	if (m_budgetBytes > 0 && targetBytes > m_budgetBytes)
+	{
+		for (ARRAY_RESIDENCY& residency : m_arrays)
+		{
+			if (residency.neededLevel == residency.evictedLevel && residency.targetLevel < residency.evictedLevel)
+			{
+				targetBytes -= GetArrayMemory(residency, residency.targetLevel) - GetArrayMemory(residency, residency.evictedLevel);
+				residency.targetLevel = residency.evictedLevel;
+			}
+		}
+	}
+	while (m_budgetBytes > 0 && targetBytes > m_budgetBytes)
+	{
+		ARRAY_RESIDENCY* pLargest = NULL;
+		size_t largestBytes = 0;
+		for (ARRAY_RESIDENCY& residency : m_arrays)
+		{
+			size_t arrayBytes = GetArrayMemory(residency, residency.targetLevel);
+			if (residency.targetLevel < residency.evictedLevel && arrayBytes > largestBytes)
+			{
+				pLargest = &residency;
+				largestBytes = arrayBytes;
+			}
+		}
+		if (NULL == pLargest)
+		{
+			break;
+		}
+		pLargest->targetLevel++;
+		targetBytes -= largestBytes - GetArrayMemory(*pLargest, pLargest->targetLevel);
+	}
+
+	for (size_t i = 0; i < m_arrays.size(); ++i)
+	{
+		if (m_arrays[i].targetLevel != m_arrays[i].baseLevel)
+		{
+			changedArrays.push_back(static_cast<int>(i));
+		}
+	}
+}
+
+/***********************************************************
+ *  SetBaseLevel()
+ *
+ *  This method is used for recording the levels an array
+ *  holds once it was reallocated.
+ ***********************************************************/
+void TextureResidency::SetBaseLevel(int arrayIndex, int baseLevel)
+{
+	ARRAY_RESIDENCY& residency = m_arrays[arrayIndex];
+	if (baseLevel > residency.baseLevel)
+	{
+		m_droppedLevels += baseLevel - residency.baseLevel;
+	}
+	else
+	{
+		m_restoredLevels += residency.baseLevel - baseLevel;
+	}
+	m_memoryBytes -= GetArrayMemory(residency, residency.baseLevel);
+	m_memoryBytes += GetArrayMemory(residency, baseLevel);
+	m_peakMemoryBytes = std::max(m_peakMemoryBytes, m_memoryBytes);
+	residency.baseLevel = baseLevel;
+	residency.idleFrames = 0;
+}
+
+/***********************************************************
+ *  GetFullMemoryBytes()
+ *
+ *  This method is used for getting the video memory all the
+ *  arrays would use with every level resident.
+ ***********************************************************/
+size_t TextureResidency::GetFullMemoryBytes() const
+{
+	size_t memoryBytes = 0;
+	for (const ARRAY_RESIDENCY& residency : m_arrays)
+	{
+		memoryBytes += GetArrayMemory(residency, 0);
+	}
+	return memoryBytes;
+}
+
+/***********************************************************
+ *  GetArrayMemory()
+ *
+ *  This method is used for getting the video memory of an
+ *  array holding the mip levels from baseLevel down to 1x1.
+ ***********************************************************/
+size_t TextureResidency::GetArrayMemory(int width, int height, int layers, GLenum compressedFormat, int baseLevel)
+{
+	size_t memoryBytes = 0;
+	int levelCount = TextureCache::GetMipLevelCount(width, height);
+	for (int level = baseLevel; level < levelCount; ++level)
+	{
+		int levelWidth = std::max(1, width >> level);
+		int levelHeight = std::max(1, height >> level);
+		if (compressedFormat != GL_NONE)
+		{
+			memoryBytes += TextureCache::GetLevelSize(compressedFormat, levelWidth, levelHeight) * layers;
+		}
+		else
+		{
+			// drivers store RGB8 texels in 4 bytes as well
+			memoryBytes += static_cast<size_t>(levelWidth) * levelHeight * 4 * layers;
+		}
+	}
+	return memoryBytes;
+}
+
+size_t TextureResidency::GetArrayMemory(const ARRAY_RESIDENCY& residency, int baseLevel)
+{
+	return GetArrayMemory(residency.width, residency.height, residency.layers, residency.compressedFormat, baseLevel);
+}
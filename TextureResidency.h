@@ -0,0 +1,106 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureresidency.h
+// ============
+// decide how many mip levels of each texture array stay in video memory
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  TextureResidency
+ *
+ *  This class picks the finest mip level each texture array
+ *  keeps in video memory.  Every frame the objects in view
+ *  report how many pixels they cover, which gives the level
+ *  the texture is actually sampled at.  Arrays that are only
+ *  seen from afar, or not at all, drop their top levels, and
+ *  get them back as soon as the camera comes closer.  When
+ *  the arrays need more than the memory budget, more levels
+ *  are dropped from the largest ones.  The class makes no
+ *  OpenGL calls - the caller reallocates the arrays and
+ *  reports the levels they hold with SetBaseLevel().
+ ***********************************************************/
+class TextureResidency
+{
+public:
+	// constructor
+	TextureResidency();
+
+	// true when the driver can copy the kept levels into a smaller or
+	// larger array, which is how arrays drop and restore levels
+	static bool IsSupported();
+
+	// video memory the arrays should stay under, 0 is unlimited
+	void SetBudget(size_t budgetBytes) { m_budgetBytes = budgetBytes; }
+	size_t GetBudget() const { return m_budgetBytes; }
+
+	// track a texture array holding all of its levels, returns its index
+	int AddArray(int width, int height, int layers, GLenum compressedFormat);
+	// forget all the arrays, the peak memory is kept
+	void Clear();
+
+	// start collecting the levels needed in a new frame
+	void BeginFrame();
+	// an object in view covers screenPixels pixels across and
+	// repeats the texture uvRepeats times over that distance
+	void RequestLevel(int arrayIndex, float screenPixels, float uvRepeats);
+	// pick the finest level each array should hold - fills the
+	// arrays that have to be reallocated
+	void Update(std::vector<int>& changedArrays);
+
+	// finest level the array holds and the one it should hold
+	int GetBaseLevel(int arrayIndex) const { return m_arrays[arrayIndex].baseLevel; }
+	int GetTargetLevel(int arrayIndex) const { return m_arrays[arrayIndex].targetLevel; }
+	// record the finest level the array holds after reallocating it
+	void SetBaseLevel(int arrayIndex, int baseLevel);
+
+	// video memory of the arrays now and the most they ever used
+	size_t GetMemoryBytes() const { return m_memoryBytes; }
+	size_t GetPeakMemoryBytes() const { return m_peakMemoryBytes; }
+	// video memory the arrays would use holding every level
+	size_t GetFullMemoryBytes() const;
+	// levels dropped and restored since the last ResetStats()
+	unsigned int GetDroppedLevels() const { return m_droppedLevels; }
+	unsigned int GetRestoredLevels() const { return m_restoredLevels; }
+	void ResetStats() { m_droppedLevels = 0; m_restoredLevels = 0; }
+
+	// video memory of an array holding the levels from baseLevel down
+	static size_t GetArrayMemory(int width, int height, int layers, GLenum compressedFormat, int baseLevel);
+
+private:
+	// one texture array and the levels it holds and needs
+	struct ARRAY_RESIDENCY
+	{
+		int width;
+		int height;
+		int layers;
+		GLenum compressedFormat;
+		// coarsest level an array is ever reduced to
+		int evictedLevel;
+		// finest level held, the finest requested this frame and
+		// the finest the array should hold
+		int baseLevel;
+		int neededLevel;
+		int targetLevel;
+		// frames in a row the array needed fewer levels than it holds
+		int idleFrames;
+	};
+
+	std::vector<ARRAY_RESIDENCY> m_arrays;
+	size_t m_budgetBytes;
+	size_t m_memoryBytes;
+	size_t m_peakMemoryBytes;
+	unsigned int m_droppedLevels;
+	unsigned int m_restoredLevels;
+
+	// video memory of an array holding the levels from baseLevel down
+	static size_t GetArrayMemory(const ARRAY_RESIDENCY& residency, int baseLevel);
+};
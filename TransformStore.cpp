@@ -0,0 +1,157 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformstore.cpp
+// ============
+// keep the model matrices of static objects instead of rebuilding them
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TransformStore.h"
+
+#include <cmath>
+
+/***********************************************************
+ *  ComposeModelMatrix()
+ *
+ *  This method is used for building a model matrix directly
+ *  from its values.  The columns of the Z * Y * X rotation
+ *  are written out and scaled in place, which replaces the
+ *  five matrices and four matrix products of the long form.
+ ***********************************************************/
+glm::mat4 TransformStore::ComposeModelMatrix(
+	const glm::vec3& scaleXYZ,
+	const glm::vec3& rotationDegrees,
+	const glm::vec3& positionXYZ)
+{
+	glm::vec3 radians = glm::radians(rotationDegrees);
+	float cx = std::cos(radians.x), sx = std::sin(radians.x);
+	float cy = std::cos(radians.y), sy = std::sin(radians.y);
+	float cz = std::cos(radians.z), sz = std::sin(radians.z);
+
+	glm::mat4 model(1.0f);
+	model[0] = glm::vec4(cz * cy, sz * cy, -sy, 0.0f) * scaleXYZ.x;
+	model[1] = glm::vec4(cz * sy * sx - sz * cx, sz * sy * sx + cz * cx, cy * sx, 0.0f) * scaleXYZ.y;
+	model[2] = glm::vec4(cz * sy * cx + sz * sx, sz * sy * cx - cz * sx, cy * cx, 0.0f) * scaleXYZ.z;
+	model[3] = glm::vec4(positionXYZ, 1.0f);
+	return model;
+}
+
+/***********************************************************
+ *  Add()
+ *
+ *  This method is used for adding a transform.  Its matrix
+ *  is computed by the next Update().
+ ***********************************************************/
+size_t TransformStore::Add(
+	const glm::vec3& scaleXYZ,
+	const glm::vec3& rotationDegrees,
+	const glm::vec3& positionXYZ)
+{
+	size_t index = m_positions.size();
+	m_scales.push_back(scaleXYZ);
+	m_rotations.push_back(rotationDegrees);
+	m_positions.push_back(positionXYZ);
+	m_modelMatrices.push_back(glm::mat4(1.0f));
+	m_dirty.push_back(0);
+	MarkDirty(index);
+	return index;
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all the transforms.
+ ***********************************************************/
+void TransformStore::Clear()
+{
+	m_scales.clear();
+	m_rotations.clear();
+	m_positions.clear();
+	m_modelMatrices.clear();
+	m_dirty.clear();
+	m_dirtyIndices.clear();
+	m_version++;
+}
+
+/***********************************************************
+ *  SetScale()
+ *
+ *  This method is used for changing the scale of a transform.
+ ***********************************************************/
+void TransformStore::SetScale(size_t index, const glm::vec3& scaleXYZ)
+{
+	if (m_scales[index] != scaleXYZ)
+	{
+		m_scales[index] = scaleXYZ;
+		MarkDirty(index);
+	}
+}
+
+/***********************************************************
+ *  SetRotation()
+ *
+ *  This method is used for changing the rotation of a
+ *  transform.
+ ***********************************************************/
+void TransformStore::SetRotation(size_t index, const glm::vec3& rotationDegrees)
+{
+	if (m_rotations[index] != rotationDegrees)
+	{
+		m_rotations[index] = rotationDegrees;
+		MarkDirty(index);
+	}
+}
+
+/***********************************************************
+ *  SetPosition()
+ *
+ *  This method is used for changing the position of a
+ *  transform.
+ ***********************************************************/
+void TransformStore::SetPosition(size_t index, const glm::vec3& positionXYZ)
+{
+	if (m_positions[index] != positionXYZ)
+	{
+		m_positions[index] = positionXYZ;
+		MarkDirty(index);
+	}
+}
+
+/***********************************************************
+ *  MarkDirty()
+ *
+ *  This method is used for queueing a transform for the next
+ *  Update(), once no matter how many values changed.
+ ***********************************************************/
+void TransformStore::MarkDirty(size_t index)
+{
+	if (m_dirty[index] == 0)
+	{
+		m_dirty[index] = 1;
+		m_dirtyIndices.push_back(static_cast<uint32_t>(index));
+	}
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for recomputing the model matrices of
+ *  the transforms changed since the last update.
+ ***********************************************************/
+size_t TransformStore::Update()
+{
+	size_t updated = m_dirtyIndices.size();
+	for (uint32_t index : m_dirtyIndices)
+	{
+		m_modelMatrices[index] = ComposeModelMatrix(m_scales[index], m_rotations[index], m_positions[index]);
+		m_dirty[index] = 0;
+	}
+	m_dirtyIndices.clear();
+
+	if (updated > 0)
+	{
+		m_version++;
+	}
+	return updated;
+}
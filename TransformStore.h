@@ -0,0 +1,74 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformstore.h
+// ============
+// keep the model matrices of static objects instead of rebuilding them
+//
+//  @updated by: Allan Torres
+//  @Version 1.0: 02/10/2026
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  TransformStore
+ *
+ *  This class stores the scale, rotation and position of
+ *  every object together with its model matrix.  A matrix is
+ *  only recomputed by Update() after one of its values was
+ *  changed, so static objects cost nothing per frame.
+ ***********************************************************/
+class TransformStore
+{
+public:
+	// build a model matrix from scale, rotation (degrees) and
+	// position - the same as translate * rotZ * rotY * rotX * scale
+	static glm::mat4 ComposeModelMatrix(
+		const glm::vec3& scaleXYZ,
+		const glm::vec3& rotationDegrees,
+		const glm::vec3& positionXYZ);
+
+	// add a transform and return its index
+	size_t Add(
+		const glm::vec3& scaleXYZ,
+		const glm::vec3& rotationDegrees,
+		const glm::vec3& positionXYZ);
+	// remove all the transforms
+	void Clear();
+	size_t GetCount() const { return m_positions.size(); }
+
+	// change the values of a transform, marking it dirty if they differ
+	void SetScale(size_t index, const glm::vec3& scaleXYZ);
+	void SetRotation(size_t index, const glm::vec3& rotationDegrees);
+	void SetPosition(size_t index, const glm::vec3& positionXYZ);
+
+	const glm::vec3& GetScale(size_t index) const { return m_scales[index]; }
+	const glm::vec3& GetRotation(size_t index) const { return m_rotations[index]; }
+	const glm::vec3& GetPosition(size_t index) const { return m_positions[index]; }
+
+	// transforms changed since the last Update(), in the order they changed
+	const std::vector<uint32_t>& GetDirtyIndices() const { return m_dirtyIndices; }
+	// recompute the matrices of the dirty transforms, returns their count
+	size_t Update();
+	// model matrix as of the last Update()
+	const glm::mat4& GetModelMatrix(size_t index) const { return m_modelMatrices[index]; }
+	// changes whenever Update() recomputed at least one matrix
+	uint32_t GetVersion() const { return m_version; }
+
+private:
+	std::vector<glm::vec3> m_scales;
+	std::vector<glm::vec3> m_rotations;
+	std::vector<glm::vec3> m_positions;
+	std::vector<glm::mat4> m_modelMatrices;
+	// dirty flag of each transform and the dirty indices in order
+	std::vector<unsigned char> m_dirty;
+	std::vector<uint32_t> m_dirtyIndices;
+	uint32_t m_version = 0;
+
+	void MarkDirty(size_t index);
+};
@@ -52,6 +52,11 @@ namespace
 	// a boolean to note that the TAB key has been pressed (cleared 
 	// after a release)
 	bool bTabPressed = false;
+
+	// cursor position of a left click waiting to be picked
+	bool bPickPending = false;
+	double gPickX = 0.0;
+	double gPickY = 0.0;
 }
 
 /***********************************************************
@@ -65,6 +70,14 @@ ViewManager::ViewManager(
 	// initialize the member variables
 	m_pShaderManager = pShaderManager;
 	m_pWindow = NULL;
+	m_viewMatrix = glm::mat4(1.0f);
+	m_projectionMatrix = glm::mat4(1.0f);
+	if (NULL != m_pShaderManager)
+	{
+		m_viewUniform = m_pShaderManager->GetUniformHandle(g_ViewName);
+		m_projectionUniform = m_pShaderManager->GetUniformHandle(g_ProjectionName);
+		m_viewPositionUniform = m_pShaderManager->GetUniformHandle("viewPosition");
+	}
 	g_pCamera = new Camera();
 	// default camera view parameters
 	g_pCamera->Position = glm::vec3(0.0f, 5.0f, 12.0f);
@@ -119,6 +132,8 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 
 	// this callback is used to receive mouse moving events
 	glfwSetCursorPosCallback(window, &ViewManager::Mouse_Position_Callback);
+	// this callback is used to receive mouse clicks for picking
+	glfwSetMouseButtonCallback(window, &ViewManager::Mouse_Button_Callback);
     // set scroll callback for camera speed adjustment
     glfwSetScrollCallback(window, [](GLFWwindow* window, double xoffset, double yoffset) {
         if (g_pCamera) {
@@ -129,8 +144,16 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
     });
 
 	// enable blending for supporting tranparent rendering
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	if (NULL != m_pShaderManager)
+	{
+		m_pShaderManager->GetStateCache()->Enable(GL_BLEND);
+		m_pShaderManager->GetStateCache()->BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	}
+	else
+	{
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	}
 
 	m_pWindow = window;
 
@@ -167,6 +190,23 @@ void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos,
 	g_pCamera->ProcessMouseMovement(xOffset, yOffset);
 }
 
+/***********************************************************
+ *  Mouse_Button_Callback()
+ *
+ *  This method is automatically called from GLFW whenever
+ *  a mouse button is pressed or released within the active
+ *  GLFW display window.  A left click is remembered until
+ *  the next GetPickRay() call.
+ ***********************************************************/
+void ViewManager::Mouse_Button_Callback(GLFWwindow* window, int button, int action, int mods)
+{
+	if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
+	{
+		glfwGetCursorPos(window, &gPickX, &gPickY);
+		bPickPending = true;
+	}
+}
+
 /***********************************************************
  *  ProcessKeyboardEvents()
  *
@@ -281,14 +321,70 @@ void ViewManager::PrepareSceneView()
         projection = glm::perspective(glm::radians(g_pCamera->Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
     }
 
+	// keep the matrices for culling and picking
+	m_viewMatrix = view;
+	m_projectionMatrix = projection;
+
     // if the shader manager object is valid
     if (NULL != m_pShaderManager)
 	{
 		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ViewName, view);
+		m_pShaderManager->setMat4Value(m_viewUniform, view);
 		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ProjectionName, projection);
+		m_pShaderManager->setMat4Value(m_projectionUniform, projection);
 		// set the view position of the camera into the shader for proper rendering
-		m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
+		m_pShaderManager->setVec3Value(m_viewPositionUniform, g_pCamera->Position);
 	}
-}
\ No newline at end of file
+}
+/***********************************************************
+ *  GetCameraPosition()
+ *
+ *  This method is used for getting the current position of
+ *  the camera in world space.
+ ***********************************************************/
+glm::vec3 ViewManager::GetCameraPosition() const
+{
+	return g_pCamera->Position;
+}
+
+/***********************************************************
+ *  GetPickRay()
+ *
+ *  This method is used for turning the cursor position of
+ *  the last left click into a world-space ray, by
+ *  unprojecting it onto the near and far planes with the
+ *  camera matrices of the current frame.
+ ***********************************************************/
+bool ViewManager::GetPickRay(glm::vec3& origin, glm::vec3& direction)
+{
+	if (!bPickPending || NULL == m_pWindow)
+	{
+		return false;
+	}
+	bPickPending = false;
+
+	int windowWidth = 0;
+	int windowHeight = 0;
+	glfwGetWindowSize(m_pWindow, &windowWidth, &windowHeight);
+	if (windowWidth <= 0 || windowHeight <= 0)
+	{
+		return false;
+	}
+
+	// while the cursor is disabled it drives the camera, so
+	// the click picks whatever is in the middle of the view
+	double cursorX = bCursorDisabled ? windowWidth * 0.5 : gPickX;
+	double cursorY = bCursorDisabled ? windowHeight * 0.5 : gPickY;
+
+	// window coordinates run top to bottom, normalized device
+	// coordinates bottom to top
+	float ndcX = static_cast<float>(2.0 * cursorX / windowWidth - 1.0);
+	float ndcY = static_cast<float>(1.0 - 2.0 * cursorY / windowHeight);
+
+	glm::mat4 inverseViewProjection = glm::inverse(m_projectionMatrix * m_viewMatrix);
+	glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+	glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+	origin = glm::vec3(nearPoint) / nearPoint.w;
+	direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - origin);
+	return true;
+}
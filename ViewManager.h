@@ -26,12 +26,21 @@ public:
 
 	// mouse position callback for mouse interaction with the 3D scene
 	static void Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos);
+	// mouse button callback for picking objects in the 3D scene
+	static void Mouse_Button_Callback(GLFWwindow* window, int button, int action, int mods);
 
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
 	// active OpenGL display window
 	GLFWwindow* m_pWindow;
+	// pre-resolved shader uniforms for the camera matrices
+	UniformHandle m_viewUniform;
+	UniformHandle m_projectionUniform;
+	UniformHandle m_viewPositionUniform;
+	// camera matrices of the current frame
+	glm::mat4 m_viewMatrix;
+	glm::mat4 m_projectionMatrix;
 
 	// process keyboard events for interaction with the 3D scene
 	void ProcessKeyboardEvents();
@@ -42,4 +51,13 @@ public:
 	
 	// prepare the conversion from 3D object display to 2D scene display
 	void PrepareSceneView();
+
+	// current position of the camera in world space
+	glm::vec3 GetCameraPosition() const;
+	// camera matrices set by the last PrepareSceneView()
+	const glm::mat4& GetViewMatrix() const { return m_viewMatrix; }
+	const glm::mat4& GetProjectionMatrix() const { return m_projectionMatrix; }
+	// world-space ray through the cursor of the last left click, if a click
+	// is waiting - the screen center is used while the cursor is disabled
+	bool GetPickRay(glm::vec3& origin, glm::vec3& direction);
 };
\ No newline at end of file
@@ -1,10 +1,35 @@
 #version 330 core
+#ifdef USE_STORAGE_BUFFERS
+#extension GL_ARB_shader_storage_buffer_object : require
+// the point lights are culled into clusters of the view frustum and read
+// from storage buffers (see LightClusters)
+#define USE_CLUSTERED_LIGHTS
+#endif
+// the G-buffer pass writes the surface of the pixel instead of its color,
+// and the deferred light pass shades it from there (see DeferredRenderer)
+#ifdef GBUFFER_PASS
+// albedo, and 1 in alpha when the surface is lit
+layout (location = 0) out vec4 gbufferAlbedoOutput;
+// world space normal, and the material index in w
+layout (location = 1) out vec4 gbufferNormalOutput;
+#else
 out vec4 fragmentColor;
+#endif
 
+#ifdef LIGHTING_PASS
+// rebuilt from the G-buffer depth for every pixel
+vec3 fragmentPosition;
+#else
 in vec3 fragmentPosition;
 in vec3 fragmentVertexNormal;
 in vec2 fragmentTextureCoordinate;
+in vec4 fragmentObjectColor;
+flat in uint fragmentMaterialIndex;
+flat in uint fragmentTextureLayer;
+#endif
 
+// std430 puts shininess in the last 4 bytes of the specular vec4, 32 bytes
+// per material - must match OBJECT_MATERIAL in SceneManager
 struct Material {
     vec3 diffuseColor;
     vec3 specularColor;
@@ -23,6 +48,8 @@ struct DirectionalLight {
 
 struct PointLight {
     vec3 position;
+    // distance the light fades out at, 0 reaches everything
+    float range;
     
     vec3 ambient;
     vec3 diffuse;
@@ -49,89 +76,216 @@ struct SpotLight {
 };
 
 #define TOTAL_POINT_LIGHTS 5
+// must match GRID_X/Y/Z in LightClusters
+#define CLUSTER_GRID_X 16
+#define CLUSTER_GRID_Y 9
+#define CLUSTER_GRID_Z 24
+// must match MAX_MATERIALS in SceneManager, only used without storage buffers
+#define MAX_MATERIALS 16
 
+// the application compiles one permutation per combination of features by
+// defining SHADER_PERMUTATION and the USE_* / POINT_LIGHT_COUNT values below;
+// without it the features are runtime uniforms (see ShaderManager)
+#ifdef SHADER_PERMUTATION
+const bool bUseTexture = (USE_TEXTURE != 0);
+const bool bUseLighting = (USE_LIGHTING != 0);
+#else
 uniform bool bUseTexture=false;
 uniform bool bUseLighting=false;
-uniform vec4 objectColor = vec4(1.0f);
+#endif
 uniform vec3 viewPosition;
-uniform DirectionalLight directionalLight;
-uniform PointLight pointLights[TOTAL_POINT_LIGHTS];
-uniform SpotLight spotLight;
-uniform Material material;
-uniform sampler2D objectTexture;
-uniform vec2 UVscale = vec2(1.0f, 1.0f);
+// all light sources share one std140 uniform block that the application
+// writes once and only updates when a light changes (see LightManager)
+layout (std140) uniform LightBlock
+{
+    DirectionalLight directionalLight;
+    PointLight pointLights[TOTAL_POINT_LIGHTS];
+    SpotLight spotLight;
+};
+// every scene material, the instance picks one by index - a storage buffer
+// written once when the scene is loaded, or a uniform array on drivers
+// without storage buffers (OpenGL 3.3)
+#ifdef USE_STORAGE_BUFFERS
+layout (std430) buffer MaterialBlock
+{
+    Material materials[];
+};
+#else
+uniform Material materials[MAX_MATERIALS];
+#endif
+#ifdef USE_CLUSTERED_LIGHTS
+// every active point light, and for each cluster the offset and count of
+// its lights in the light index list
+layout (std430) buffer PointLightBlock
+{
+    PointLight clusterPointLights[];
+};
+layout (std430) buffer ClusterBlock
+{
+    uvec2 clusters[];
+};
+layout (std430) buffer ClusterLightBlock
+{
+    uint clusterLightIndices[];
+};
+// tiles per pixel, the camera forward direction and the scale and bias
+// turning the log of the view depth into a depth slice
+uniform vec2 clusterTileScale;
+uniform vec3 clusterViewDirection;
+uniform vec2 clusterDepthSlice;
+#endif
+// textures of the same size share an array, the instance picks the layer
+uniform sampler2DArray objectTexture;
+// shadow maps of the directional and spot lights, compared in hardware and
+// only rendered again when a light or a caster moves (see ShadowManager)
+uniform sampler2DShadow directionalShadowMap;
+uniform sampler2DShadow spotShadowMap;
+uniform mat4 directionalShadowMatrix;
+uniform mat4 spotShadowMatrix;
+uniform bool bDirectionalShadow=false;
+uniform bool bSpotShadow=false;
+#ifdef LIGHTING_PASS
+uniform sampler2D gbufferAlbedo;
+uniform sampler2D gbufferNormal;
+uniform sampler2D gbufferDepth;
+// window depth back to world space
+uniform mat4 inverseViewProjection;
+#endif
 
-// the scaled texture coordinate to use in calculations
-vec2 fragmentTextureCoordinateScaled = fragmentTextureCoordinate * UVscale;
+// material of the instance being shaded
+Material material;
 
 // function prototypes
-vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir);
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
-vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+vec3 CalcLighting(vec3 normal, vec3 albedo);
+vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir, vec3 albedo);
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo);
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo);
+float CalcShadow(sampler2DShadow shadowMap, mat4 shadowMatrix, vec3 normal, vec3 lightDir, float bias);
+#ifdef USE_CLUSTERED_LIGHTS
+vec3 CalcClusterPointLights(vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo);
+#endif
 
 void main()
-{   
+{
+#ifdef LIGHTING_PASS
+    // pixels no object was drawn over keep the clear color
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gbufferDepth, pixel, 0).r;
+    if(depth >= 1.0)
+    {
+        discard;
+    }
+    vec4 albedo = texelFetch(gbufferAlbedo, pixel, 0);
+    vec4 normalMaterial = texelFetch(gbufferNormal, pixel, 0);
+    vec3 windowPosition = vec3(gl_FragCoord.xy / vec2(textureSize(gbufferDepth, 0)), depth);
+    vec4 worldPosition = inverseViewProjection * vec4(windowPosition * 2.0 - 1.0, 1.0);
+    fragmentPosition = worldPosition.xyz / worldPosition.w;
+    // the transparent objects drawn after the light pass test against it
+    gl_FragDepth = depth;
+
+    if(albedo.a > 0.5)
+    {
+        material = materials[uint(normalMaterial.w + 0.5)];
+        fragmentColor = vec4(CalcLighting(normalize(normalMaterial.xyz), albedo.rgb), 1.0);
+    }
+    else
+    {
+        fragmentColor = vec4(albedo.rgb, 1.0);
+    }
+#else
+    material = materials[fragmentMaterialIndex];
+
+    // the surface color is fetched once and shared by every light term
+    vec4 albedo = fragmentObjectColor;
+    if(bUseTexture == true)
+    {
+        // the layer is in the low 16 bits and the finest mip level streamed
+        // in so far in the high bits - the level is picked as the hardware
+        // would, but never finer than that
+        float layer = float(fragmentTextureLayer & 0xFFFFu);
+        float minLevel = float(fragmentTextureLayer >> 16);
+        vec2 texelCoordinate = fragmentTextureCoordinate * vec2(textureSize(objectTexture, 0).xy);
+        vec2 dx = dFdx(texelCoordinate);
+        vec2 dy = dFdy(texelCoordinate);
+        float level = 0.5 * log2(max(dot(dx, dx), dot(dy, dy)));
+        albedo = textureLod(objectTexture, vec3(fragmentTextureCoordinate, layer), max(level, minLevel));
+    }
+
+#ifdef GBUFFER_PASS
+    gbufferAlbedoOutput = vec4(albedo.rgb, (bUseLighting == true) ? 1.0 : 0.0);
+    gbufferNormalOutput = vec4(normalize(fragmentVertexNormal), float(fragmentMaterialIndex));
+#else
     if(bUseLighting == true)
     {
-        vec3 phongResult = vec3(0.0f);
-        // properties
-        vec3 norm = normalize(fragmentVertexNormal);
-        vec3 viewDir = normalize(viewPosition - fragmentPosition);
-    
-        // == =====================================================
-        // Our lighting is set up in 3 phases: directional, point lights and an optional flashlight
-        // For each phase, a calculate function is defined that calculates the corresponding color
-        // per light source. In the main() function we take all the calculated colors and sum them 
-        // up for this fragment's final color.
-        // == =====================================================
-        // phase 1: directional lighting
-        if(directionalLight.bActive == true)
-        {
-            phongResult += CalcDirectionalLight(directionalLight, norm, viewDir);
-        }
-        // phase 2: point lights
-        for(int i = 0; i < TOTAL_POINT_LIGHTS; i++)
-        {
-	    if(pointLights[i].bActive == true)
-            {
-                phongResult += CalcPointLight(pointLights[i], norm, fragmentPosition, viewDir);   
-            }
-        } 
-        // phase 3: spot light
-        if(spotLight.bActive == true)
-        {
-            phongResult += CalcSpotLight(spotLight, norm, fragmentPosition, viewDir);    
-        }
-    
-        if(bUseTexture == true)
-        {
-            fragmentColor = vec4(phongResult, (texture(objectTexture, fragmentTextureCoordinateScaled)).a);
-        }
-        else
-        {
-            fragmentColor = vec4(phongResult, objectColor.a);
-        }
+        fragmentColor = vec4(CalcLighting(normalize(fragmentVertexNormal), albedo.rgb), albedo.a);
     }
     else
     {
-        if(bUseTexture == true)
-        {
-            fragmentColor = texture(objectTexture, fragmentTextureCoordinateScaled);
-        }
-        else
+        fragmentColor = albedo;
+    }
+#endif
+#endif
+}
+
+// calculates the color of a lit surface, summed over every light source.
+vec3 CalcLighting(vec3 normal, vec3 albedo)
+{
+    vec3 phongResult = vec3(0.0f);
+    vec3 viewDir = normalize(viewPosition - fragmentPosition);
+
+    // == =====================================================
+    // Our lighting is set up in 3 phases: directional, point lights and an optional flashlight
+    // For each phase, a calculate function is defined that calculates the corresponding color
+    // per light source. We take all the calculated colors and sum them up for this fragment's
+    // final color.
+    // == =====================================================
+#ifdef SHADER_PERMUTATION
+    // the active lights are known up front - active point lights are packed first
+#if USE_DIRECTIONAL_LIGHT
+    phongResult += CalcDirectionalLight(directionalLight, normal, viewDir, albedo);
+#endif
+#ifdef USE_CLUSTERED_LIGHTS
+    phongResult += CalcClusterPointLights(normal, fragmentPosition, viewDir, albedo);
+#else
+    for(int i = 0; i < POINT_LIGHT_COUNT; i++)
+    {
+        phongResult += CalcPointLight(pointLights[i], normal, fragmentPosition, viewDir, albedo);
+    }
+#endif
+#if USE_SPOT_LIGHT
+    phongResult += CalcSpotLight(spotLight, normal, fragmentPosition, viewDir, albedo);
+#endif
+#else
+    // phase 1: directional lighting
+    if(directionalLight.bActive == true)
+    {
+        phongResult += CalcDirectionalLight(directionalLight, normal, viewDir, albedo);
+    }
+    // phase 2: point lights
+#ifdef USE_CLUSTERED_LIGHTS
+    phongResult += CalcClusterPointLights(normal, fragmentPosition, viewDir, albedo);
+#else
+    for(int i = 0; i < TOTAL_POINT_LIGHTS; i++)
+    {
+        if(pointLights[i].bActive == true)
         {
-            fragmentColor = objectColor;
+            phongResult += CalcPointLight(pointLights[i], normal, fragmentPosition, viewDir, albedo);
         }
     }
+#endif
+    // phase 3: spot light
+    if(spotLight.bActive == true)
+    {
+        phongResult += CalcSpotLight(spotLight, normal, fragmentPosition, viewDir, albedo);
+    }
+#endif
+
+    return phongResult;
 }
 
 // calculates the color when using a directional light.
-vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir)
+vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir, vec3 albedo)
 {
-    vec3 ambient = vec3(0.0f);
-    vec3 diffuse = vec3(0.0f);
-    vec3 specular = vec3(0.0f);
-
     vec3 lightDirection = normalize(-light.direction);
     // diffuse shading
     float diff = max(dot(normal, lightDirection), 0.0);
@@ -139,29 +293,22 @@ vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir)
     vec3 reflectDir = reflect(-lightDirection, normal);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
     // combine results
-    if(bUseTexture == true)
+    vec3 ambient = light.ambient * albedo;
+    vec3 diffuse = light.diffuse * diff * material.diffuseColor * albedo;
+    vec3 specular = light.specular * spec * material.specularColor * albedo;
+    // the ambient term lights the shadowed side as well
+    float shadow = 1.0;
+    if(bDirectionalShadow == true)
     {
-        ambient = light.ambient * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-        specular = light.specular * spec * material.specularColor * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-    }
-    else
-    {
-        ambient = light.ambient * vec3(objectColor);
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(objectColor);
-        specular = light.specular * spec * material.specularColor * vec3(objectColor);
+        shadow = CalcShadow(directionalShadowMap, directionalShadowMatrix, normal, lightDirection, 0.002);
     }
     
-    return (ambient + diffuse + specular);
+    return (ambient + shadow * (diffuse + specular));
 }
 
 // calculates the color when using a point light.
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo)
 {
-    vec3 ambient = vec3(0.0f);
-    vec3 diffuse = vec3(0.0f);
-    vec3 specular= vec3(0.0f);
-
     vec3 lightDir = normalize(light.position - fragPos);
     // diffuse shading
     float diff = max(dot(normal, lightDir), 0.0);
@@ -170,30 +317,45 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     // Calculate specular component
     float specularComponent = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
    
-    // combine results
-    if(bUseTexture == true)
+    // lights with a range fade out smoothly to nothing at the range
+    float attenuation = 1.0;
+    if(light.range > 0.0)
     {
-        ambient = light.ambient * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-        specular = light.specular * specularComponent * material.specularColor;
+        float ratio = length(light.position - fragPos) / light.range;
+        float window = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+        attenuation = window * window;
     }
-    else
+   
+    // combine results - the point light highlight is not tinted by the surface
+    vec3 ambient = light.ambient * albedo;
+    vec3 diffuse = light.diffuse * diff * material.diffuseColor * albedo;
+    vec3 specular = light.specular * specularComponent * material.specularColor;
+    
+    return (ambient + diffuse + specular) * attenuation;
+}
+
+#ifdef USE_CLUSTERED_LIGHTS
+// calculates the color of the point lights listed for the cluster of the
+// fragment - the tile under its pixel and the slice of its view depth
+vec3 CalcClusterPointLights(vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo)
+{
+    ivec2 tile = clamp(ivec2(gl_FragCoord.xy * clusterTileScale), ivec2(0), ivec2(CLUSTER_GRID_X - 1, CLUSTER_GRID_Y - 1));
+    float depth = max(dot(fragPos - viewPosition, clusterViewDirection), 1e-4);
+    int slice = clamp(int(floor(log(depth) * clusterDepthSlice.x + clusterDepthSlice.y)), 0, CLUSTER_GRID_Z - 1);
+    uvec2 cluster = clusters[tile.x + CLUSTER_GRID_X * (tile.y + CLUSTER_GRID_Y * slice)];
+
+    vec3 result = vec3(0.0);
+    for(uint i = 0u; i < cluster.y; i++)
     {
-        ambient = light.ambient * vec3(objectColor);
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(objectColor);
-        specular = light.specular * specularComponent * material.specularColor;
+        result += CalcPointLight(clusterPointLights[clusterLightIndices[cluster.x + i]], normal, fragPos, viewDir, albedo);
     }
-    
-    return (ambient + diffuse + specular);
+    return result;
 }
+#endif
 
 // calculates the color when using a spot light.
-vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo)
 {
-    vec3 ambient = vec3(0.0f);
-    vec3 diffuse = vec3(0.0f);
-    vec3 specular = vec3(0.0f);
-
     vec3 lightDir = normalize(light.position - fragPos);
     // diffuse shading
     float diff = max(dot(normal, lightDir), 0.0);
@@ -208,21 +370,44 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     float epsilon = light.cutOff - light.outerCutOff;
     float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
     // combine results
-    if(bUseTexture == true)
-    {
-        ambient = light.ambient * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-        specular = light.specular * spec * material.specularColor * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-    }
-    else
-    {
-        ambient = light.ambient * vec3(objectColor);
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(objectColor);
-        specular = light.specular * spec * material.specularColor * vec3(objectColor);
-    }
+    vec3 ambient = light.ambient * albedo;
+    vec3 diffuse = light.diffuse * diff * material.diffuseColor * albedo;
+    vec3 specular = light.specular * spec * material.specularColor * albedo;
     
     ambient *= attenuation * intensity;
     diffuse *= attenuation * intensity;
     specular *= attenuation * intensity;
-    return (ambient + diffuse + specular);
+    float shadow = 1.0;
+    if(bSpotShadow == true)
+    {
+        shadow = CalcShadow(spotShadowMap, spotShadowMatrix, normal, lightDir, 0.0002);
+    }
+    return (ambient + shadow * (diffuse + specular));
+}
+
+// calculates how much of a light reaches the fragment, 0 in full shadow.
+// Every tap of the 3x3 kernel is a hardware 2x2 percentage closer filter,
+// so the shadow edges fade out over a few texels.
+float CalcShadow(sampler2DShadow shadowMap, mat4 shadowMatrix, vec3 normal, vec3 lightDir, float bias)
+{
+    vec4 lightPosition = shadowMatrix * vec4(fragmentPosition, 1.0);
+    vec3 shadowCoordinate = lightPosition.xyz / lightPosition.w * 0.5 + 0.5;
+    // beyond the far plane of the light nothing casts a shadow
+    if(shadowCoordinate.z > 1.0)
+    {
+        return 1.0;
+    }
+    // surfaces at a grazing angle to the light need a larger bias
+    float depth = shadowCoordinate.z - bias * (2.0 - max(dot(normal, lightDir), 0.0));
+
+    vec2 texelSize = 1.0 / vec2(textureSize(shadowMap, 0));
+    float lit = 0.0;
+    for(int x = -1; x <= 1; x++)
+    {
+        for(int y = -1; y <= 1; y++)
+        {
+            lit += texture(shadowMap, vec3(shadowCoordinate.xy + vec2(x, y) * texelSize, depth));
+        }
+    }
+    return lit / 9.0;
 }
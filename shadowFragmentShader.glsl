@@ -0,0 +1,7 @@
+#version 330 core
+// depth-only pass of the shadow maps (see ShadowManager) - the frame buffer
+// has no color attachment, only the depth of the fragment is written
+
+void main()
+{
+}
@@ -0,0 +1,14 @@
+#version 330 core
+// depth-only pass of the shadow maps (see ShadowManager) - the vertex and
+// instance attributes are laid out as in vertexShader.glsl, only the
+// position and the model matrix are read
+layout (location = 0) in vec3 inVertexPosition;
+layout (location = 3) in mat4 inInstanceModel;
+
+// world space to the clip space of the light
+uniform mat4 lightMatrix;
+
+void main()
+{
+   gl_Position = lightMatrix * inInstanceModel * vec4(inVertexPosition, 1.0f);
+}
@@ -2,19 +2,38 @@
 layout (location = 0) in vec3 inVertexPosition;
 layout (location = 1) in vec3 inVertexNormal;
 layout (location = 2) in vec2 inTextureCoordinate;
+// per-instance values from the instance buffer (see ShapeMeshes)
+layout (location = 3) in mat4 inInstanceModel;
+layout (location = 7) in vec4 inInstanceColor;
+layout (location = 8) in vec2 inInstanceUVScale;
+layout (location = 9) in uint inInstanceMaterial;
+// texture array layer, the finest streamed in mip level in the high 16 bits
+layout (location = 10) in uint inInstanceTextureLayer;
 
 out vec3 fragmentPosition;
 out vec3 fragmentVertexNormal;
 out vec2 fragmentTextureCoordinate;
+out vec4 fragmentObjectColor;
+flat out uint fragmentMaterialIndex;
+flat out uint fragmentTextureLayer;
 
-uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
 void main()
 {
-   fragmentPosition = vec3(model * vec4(inVertexPosition, 1.0));
-   gl_Position = projection * view * model * vec4(inVertexPosition, 1.0f);
-   fragmentVertexNormal = mat3(transpose(inverse(model))) * inVertexNormal;
-   fragmentTextureCoordinate = inTextureCoordinate;
+#ifdef LIGHTING_PASS
+   // the deferred light pass draws one triangle covering the screen without
+   // any vertex buffer - the G-buffer holds the surface of every pixel
+   vec2 corner = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2));
+   gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+#else
+   fragmentPosition = vec3(inInstanceModel * vec4(inVertexPosition, 1.0));
+   gl_Position = projection * view * inInstanceModel * vec4(inVertexPosition, 1.0f);
+   fragmentVertexNormal = mat3(transpose(inverse(inInstanceModel))) * inVertexNormal;
+   fragmentTextureCoordinate = inTextureCoordinate * inInstanceUVScale;
+   fragmentObjectColor = inInstanceColor;
+   fragmentMaterialIndex = inInstanceMaterial;
+   fragmentTextureLayer = inInstanceTextureLayer;
+#endif
 }
\ No newline at end of file